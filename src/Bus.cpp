@@ -0,0 +1,419 @@
+#include <motors_roboteq_canopen/Bus.hpp>
+
+#include <stdexcept>
+
+using namespace std;
+using namespace motors_roboteq_canopen;
+
+/** Function codes of the COB-IDs of the predefined connection set that are
+ * sent by a node
+ */
+static const uint32_t PREDEFINED_FUNCTION_CODES[] = {
+    0x080, // EMCY
+    0x180, 0x280, 0x380, 0x480, // TPDO1-4
+    0x580, // SDO replies
+    0x700 // NMT error control (heartbeat)
+};
+
+/** Value of m_cobid_to_node for COB-IDs that are not routed yet */
+static const int8_t COBID_UNKNOWN = -1;
+
+/** Value of m_cobid_to_node for COB-IDs no driver decodes */
+static const int8_t COBID_UNROUTABLE = -2;
+
+Bus::Bus()
+    : m_cobid_to_node(COBID_COUNT, COBID_UNKNOWN) {
+}
+
+Bus::~Bus() {
+}
+
+void Bus::registerNode(
+    unique_ptr<canopen_master::StateMachine> state_machine,
+    unique_ptr<DriverBase> driver
+) {
+    int node_id = state_machine->nodeId;
+    if (node_id < 1 || node_id > 127) {
+        throw invalid_argument("invalid CANOpen node ID");
+    }
+    else if (getNodeIndex(node_id) != -1) {
+        throw invalid_argument("a driver already exists for this node ID");
+    }
+
+    int channel_count = driver->getChannelCount();
+    if (m_channel_count + channel_count > MAX_CHANNELS) {
+        throw invalid_argument("too many channels on this bus");
+    }
+
+    Node node;
+    node.state_machine = move(state_machine);
+    node.driver = move(driver);
+    node.first_channel = m_channel_count;
+    m_nodes.push_back(move(node));
+    m_channel_count += channel_count;
+
+    DriverBase& added = *m_nodes.back().driver;
+    m_factors_table.resize(m_channel_count);
+    for (int i = 0; i < channel_count; ++i) {
+        ChannelBase& channel = added.getChannel(i);
+        m_factors_table.set(m_channel_count - channel_count + i, channel.getFactors());
+        m_factors_versions.push_back(channel.getFactorsVersion());
+    }
+    m_raw_joint_states.resize(m_channel_count);
+    m_joint_states.resize(m_channel_count);
+    m_command_conversions.resize(m_channel_count);
+    m_command_values.resize(m_channel_count);
+    m_raw_commands.resize(m_channel_count);
+
+    for (auto function_code : PREDEFINED_FUNCTION_CODES) {
+        m_cobid_to_node[function_code + node_id] = m_nodes.size() - 1;
+    }
+}
+
+int Bus::getNodeIndex(int node_id) const {
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        if (m_nodes[i].state_machine->nodeId == node_id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void Bus::setCOBIDNode(uint32_t cob_id, int node_id) {
+    if (cob_id >= COBID_COUNT) {
+        throw invalid_argument("COB-ID out of range");
+    }
+
+    int node_index = getNodeIndex(node_id);
+    if (node_index == -1) {
+        throw invalid_argument("no driver for this node ID");
+    }
+    m_cobid_to_node[cob_id] = node_index;
+}
+
+size_t Bus::getDriverCount() const {
+    return m_nodes.size();
+}
+
+DriverBase& Bus::getDriver(int index) {
+    return *m_nodes.at(index).driver;
+}
+
+DriverBase& Bus::getDriverByNodeID(int node_id) {
+    int node_index = getNodeIndex(node_id);
+    if (node_index == -1) {
+        throw invalid_argument("no driver for this node ID");
+    }
+    return *m_nodes[node_index].driver;
+}
+
+int Bus::getChannelCount() const {
+    return m_channel_count;
+}
+
+int Bus::getChannelIndex(int node_id, int channel) const {
+    int node_index = getNodeIndex(node_id);
+    if (node_index == -1) {
+        throw invalid_argument("no driver for this node ID");
+    }
+
+    Node const& node = m_nodes[node_index];
+    if (channel < 0 || channel >= static_cast<int>(node.driver->getChannelCount())) {
+        throw invalid_argument("invalid channel index");
+    }
+    return node.first_channel + channel;
+}
+
+FactorsTable Bus::getFactorsTable() const {
+    FactorsTable table(m_channel_count);
+    for (auto const& node : m_nodes) {
+        DriverBase& driver = *node.driver;
+        for (size_t i = 0; i < driver.getChannelCount(); ++i) {
+            table.set(node.first_channel + i, driver.getChannel(i).getFactors());
+        }
+    }
+    return table;
+}
+
+void Bus::updateFactorsTable() {
+    for (auto const& node : m_nodes) {
+        DriverBase& driver = *node.driver;
+        for (size_t i = 0; i < driver.getChannelCount(); ++i) {
+            ChannelBase& channel = driver.getChannel(i);
+            uint32_t& version = m_factors_versions[node.first_channel + i];
+            if (version != channel.getFactorsVersion()) {
+                m_factors_table.set(node.first_channel + i, channel.getFactors());
+                version = channel.getFactorsVersion();
+            }
+        }
+    }
+}
+
+void Bus::readJointStates(base::JointState* states, uint64_t channels) {
+    updateFactorsTable();
+    for (auto const& node : m_nodes) {
+        DriverBase& driver = *node.driver;
+        for (size_t i = 0; i < driver.getChannelCount(); ++i) {
+            int index = node.first_channel + i;
+            if (channels & (1ULL << index)) {
+                m_raw_joint_states[index] = driver.getChannel(i).getRawJointState();
+            }
+            else {
+                m_raw_joint_states[index] = RawJointState();
+            }
+        }
+    }
+
+    m_factors_table.toJointStates(m_raw_joint_states.data(), m_joint_states.data());
+    for (int i = 0; i < m_channel_count; ++i) {
+        if (channels & (1ULL << i)) {
+            states[i] = m_joint_states[i];
+        }
+    }
+}
+
+/** The field of a joint command a conversion applies to */
+static float getJointCommandField(
+    JointCommandConversions conversion, base::JointState const& command
+) {
+    switch (conversion) {
+        case JOINT_COMMAND_CONVERSION_POWER_LEVEL:
+            return command.raw;
+        case JOINT_COMMAND_CONVERSION_RELATIVE_SPEED:
+            return command.speed;
+        case JOINT_COMMAND_CONVERSION_RELATIVE_POSITION:
+            return command.position;
+        case JOINT_COMMAND_CONVERSION_RELATIVE_TORQUE:
+            return command.effort;
+        default:
+            return 0;
+    }
+}
+
+void Bus::setJointCommands(vector<base::samples::Joints> const& commands) {
+    if (commands.size() != m_nodes.size()) {
+        throw invalid_argument(
+            "the number of joint commands does not match the number of drivers"
+        );
+    }
+
+    updateFactorsTable();
+    for (size_t n = 0; n < m_nodes.size(); ++n) {
+        Node const& node = m_nodes[n];
+        DriverBase& driver = *node.driver;
+        auto const& elements = commands[n].elements;
+        size_t element = 0;
+        for (size_t i = 0; i < driver.getChannelCount(); ++i) {
+            int index = node.first_channel + i;
+            ChannelBase& channel = driver.getChannel(i);
+            m_command_conversions[index] = JOINT_COMMAND_CONVERSION_NONE;
+            m_command_values[index] = 0;
+            if (channel.isIgnored()) {
+                continue;
+            }
+            else if (element == elements.size()) {
+                throw invalid_argument("too few elements in joint command");
+            }
+
+            JointCommandConversions conversion = channel.getJointCommandConversion();
+            m_command_conversions[index] = conversion;
+            m_command_values[index] =
+                getJointCommandField(conversion, elements[element]);
+            ++element;
+        }
+        if (element != elements.size()) {
+            throw invalid_argument("too many elements in joint command");
+        }
+    }
+
+    m_factors_table.fromJointCommands(
+        m_command_conversions.data(), m_command_values.data(), m_raw_commands.data()
+    );
+
+    for (size_t n = 0; n < m_nodes.size(); ++n) {
+        Node const& node = m_nodes[n];
+        DriverBase& driver = *node.driver;
+        auto const& elements = commands[n].elements;
+        size_t element = 0;
+        for (size_t i = 0; i < driver.getChannelCount(); ++i) {
+            int index = node.first_channel + i;
+            ChannelBase& channel = driver.getChannel(i);
+            if (channel.isIgnored()) {
+                continue;
+            }
+
+            if (m_command_conversions[index] == JOINT_COMMAND_CONVERSION_NONE) {
+                channel.setJointCommand(elements[element]);
+            }
+            else {
+                channel.setConvertedJointCommand(
+                    elements[element], m_raw_commands[index]
+                );
+            }
+            ++element;
+        }
+    }
+}
+
+BusLoad Bus::computeBusLoad(BusLoadModel const& model) const {
+    BusLoad load(model);
+    load.addSYNC();
+    for (auto const& node : m_nodes) {
+        node.driver->addToBusLoad(load);
+    }
+    return load;
+}
+
+vector<ScheduledFrame> Bus::getScheduledFrames(BusLoadModel const& model) const {
+    vector<ScheduledFrame> frames;
+    if (!model.sync_period.isNull()) {
+        ScheduledFrame sync;
+        sync.cob_id = 0x80;
+        sync.period = model.sync_period;
+        frames.push_back(sync);
+    }
+    for (auto const& node : m_nodes) {
+        auto node_frames = node.driver->getScheduledFrames(model);
+        frames.insert(frames.end(), node_frames.begin(), node_frames.end());
+    }
+    return frames;
+}
+
+void Bus::applyCOBIDs(
+    vector<ScheduledFrame> const& frames, vector<canbus::Message>& messages
+) {
+    forgetUnroutableCOBIDs();
+
+    // Disable all the PDOs that change before enabling any of them, see the
+    // method documentation
+    for (auto const& frame : frames) {
+        if (frame.pdo_index < 0) {
+            continue;
+        }
+
+        DriverBase& driver = getDriverByNodeID(frame.node_id);
+        for (auto const& pdo : driver.getConfiguredPDOs()) {
+            if (pdo.transmit == frame.transmit && pdo.index == frame.pdo_index &&
+                pdo.cob_id != frame.cob_id) {
+                driver.disablePDO(messages, frame.transmit, frame.pdo_index);
+            }
+        }
+    }
+
+    for (auto const& frame : frames) {
+        if (frame.pdo_index < 0) {
+            continue;
+        }
+
+        getDriverByNodeID(frame.node_id).setPDOCOBId(
+            frame.transmit, frame.pdo_index, frame.cob_id
+        );
+        if (frame.transmit) {
+            setCOBIDNode(frame.cob_id, frame.node_id);
+        }
+    }
+}
+
+DriverBase* Bus::process(canbus::Message const& message) {
+    if (message.can_id >= COBID_COUNT) {
+        return nullptr;
+    }
+
+    int node_index = m_cobid_to_node[message.can_id];
+    if (node_index < 0) {
+        node_index = routeTPDO(message.can_id);
+        if (node_index < 0) {
+            return nullptr;
+        }
+    }
+
+    Node const& node = m_nodes[node_index];
+    node.driver->process(message);
+    updateReadiness(node);
+    return node.driver.get();
+}
+
+int Bus::routeTPDO(uint32_t cob_id) {
+    uint64_t generation = 0;
+    for (auto const& node : m_nodes) {
+        generation += node.driver->getTPDODecoderGeneration();
+    }
+    if (generation != m_tpdo_decoder_generation) {
+        // Some TPDOs have been declared or removed since the misses were
+        // cached
+        forgetUnroutableCOBIDs();
+        m_tpdo_decoder_generation = generation;
+    }
+    else if (m_cobid_to_node[cob_id] == COBID_UNROUTABLE) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        if (m_nodes[i].driver->hasTPDODecoder(cob_id)) {
+            m_cobid_to_node[cob_id] = i;
+            return i;
+        }
+    }
+    m_cobid_to_node[cob_id] = COBID_UNROUTABLE;
+    return -1;
+}
+
+void Bus::forgetUnroutableCOBIDs() {
+    for (auto& node_index : m_cobid_to_node) {
+        if (node_index == COBID_UNROUTABLE) {
+            node_index = COBID_UNKNOWN;
+        }
+    }
+}
+
+void Bus::updateReadiness(Node const& node) {
+    DriverBase& driver = *node.driver;
+    int channel_count = driver.getChannelCount();
+    for (int i = 0; i < channel_count; ++i) {
+        uint64_t bit = 1ULL << (node.first_channel + i);
+        if (driver.getChannel(i).hasJointStateUpdate()) {
+            m_ready_channels |= bit;
+        }
+        else {
+            m_ready_channels &= ~bit;
+        }
+    }
+}
+
+uint64_t Bus::getReadyChannels() const {
+    return m_ready_channels;
+}
+
+bool Bus::areAllChannelsReady() const {
+    uint64_t all = (m_channel_count == MAX_CHANNELS) ?
+        ~0ULL : ((1ULL << m_channel_count) - 1);
+    return m_ready_channels == all;
+}
+
+void Bus::resetJointStateTracking() {
+    for (auto const& node : m_nodes) {
+        DriverBase& driver = *node.driver;
+        for (size_t i = 0; i < driver.getChannelCount(); ++i) {
+            driver.getChannel(i).resetJointStateTracking();
+        }
+    }
+
+    // Channels that expect no joint state updates (e.g. ignored channels)
+    // are complete right away. Since their node might not send anything,
+    // they would otherwise never be marked as ready
+    for (auto const& node : m_nodes) {
+        updateReadiness(node);
+    }
+}
+
+void Bus::getRPDOMessages(vector<canbus::Message>& messages) const {
+    for (auto const& node : m_nodes) {
+        node.driver->getRPDOMessages(messages);
+    }
+}
+
+vector<canbus::Message> Bus::getRPDOMessages() const {
+    vector<canbus::Message> messages;
+    getRPDOMessages(messages);
+    return messages;
+}
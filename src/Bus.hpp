@@ -0,0 +1,269 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_BUS_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_BUS_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <base/JointState.hpp>
+#include <base/samples/Joints.hpp>
+#include <canbus/Message.hpp>
+#include <canopen_master/StateMachine.hpp>
+#include <motors_roboteq_canopen/BusLoad.hpp>
+#include <motors_roboteq_canopen/DriverBase.hpp>
+#include <motors_roboteq_canopen/FactorsTable.hpp>
+
+namespace motors_roboteq_canopen {
+    /**
+     * Set of Roboteq controllers sharing a single CAN interface
+     *
+     * The bus owns one driver (Driver or DS402Driver) per CANOpen node, along
+     * with the node's state machine. Received messages are handed to the
+     * driver of the node they come from through a table indexed by COB-ID,
+     * which keeps the per-message cost independent of the number of
+     * controllers.
+     *
+     * The channels of all drivers are numbered globally, in the order the
+     * drivers have been added. The bus maintains a readiness bitset with one
+     * bit per channel, set when the channel's joint state is complete (see
+     * ChannelBase::hasJointStateUpdate).
+     */
+    class Bus {
+    public:
+        /** Maximum number of channels on a single bus, i.e. the size of the
+         * readiness bitset
+         */
+        static const int MAX_CHANNELS = 64;
+
+        /** Number of standard (11 bit) COB-IDs */
+        static const int COBID_COUNT = 2048;
+
+    private:
+        struct Node {
+            std::unique_ptr<canopen_master::StateMachine> state_machine;
+            std::unique_ptr<DriverBase> driver;
+            int first_channel;
+        };
+
+        std::vector<Node> m_nodes;
+
+        /** Index in m_nodes of the node using a given COB-ID, -1 if
+         * unknown or -2 if no driver decodes it
+         */
+        std::vector<int8_t> m_cobid_to_node;
+
+        /** Sum of the drivers' TPDO decoder generations when the unroutable
+         * COB-IDs of m_cobid_to_node have been determined
+         */
+        uint64_t m_tpdo_decoder_generation = 0;
+
+        int m_channel_count = 0;
+        uint64_t m_ready_channels = 0;
+
+        /** Factors of all channels, along with the channels' factors version
+         * they have been copied from
+         */
+        FactorsTable m_factors_table;
+        std::vector<uint32_t> m_factors_versions;
+
+        /** Per-channel buffers of readJointStates and setJointCommands */
+        std::vector<RawJointState> m_raw_joint_states;
+        std::vector<base::JointState> m_joint_states;
+        std::vector<JointCommandConversions> m_command_conversions;
+        std::vector<float> m_command_values;
+        std::vector<int32_t> m_raw_commands;
+
+        int getNodeIndex(int node_id) const;
+        void registerNode(
+            std::unique_ptr<canopen_master::StateMachine> state_machine,
+            std::unique_ptr<DriverBase> driver
+        );
+        void updateReadiness(Node const& node);
+        int routeTPDO(uint32_t cob_id);
+        void forgetUnroutableCOBIDs();
+        void updateFactorsTable();
+
+    public:
+        Bus();
+        ~Bus();
+
+        Bus(Bus const&) = delete;
+        Bus& operator=(Bus const&) = delete;
+
+        /** Create the driver for a new controller
+         *
+         * The driver's COB-IDs of the CANOpen predefined connection set (EMCY,
+         * TPDO1-4, SDO replies and heartbeat) are routed to it. The other
+         * TPDOs declared by the driver's setup methods are routed the first
+         * time a frame with their COB-ID is received.
+         *
+         * @tparam DriverT the driver type, either Driver or DS402Driver
+         * @throw std::invalid_argument if the node ID is already in use or
+         *   invalid, or if the bus would have more than MAX_CHANNELS
+         *   channels
+         */
+        template<typename DriverT>
+        DriverT& addDriver(int node_id, int channel_count) {
+            std::unique_ptr<canopen_master::StateMachine> state_machine(
+                new canopen_master::StateMachine(node_id)
+            );
+            std::unique_ptr<DriverT> driver(
+                new DriverT(*state_machine, channel_count)
+            );
+            DriverT& result = *driver;
+            registerNode(std::move(state_machine), std::move(driver));
+            return result;
+        }
+
+        /** Route messages with the given COB-ID to the given node
+         *
+         * This is needed only for COB-IDs outside of the predefined connection
+         * set that are not TPDOs declared by the setup methods
+         *
+         * @throw std::invalid_argument if the COB-ID is not a standard CAN ID
+         *   or if the node has not been added
+         */
+        void setCOBIDNode(uint32_t cob_id, int node_id);
+
+        /** Return how many drivers have been added */
+        size_t getDriverCount() const;
+
+        /** Return the N-th driver, in the order they have been added */
+        DriverBase& getDriver(int index);
+
+        /** Return the driver of the given CANOpen node
+         *
+         * @throw std::invalid_argument if there is no such node
+         */
+        DriverBase& getDriverByNodeID(int node_id);
+
+        /** Return the total number of channels on the bus */
+        int getChannelCount() const;
+
+        /** Return the bus-wide index of a driver's channel
+         *
+         * This is the index of the channel's bit in getReadyChannels
+         */
+        int getChannelIndex(int node_id, int channel) const;
+
+        /** Return the conversion factors of all the channels of the bus
+         *
+         * The table is indexed by the bus-wide channel index (see
+         * getChannelIndex), and allows to convert the values of all channels
+         * at once
+         */
+        FactorsTable getFactorsTable() const;
+
+        /** Convert the joint states of the given channels in a single pass
+         *
+         * The raw objects of the selected channels are converted together by
+         * a FactorsTable, which gives the same result as the channels'
+         * getJointState. The table follows the changes of the channels'
+         * factors.
+         *
+         * @param states the joint states, indexed by the bus-wide channel
+         *   index. Only the entries of the selected channels are written
+         * @param channels bitmask of the channels to convert, e.g.
+         *   getReadyChannels
+         */
+        void readJointStates(base::JointState* states, uint64_t channels);
+
+        /** Set the joint commands of all drivers, converting them in a single
+         * pass
+         *
+         * This is equivalent to calling DriverBase::setJointCommand on each
+         * driver, but converts the commands of all the channels that support
+         * it (see ChannelBase::getJointCommandConversion) together with a
+         * FactorsTable
+         *
+         * @param commands one command per driver, in the order the drivers
+         *   have been added
+         * @throw std::invalid_argument if the commands do not match the
+         *   drivers
+         * @throw InvalidJointCommand if a command lacks the field its
+         *   channel's control mode needs
+         */
+        void setJointCommands(std::vector<base::samples::Joints> const& commands);
+
+        /** Compute the expected load of the SYNC frame and of the PDOs
+         * configured on all drivers
+         *
+         * @see DriverBase::addToBusLoad
+         */
+        BusLoad computeBusLoad(BusLoadModel const& model) const;
+
+        /** The SYNC frame and the periodic PDOs configured on all drivers,
+         * for the response time analysis
+         *
+         * @see computeWorstCaseResponseTimes DriverBase::getScheduledFrames
+         */
+        std::vector<ScheduledFrame> getScheduledFrames(BusLoadModel const& model) const;
+
+        /** Apply a COB-ID assignment, such as the one computed by
+         * proposeCOBIDs
+         *
+         * The COB-IDs of the PDO frames are set on their drivers (see
+         * DriverBase::setPDOCOBId) and received TPDOs are routed to their
+         * node.
+         *
+         * An assignment usually moves COB-IDs from one node to another.
+         * Rolling it out node by node would let two nodes transmit with the
+         * same COB-ID in between, which causes bus errors. The rollout must
+         * therefore be done in two phases:
+         *
+         * 1. send the messages appended to \c messages, which disable every
+         *    PDO whose COB-ID changes, on all nodes, and wait for all of them
+         *    to be acknowledged
+         * 2. call the PDO setup methods of all drivers and send their
+         *    messages, which enable the PDOs with their new COB-IDs
+         *
+         * @param messages the vector to which the disable SDOs are appended
+         */
+        void applyCOBIDs(
+            std::vector<ScheduledFrame> const& frames,
+            std::vector<canbus::Message>& messages
+        );
+
+        /** Hand a received message to the driver of the node it comes from
+         *
+         * @return the driver that processed the message, or nullptr if its
+         *   COB-ID is not associated with any node
+         */
+        DriverBase* process(canbus::Message const& message);
+
+        /** Bitset of the channels whose joint state is complete
+         *
+         * Bit N is the channel whose global index is N
+         *
+         * @see getChannelIndex
+         */
+        uint64_t getReadyChannels() const;
+
+        /** Whether the joint states of all channels are complete */
+        bool areAllChannelsReady() const;
+
+        /** Reset the joint state tracking of all channels
+         *
+         * The readiness of all channels is then recomputed, which marks
+         * the channels that expect no updates (such as ignored channels)
+         * as ready
+         *
+         * @see ChannelBase::resetJointStateTracking
+         */
+        void resetJointStateTracking();
+
+        /** Append the RPDO messages of all drivers
+         *
+         * Reusing the same vector from one cycle to the next avoids allocating
+         * once the vector has grown to its steady-state size
+         *
+         * @see DriverBase::getRPDOMessages
+         */
+        void getRPDOMessages(std::vector<canbus::Message>& messages) const;
+
+        /** @overload */
+        std::vector<canbus::Message> getRPDOMessages() const;
+    };
+}
+
+#endif
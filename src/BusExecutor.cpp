@@ -0,0 +1,262 @@
+#include <motors_roboteq_canopen/BusExecutor.hpp>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <system_error>
+
+using namespace std;
+using namespace motors_roboteq_canopen;
+
+BusIO::~BusIO() {
+}
+
+BusExecutor::BusExecutor()
+    : m_running(false) {
+}
+
+BusExecutor::~BusExecutor() {
+    m_running = false;
+    for (auto& context : m_buses) {
+        if (context->thread.joinable()) {
+            context->thread.join();
+        }
+    }
+}
+
+Bus& BusExecutor::addBus(BusIO& io, int cpu) {
+    if (m_running) {
+        throw logic_error("cannot add a bus while the executor is running");
+    }
+
+    unique_ptr<BusContext> context(new BusContext());
+    context->io = &io;
+    context->cpu = cpu;
+    m_buses.push_back(move(context));
+    return m_buses.back()->bus;
+}
+
+size_t BusExecutor::getBusCount() const {
+    return m_buses.size();
+}
+
+Bus& BusExecutor::getBus(int index) {
+    return m_buses.at(index)->bus;
+}
+
+bool BusExecutor::isRunning() const {
+    if (!m_running) {
+        return false;
+    }
+    for (auto const& context : m_buses) {
+        if (!context->running) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BusExecutor::isBusRunning(int bus) const {
+    return m_buses.at(bus)->running;
+}
+
+void BusExecutor::start() {
+    if (m_running) {
+        throw logic_error("executor already running");
+    }
+
+    for (auto& context : m_buses) {
+        context->command_sizes = getCommandSizes(context->bus);
+    }
+
+    m_running = true;
+    for (auto& context : m_buses) {
+        BusContext* context_ptr = context.get();
+        context->running = true;
+        context->thread = thread([this, context_ptr]() { run(*context_ptr); });
+
+        if (context->cpu < 0) {
+            continue;
+        }
+
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(context->cpu, &cpuset);
+        int result = pthread_setaffinity_np(
+            context->thread.native_handle(), sizeof(cpuset), &cpuset
+        );
+        if (result != 0) {
+            stop();
+            throw system_error(
+                result, system_category(), "failed to pin the bus thread"
+            );
+        }
+    }
+}
+
+void BusExecutor::stop() {
+    m_running = false;
+    for (auto& context : m_buses) {
+        if (context->thread.joinable()) {
+            context->thread.join();
+        }
+    }
+
+    exception_ptr error;
+    for (auto& context : m_buses) {
+        if (context->error && !error) {
+            error = context->error;
+        }
+        context->error = exception_ptr();
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+}
+
+void BusExecutor::run(BusContext& context) {
+    try {
+        processLoop(context);
+    }
+    catch (...) {
+        context.error = current_exception();
+    }
+    context.running = false;
+}
+
+void BusExecutor::processLoop(BusContext& context) {
+    Bus& bus = context.bus;
+    vector<base::samples::Joints> command;
+    vector<canbus::Message> rpdos;
+
+    while (m_running) {
+        canbus::Message message;
+        if (context.io->read(message) && bus.process(message) &&
+            bus.areAllChannelsReady()) {
+            publishSnapshot(context);
+            bus.resetJointStateTracking();
+        }
+
+        if (context.has_command.load(memory_order_acquire)) {
+            {
+                lock_guard<mutex> lock(context.command_mutex);
+                command.swap(context.command);
+                context.has_command.store(false, memory_order_relaxed);
+            }
+            try {
+                applyCommand(context, command, rpdos);
+            }
+            catch (std::exception const& e) {
+                lock_guard<mutex> lock(context.command_mutex);
+                context.last_command_error = e.what();
+                context.rejected_commands.fetch_add(1, memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void BusExecutor::publishSnapshot(BusContext& context) {
+    Bus& bus = context.bus;
+    BusSnapshot snapshot;
+    snapshot.channel_count = bus.getChannelCount();
+
+    bus.readJointStates(snapshot.joint_states, ~0ULL);
+    for (size_t i = 0; i < bus.getDriverCount(); ++i) {
+        DriverBase& driver = bus.getDriver(i);
+        for (size_t j = 0; j < driver.getChannelCount(); ++j) {
+            base::Time newest = driver.getChannel(j).getJointStateTimestamps().newest;
+            if (newest > snapshot.time) {
+                snapshot.time = newest;
+            }
+        }
+    }
+    context.snapshot.write(snapshot);
+}
+
+void BusExecutor::applyCommand(
+    BusContext& context, vector<base::samples::Joints>& command,
+    vector<canbus::Message>& rpdos
+) {
+    Bus& bus = context.bus;
+    bus.setJointCommands(command);
+
+    rpdos.clear();
+    bus.getRPDOMessages(rpdos);
+    for (auto const& rpdo : rpdos) {
+        context.io->write(rpdo);
+    }
+}
+
+vector<size_t> BusExecutor::getCommandSizes(Bus& bus) {
+    vector<size_t> sizes;
+    for (size_t i = 0; i < bus.getDriverCount(); ++i) {
+        DriverBase& driver = bus.getDriver(i);
+        size_t size = 0;
+        for (size_t j = 0; j < driver.getChannelCount(); ++j) {
+            if (!driver.getChannel(j).isIgnored()) {
+                ++size;
+            }
+        }
+        sizes.push_back(size);
+    }
+    return sizes;
+}
+
+void BusExecutor::submitJointCommands(
+    int bus, vector<base::samples::Joints> const& commands
+) {
+    BusContext& context = *m_buses.at(bus);
+    // The drivers may only be read from the caller's thread before start()
+    vector<size_t> sizes = m_running ?
+        context.command_sizes : getCommandSizes(context.bus);
+    if (commands.size() != sizes.size()) {
+        throw invalid_argument(
+            "the number of joint commands does not match the number of drivers"
+        );
+    }
+    for (size_t i = 0; i < commands.size(); ++i) {
+        if (commands[i].elements.size() != sizes[i]) {
+            throw invalid_argument(
+                "the number of elements of a joint command does not match "
+                "the driver's channels"
+            );
+        }
+    }
+
+    lock_guard<mutex> lock(context.command_mutex);
+    context.command = commands;
+    context.has_command.store(true, memory_order_release);
+}
+
+uint64_t BusExecutor::getRejectedCommandCount(int bus) const {
+    return m_buses.at(bus)->rejected_commands.load(memory_order_relaxed);
+}
+
+string BusExecutor::getLastCommandError(int bus) const {
+    BusContext& context = *m_buses.at(bus);
+    lock_guard<mutex> lock(context.command_mutex);
+    return context.last_command_error;
+}
+
+uint32_t BusExecutor::readBusSnapshot(int bus, BusSnapshot& snapshot) const {
+    return m_buses.at(bus)->snapshot.read(snapshot);
+}
+
+base::samples::Joints BusExecutor::readJointStates() const {
+    base::samples::Joints joints;
+    for (auto const& context : m_buses) {
+        BusSnapshot snapshot;
+        if (!context->snapshot.read(snapshot)) {
+            snapshot.channel_count = context->bus.getChannelCount();
+        }
+        else if (joints.time.isNull() || snapshot.time < joints.time) {
+            joints.time = snapshot.time;
+        }
+
+        joints.elements.insert(
+            joints.elements.end(),
+            snapshot.joint_states, snapshot.joint_states + snapshot.channel_count
+        );
+    }
+    return joints;
+}
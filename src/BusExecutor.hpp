@@ -0,0 +1,224 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_BUSEXECUTOR_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_BUSEXECUTOR_HPP
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <base/Time.hpp>
+#include <base/JointState.hpp>
+#include <base/samples/Joints.hpp>
+#include <motors_roboteq_canopen/Bus.hpp>
+#include <motors_roboteq_canopen/Seqlock.hpp>
+
+namespace motors_roboteq_canopen {
+    /** Interface to the CAN interface of a bus, as used by BusExecutor
+     *
+     * Both methods are called only from the bus' own thread
+     */
+    struct BusIO {
+        virtual ~BusIO();
+
+        /** Wait for a message
+         *
+         * Implementations must return within a bounded time (typically a few
+         * milliseconds), as the executor checks whether it should stop
+         * between two calls
+         *
+         * @return false if no message has been received
+         */
+        virtual bool read(canbus::Message& message) = 0;
+
+        /** Send a message */
+        virtual void write(canbus::Message const& message) = 0;
+    };
+
+    /** Joint states of all the channels of a bus
+     *
+     * @see BusExecutor::readBusSnapshot
+     */
+    struct BusSnapshot {
+        /** Reception time of the newest field of the joint states
+         *
+         * @see ChannelBase::getJointStateTimestamps
+         */
+        base::Time time;
+
+        /** Number of valid entries in joint_states */
+        int channel_count = 0;
+
+        /** Joint state of each channel, indexed by Bus::getChannelIndex */
+        base::JointState joint_states[Bus::MAX_CHANNELS];
+    };
+
+    /**
+     * Runs the receive/transmit loop of several buses, one thread per bus
+     *
+     * Each bus is owned by the executor, and must be completely set up
+     * (drivers added and configured) before start() is called. From then
+     * on, the bus' thread is the only one allowed to touch its drivers.
+     *
+     * The thread processes the received messages. Each time the joint state
+     * of all channels of the bus is complete, it publishes a BusSnapshot and
+     * resets the tracking. Other threads read the snapshots with
+     * readBusSnapshot or readJointStates without ever blocking the bus
+     * threads.
+     *
+     * Joint commands are submitted with submitJointCommands. The bus thread
+     * picks the last submitted command up, applies it to the drivers and
+     * sends the resulting RPDOs. A command the drivers or the bus interface
+     * reject is counted and dropped, the bus thread keeps running.
+     */
+    class BusExecutor {
+        struct BusContext {
+            Bus bus;
+            BusIO* io = nullptr;
+            int cpu = -1;
+            std::thread thread;
+            /** Cleared when the thread exits, including on error */
+            std::atomic<bool> running;
+            std::exception_ptr error;
+
+            Seqlock<BusSnapshot> snapshot;
+
+            std::mutex command_mutex;
+            std::atomic<bool> has_command;
+            std::vector<base::samples::Joints> command;
+            /** Expected number of elements in each driver's command, filled
+             * by start()
+             */
+            std::vector<size_t> command_sizes;
+            std::atomic<uint64_t> rejected_commands;
+            /** Protected by command_mutex */
+            std::string last_command_error;
+
+            BusContext()
+                : running(false)
+                , has_command(false)
+                , rejected_commands(0) {}
+        };
+
+        std::vector<std::unique_ptr<BusContext>> m_buses;
+        std::atomic<bool> m_running;
+
+        void run(BusContext& context);
+        void processLoop(BusContext& context);
+        void publishSnapshot(BusContext& context);
+        void applyCommand(
+            BusContext& context, std::vector<base::samples::Joints>& command,
+            std::vector<canbus::Message>& rpdos
+        );
+        static std::vector<size_t> getCommandSizes(Bus& bus);
+
+    public:
+        BusExecutor();
+        ~BusExecutor();
+
+        BusExecutor(BusExecutor const&) = delete;
+        BusExecutor& operator=(BusExecutor const&) = delete;
+
+        /** Create a new bus
+         *
+         * @param io the interface used to communicate on the bus. It is not
+         *   owned by the executor
+         * @param cpu the CPU core the bus thread should be pinned on, or -1 to
+         *   not pin it
+         * @return the bus, to which drivers should be added before start() is
+         *   called
+         * @throw std::logic_error if the executor is running
+         */
+        Bus& addBus(BusIO& io, int cpu = -1);
+
+        /** Return how many buses have been added */
+        size_t getBusCount() const;
+
+        /** Return the N-th bus
+         *
+         * Once the executor is started, the bus must only be accessed from its
+         * own thread
+         */
+        Bus& getBus(int index);
+
+        /** Start one thread per bus
+         *
+         * @throw std::system_error if a thread could not be created or pinned
+         */
+        void start();
+
+        /** Stop and join all the bus threads
+         *
+         * If one of the threads stopped because of an exception, it is
+         * rethrown here
+         */
+        void stop();
+
+        /** Whether all the bus threads are running
+         *
+         * This turns false as soon as one of the threads stopped because of
+         * an exception. stop() must then be called to get the error
+         */
+        bool isRunning() const;
+
+        /** Whether the thread of the given bus is running */
+        bool isBusRunning(int bus) const;
+
+        /** Submit joint commands to the drivers of a bus
+         *
+         * This may be called from any thread. If a command has been submitted
+         * and not yet picked up by the bus thread, it is replaced.
+         *
+         * The number of commands and of elements in each command is checked
+         * here, against the channels that were not ignored when start() got
+         * called. Errors raised later by the drivers or while sending the
+         * RPDOs are reported by getRejectedCommandCount and
+         * getLastCommandError.
+         *
+         * @param commands one command per driver of the bus, in the order the
+         *   drivers have been added, as expected by DriverBase::setJointCommand
+         * @throw std::invalid_argument if the commands do not match the
+         *   drivers of the bus
+         */
+        void submitJointCommands(
+            int bus, std::vector<base::samples::Joints> const& commands
+        );
+
+        /** How many submitted commands the bus thread failed to apply or
+         * send
+         */
+        uint64_t getRejectedCommandCount(int bus) const;
+
+        /** The message of the last error that made the bus thread reject a
+         * command, or an empty string if none did
+         */
+        std::string getLastCommandError(int bus) const;
+
+        /** Copy the last snapshot published by the given bus
+         *
+         * This may be called from any thread
+         *
+         * @return the snapshot version, which is zero if nothing has been
+         *   published yet
+         */
+        uint32_t readBusSnapshot(int bus, BusSnapshot& snapshot) const;
+
+        /** Return the last published joint states of all buses
+         *
+         * The elements are ordered by bus, and then by channel index in the
+         * bus. The sample time is the time of the oldest of the bus
+         * snapshots. Buses that have not published anything yet report unknown
+         * joint states.
+         *
+         * The buses are read one after the other and are not synchronized
+         * with each other: the joint states of two buses may come from
+         * different cycles. Use readBusSnapshot to get the time of each bus'
+         * joint states.
+         */
+        base::samples::Joints readJointStates() const;
+    };
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include <motors_roboteq_canopen/BusLoad.hpp>
+#include <motors_roboteq_canopen/Exceptions.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using namespace canopen_master;
+using namespace motors_roboteq_canopen;
+
+int motors_roboteq_canopen::getWorstCaseFrameBits(int data_size) {
+    int data_bits = 8 * data_size;
+    return data_bits + 47 + (34 + data_bits - 1) / 4;
+}
+
+double BusLoadModel::getTPDOFrequency(
+    PDOCommunicationParameters const& parameters
+) const {
+    switch (parameters.transmission_mode) {
+        case PDO_SYNCHRONOUS: {
+            if (sync_period.isNull()) {
+                throw invalid_argument(
+                    "cannot compute the rate of a synchronous PDO without "
+                    "a SYNC period"
+                );
+            }
+            int sync_count = std::max<int>(parameters.sync_period, 1);
+            return 1.0 / (sync_count * sync_period.toSeconds());
+        }
+        case PDO_ASYNCHRONOUS:
+            if (!parameters.inhibit_time.isNull()) {
+                return 1.0 / parameters.inhibit_time.toSeconds();
+            }
+            else if (!parameters.timer_period.isNull()) {
+                return 1.0 / parameters.timer_period.toSeconds();
+            }
+            throw invalid_argument(
+                "cannot compute the rate of an asynchronous PDO with neither "
+                "an inhibit time nor a timer period"
+            );
+        default:
+            return 0;
+    }
+}
+
+double BusLoadModel::getRPDOFrequency() const {
+    if (!rpdo_period.isNull()) {
+        return 1.0 / rpdo_period.toSeconds();
+    }
+    else if (!sync_period.isNull()) {
+        return 1.0 / sync_period.toSeconds();
+    }
+    throw invalid_argument(
+        "cannot compute the RPDO rate with neither a RPDO nor a SYNC period"
+    );
+}
+
+BusLoad::BusLoad(BusLoadModel const& model)
+    : m_model(model) {
+    if (model.bitrate <= 0) {
+        throw invalid_argument("the bitrate must be strictly positive");
+    }
+}
+
+BusLoadModel const& BusLoad::getModel() const {
+    return m_model;
+}
+
+void BusLoad::add(int node_id, int data_size, double frequency) {
+    double bit_rate = getWorstCaseFrameBits(data_size) * frequency;
+    m_node_bit_rates[node_id] += bit_rate;
+    m_bit_rate += bit_rate;
+}
+
+void BusLoad::addSYNC() {
+    if (!m_model.sync_period.isNull()) {
+        add(0, 0, 1.0 / m_model.sync_period.toSeconds());
+    }
+}
+
+void BusLoad::addTPDO(
+    int node_id, int data_size, PDOCommunicationParameters const& parameters
+) {
+    add(node_id, data_size, m_model.getTPDOFrequency(parameters));
+}
+
+void BusLoad::addRPDO(int node_id, int data_size) {
+    add(node_id, data_size, m_model.getRPDOFrequency());
+}
+
+map<int, double> const& BusLoad::getNodeBitRates() const {
+    return m_node_bit_rates;
+}
+
+double BusLoad::getNodeBitRate(int node_id) const {
+    auto it = m_node_bit_rates.find(node_id);
+    if (it == m_node_bit_rates.end()) {
+        return 0;
+    }
+    return it->second;
+}
+
+double BusLoad::getNodeUtilization(int node_id) const {
+    return getNodeBitRate(node_id) / m_model.bitrate;
+}
+
+double BusLoad::getBitRate() const {
+    return m_bit_rate;
+}
+
+double BusLoad::getUtilization() const {
+    return m_bit_rate / m_model.bitrate;
+}
+
+void BusLoad::checkBudget(double max_utilization) const {
+    double utilization = getUtilization();
+    if (utilization > max_utilization) {
+        throw BusOverload(
+            "expected bus utilization of " + to_string(utilization * 100) +
+            "% exceeds the budget of " + to_string(max_utilization * 100) + "%"
+        );
+    }
+}
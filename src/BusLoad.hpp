@@ -0,0 +1,123 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_BUSLOAD_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_BUSLOAD_HPP
+
+#include <map>
+
+#include <base/Time.hpp>
+#include <canopen_master/PDOCommunicationParameters.hpp>
+
+namespace motors_roboteq_canopen {
+    /** Worst-case length in bits of a standard (11-bit ID) CAN data frame
+     *
+     * This is the frame itself plus the interframe space, with the maximum
+     * number of stuff bits:  8n + 47 + floor((34 + 8n - 1) / 4)
+     *
+     * @param data_size the payload size in bytes
+     */
+    int getWorstCaseFrameBits(int data_size);
+
+    /** Bus parameters needed to convert the configured PDOs into a bus load */
+    struct BusLoadModel {
+        /** The bus bitrate, in bit/s */
+        int bitrate = 1000000;
+
+        /** The SYNC period, or null if no SYNC is generated */
+        base::Time sync_period;
+
+        /** The period at which the RPDOs are sent. If null, they are assumed
+         * to be sent once per SYNC period
+         */
+        base::Time rpdo_period;
+
+        /** Return the rate at which a TPDO with the given parameters is sent,
+         * in frames per second
+         *
+         * Synchronous TPDOs are sent every \c sync_period SYNCs (every SYNC
+         * for acyclic ones). Asynchronous TPDOs are sent at the rate allowed
+         * by their inhibit time, or at their timer period if they have no
+         * inhibit time. RTR-only TPDOs are not counted.
+         *
+         * @throw std::invalid_argument if the rate cannot be bounded, i.e. for
+         *   synchronous TPDOs without a SYNC period and asynchronous TPDOs
+         *   with neither an inhibit time nor a timer period
+         */
+        double getTPDOFrequency(
+            canopen_master::PDOCommunicationParameters const& parameters
+        ) const;
+
+        /** Return the rate at which the RPDOs are sent, in frames per second
+         *
+         * @throw std::invalid_argument if neither rpdo_period nor sync_period
+         *   are set
+         */
+        double getRPDOFrequency() const;
+    };
+
+    /**
+     * Expected bus load, per node and in total
+     *
+     * All frames are counted at their worst-case length, see
+     * getWorstCaseFrameBits
+     */
+    class BusLoad {
+        BusLoadModel m_model;
+        std::map<int, double> m_node_bit_rates;
+        double m_bit_rate = 0;
+
+    public:
+        explicit BusLoad(BusLoadModel const& model);
+
+        BusLoadModel const& getModel() const;
+
+        /** Add a periodic frame
+         *
+         * @param node_id the node that sends the frame, zero for the master
+         * @param data_size the frame's payload size in bytes
+         * @param frequency how many times the frame is sent per second
+         */
+        void add(int node_id, int data_size, double frequency);
+
+        /** Add the SYNC frame, sent by the master at the model's SYNC period
+         *
+         * Does nothing if the model has no SYNC period
+         */
+        void addSYNC();
+
+        /** Add a TPDO sent by the given node */
+        void addTPDO(
+            int node_id, int data_size,
+            canopen_master::PDOCommunicationParameters const& parameters
+        );
+
+        /** Add an RPDO sent to the given node */
+        void addRPDO(int node_id, int data_size);
+
+        /** The nodes that have frames attributed to them, with their bit rate
+         * in bit/s
+         *
+         * RPDOs are attributed to the node that receives them
+         */
+        std::map<int, double> const& getNodeBitRates() const;
+
+        /** Bit rate of the frames of a given node, in bit/s */
+        double getNodeBitRate(int node_id) const;
+
+        /** Fraction of the bus bitrate used by the frames of a given node */
+        double getNodeUtilization(int node_id) const;
+
+        /** Total bit rate, in bit/s */
+        double getBitRate() const;
+
+        /** Fraction of the bus bitrate used by all frames */
+        double getUtilization() const;
+
+        /** Verify that the total utilization is within a budget
+         *
+         * @throw BusOverload if getUtilization() is greater than
+         *   max_utilization
+         */
+        void checkBudget(double max_utilization) const;
+    };
+}
+
+#endif
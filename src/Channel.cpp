@@ -10,6 +10,7 @@ using canopen_master::PDOMapping;
 Channel::Channel(Driver& driver, int channel)
     : m_driver(driver)
     , m_channel(channel) {
+    selectPolicies();
 }
 
 bool Channel::isIgnored() const {
@@ -21,27 +22,29 @@ canbus::Message Channel::queryMotorStop() const {
 }
 
 bool Channel::updateJointStateTracking(canopen_master::StateMachine::Update const& update) {
+    uint32_t tracking = 0;
     if (hasUpdatedObject<MotorAmps>(update)) {
-        m_joint_state_tracking |= UPDATED_MOTOR_AMPS;
+        tracking |= UPDATED_MOTOR_AMPS;
     }
     if (hasUpdatedObject<AppliedPowerLevel>(update)) {
-        m_joint_state_tracking |= UPDATED_POWER_LEVEL;
+        tracking |= UPDATED_POWER_LEVEL;
     }
     if (hasUpdatedObject<Feedback>(update)) {
-        m_joint_state_tracking |= UPDATED_FEEDBACK;
+        tracking |= UPDATED_FEEDBACK;
     }
     if (hasUpdatedObject<EncoderCounter>(update)) {
-        m_joint_state_tracking |= UPDATED_ENCODER;
+        tracking |= UPDATED_ENCODER;
     }
-    return hasJointStateUpdate();
+    return markJointStateUpdates(tracking, base::Time::now());
 }
 
-bool Channel::hasJointStateUpdate() const {
-    return (m_joint_state_tracking & m_joint_state_mask) == m_joint_state_mask;
-}
-
-void Channel::resetJointStateTracking() {
-    m_joint_state_tracking = 0;
+vector<ChannelBase::TrackedObject> Channel::getJointStateTrackedObjects() const {
+    return vector<TrackedObject> {
+        trackedObject<MotorAmps>(UPDATED_MOTOR_AMPS),
+        trackedObject<AppliedPowerLevel>(UPDATED_POWER_LEVEL),
+        trackedObject<Feedback>(UPDATED_FEEDBACK),
+        trackedObject<EncoderCounter>(UPDATED_ENCODER)
+    };
 }
 
 vector<PDOMapping> Channel::getJointStateTPDOMapping() const {
@@ -132,24 +135,59 @@ vector<canbus::Message> Channel::queryJointState() const
 }
 
 JointState Channel::getJointState() const {
-    JointState state;
-    if (isIgnored()) {
-        return state;
+    return (this->*m_joint_state_handler)();
+}
+
+JointState Channel::getJointStateIgnored() const {
+    return JointState();
+}
+
+RawJointState Channel::getRawJointState() const {
+    return (this->*m_raw_joint_state_handler)();
+}
+
+RawJointState Channel::getRawJointStateIgnored() const {
+    return RawJointState();
+}
+
+template<Channel::PositionObject Position, Channel::SpeedObject Speed>
+RawJointState Channel::getRawJointStateFor() const {
+    RawJointState raw;
+    raw.valid = true;
+    raw.current = get<MotorAmps>();
+    raw.power_level = get<AppliedPowerLevel>();
+
+    if (Position == POSITION_OBJECT_FEEDBACK) {
+        raw.position_unit = RawJointState::UNIT_RELATIVE;
+        raw.position = get<Feedback>();
+    }
+    else if (Position == POSITION_OBJECT_ENCODER) {
+        raw.position_unit = RawJointState::UNIT_ENCODER;
+        raw.position = get<EncoderCounter>();
     }
 
+    if (Speed == SPEED_OBJECT_FEEDBACK) {
+        raw.speed_unit = RawJointState::UNIT_RELATIVE;
+        raw.speed = get<Feedback>();
+    }
+
+    return raw;
+}
+
+template<Channel::PositionObject Position, Channel::SpeedObject Speed>
+JointState Channel::getJointStateFor() const {
+    JointState state;
     state.effort = m_factors.currentToTorqueSI(get<MotorAmps>());
     state.raw = m_factors.pwmToFloat(get<AppliedPowerLevel>());
 
-    auto position_object = getPositionObject();
-    if (position_object == POSITION_OBJECT_FEEDBACK) {
+    if (Position == POSITION_OBJECT_FEEDBACK) {
         state.position = m_factors.relativePositionToSI(get<Feedback>());
     }
-    else if (position_object == POSITION_OBJECT_ENCODER) {
+    else if (Position == POSITION_OBJECT_ENCODER) {
         state.position = m_factors.encoderToSI(get<EncoderCounter>());
     }
 
-    auto speed_object = getSpeedObject();
-    if (speed_object == SPEED_OBJECT_FEEDBACK) {
+    if (Speed == SPEED_OBJECT_FEEDBACK) {
         state.speed = m_factors.relativeSpeedToSI(get<Feedback>());
     }
 
@@ -177,6 +215,7 @@ void Channel::setControlMode(ControlModes mode) {
     m_control_mode = mode;
     m_joint_state_tracking = 0;
     m_joint_state_mask = getJointStateMask();
+    selectPolicies();
 }
 
 ControlModes Channel::getControlMode() const {
@@ -201,7 +240,7 @@ typename T::OBJECT_TYPE Channel::get() const {
 
 template<typename T>
 void Channel::set(typename T::OBJECT_TYPE value) {
-    return m_driver.set<T>(value, 0, m_channel);
+    return m_driver.setRPDOObject<T>(value, 0, m_channel);
 }
 
 template<typename T>
@@ -225,6 +264,11 @@ bool Channel::hasUpdatedObject(canopen_master::StateMachine::Update const& updat
     return update.hasUpdatedObject<T>(0, m_channel);
 }
 
+template<typename T>
+ChannelBase::TrackedObject Channel::trackedObject(uint32_t tracking_bit) const {
+    return TrackedObject { T::OBJECT_ID, T::OBJECT_SUB_ID + m_channel, tracking_bit };
+}
+
 vector<PDOMapping> Channel::getJointCommandRPDOMapping() const {
     vector<PDOMapping> mappings;
     if (isIgnored() || m_control_mode == CONTROL_NONE) {
@@ -242,53 +286,169 @@ base::JointState Channel::getJointCommand() const {
 }
 
 void Channel::setJointCommand(base::JointState const& cmd) {
+    (this->*m_joint_command_handler)(cmd);
+}
+
+vector<canbus::Message> Channel::queryJointCommandDownload() const {
+    if (isIgnored() || m_control_mode == CONTROL_NONE) {
+        return vector<canbus::Message>();
+    }
+
+    return vector<canbus::Message>{queryDownload<SetCommand>()};
+}
+
+void Channel::setJointStatePositionSource(JointStatePositionSources source) {
+    m_joint_state_position_source = source;
+    m_joint_state_tracking = 0;
+    m_joint_state_mask = getJointStateMask();
+    selectPolicies();
+}
+
+/** Conversion of the joint command into the SetCommand object, for each
+ * control mode
+ */
+template<ControlModes Mode> struct CommandPolicy;
+
+template<> struct CommandPolicy<CONTROL_OPEN_LOOP> {
+    static const JointState::MODE FIELD = JointState::RAW;
+    static const JointCommandConversions CONVERSION =
+        JOINT_COMMAND_CONVERSION_POWER_LEVEL;
+    static int32_t convert(Factors const&, float raw) {
+        return Factors::clamp1000(raw * 1000);
+    }
+};
+
+template<> struct CommandPolicy<CONTROL_SPEED> {
+    static const JointState::MODE FIELD = JointState::SPEED;
+    static const JointCommandConversions CONVERSION =
+        JOINT_COMMAND_CONVERSION_RELATIVE_SPEED;
+    static int32_t convert(Factors const& factors, double speed) {
+        return factors.relativeSpeedFromSI(speed);
+    }
+};
+
+template<> struct CommandPolicy<CONTROL_POSITION> {
+    static const JointState::MODE FIELD = JointState::POSITION;
+    static const JointCommandConversions CONVERSION =
+        JOINT_COMMAND_CONVERSION_RELATIVE_POSITION;
+    static int32_t convert(Factors const& factors, double position) {
+        return factors.relativePositionFromSI(position);
+    }
+};
+
+template<> struct CommandPolicy<CONTROL_TORQUE> {
+    static const JointState::MODE FIELD = JointState::EFFORT;
+    static const JointCommandConversions CONVERSION =
+        JOINT_COMMAND_CONVERSION_RELATIVE_TORQUE;
+    static int32_t convert(Factors const& factors, double torque) {
+        return factors.relativeTorqueFromSI(torque);
+    }
+};
+
+template<ControlModes Mode>
+void Channel::setJointCommandFor(base::JointState const& cmd) {
+    typedef CommandPolicy<Mode> Policy;
+    double value = validateField(Policy::FIELD, cmd);
+    set<SetCommand>(Policy::convert(m_factors, value));
+    m_current_command = cmd;
+}
+
+void Channel::setJointCommandWithoutControl(base::JointState const& cmd) {
+    m_current_command = cmd;
+}
+
+void Channel::setJointCommandUnsupported(base::JointState const&) {
+    throw invalid_argument("unsupported operation mode");
+}
+
+JointCommandConversions Channel::getJointCommandConversion() const {
+    return m_joint_command_conversion;
+}
+
+void Channel::setConvertedJointCommand(base::JointState const& cmd, int32_t raw) {
+    (this->*m_converted_joint_command_handler)(cmd, raw);
+}
+
+template<ControlModes Mode>
+void Channel::setConvertedJointCommandFor(base::JointState const& cmd, int32_t raw) {
+    validateField(CommandPolicy<Mode>::FIELD, cmd);
+    set<SetCommand>(raw);
+    m_current_command = cmd;
+}
+
+void Channel::setConvertedJointCommandUnsupported(base::JointState const&, int32_t) {
+    throw logic_error("the joint command of this channel is not converted by batch");
+}
+
+template<ControlModes Mode>
+void Channel::selectCommandPolicy() {
+    m_joint_command_handler = &Channel::setJointCommandFor<Mode>;
+    m_converted_joint_command_handler = &Channel::setConvertedJointCommandFor<Mode>;
+    m_joint_command_conversion = CommandPolicy<Mode>::CONVERSION;
+}
+
+template<Channel::PositionObject Position, Channel::SpeedObject Speed>
+void Channel::selectJointStatePolicy() {
+    m_joint_state_handler = &Channel::getJointStateFor<Position, Speed>;
+    m_raw_joint_state_handler = &Channel::getRawJointStateFor<Position, Speed>;
+}
+
+void Channel::selectPolicies() {
+    m_converted_joint_command_handler = &Channel::setConvertedJointCommandUnsupported;
+    m_joint_command_conversion = JOINT_COMMAND_CONVERSION_NONE;
     switch (m_control_mode) {
         case CONTROL_IGNORED:
         case CONTROL_NONE:
+            m_joint_command_handler = &Channel::setJointCommandWithoutControl;
             break;
-
-        case CONTROL_OPEN_LOOP: {
-            float raw = validateField(JointState::RAW, cmd);
-            set<SetCommand>(Factors::clamp1000(raw * 1000));
+        case CONTROL_OPEN_LOOP:
+            selectCommandPolicy<CONTROL_OPEN_LOOP>();
             break;
-        }
-
         case CONTROL_SPEED:
-        case CONTROL_SPEED_POSITION: {
-            double speed = validateField(JointState::SPEED, cmd);
-            set<SetCommand>(m_factors.relativeSpeedFromSI(speed));
+        case CONTROL_SPEED_POSITION:
+            selectCommandPolicy<CONTROL_SPEED>();
             break;
-        }
-
         case CONTROL_PROFILED_POSITION:
-        case CONTROL_POSITION: {
-            double position = validateField(JointState::POSITION, cmd);
-            set<SetCommand>(m_factors.relativePositionFromSI(position));
+        case CONTROL_POSITION:
+            selectCommandPolicy<CONTROL_POSITION>();
             break;
-        }
-
-        case CONTROL_TORQUE: {
-            double torque = validateField(JointState::EFFORT, cmd);
-            set<SetCommand>(m_factors.relativeTorqueFromSI(torque));
+        case CONTROL_TORQUE:
+            selectCommandPolicy<CONTROL_TORQUE>();
             break;
-        }
         default:
-            throw invalid_argument("unsupported operation mode");
+            m_joint_command_handler = &Channel::setJointCommandUnsupported;
     }
 
-    m_current_command = cmd;
-}
-
-vector<canbus::Message> Channel::queryJointCommandDownload() const {
-    if (isIgnored() || m_control_mode == CONTROL_NONE) {
-        return vector<canbus::Message>();
+    if (isIgnored()) {
+        m_joint_state_handler = &Channel::getJointStateIgnored;
+        m_raw_joint_state_handler = &Channel::getRawJointStateIgnored;
+        return;
     }
 
-    return vector<canbus::Message>{queryDownload<SetCommand>()};
-}
-
-void Channel::setJointStatePositionSource(JointStatePositionSources source) {
-    m_joint_state_position_source = source;
-    m_joint_state_tracking = 0;
-    m_joint_state_mask = getJointStateMask();
+    bool speed = (getSpeedObject() == SPEED_OBJECT_FEEDBACK);
+    switch (getPositionObject()) {
+        case POSITION_OBJECT_FEEDBACK:
+            if (speed) {
+                selectJointStatePolicy<POSITION_OBJECT_FEEDBACK, SPEED_OBJECT_FEEDBACK>();
+            }
+            else {
+                selectJointStatePolicy<POSITION_OBJECT_FEEDBACK, SPEED_OBJECT_NONE>();
+            }
+            break;
+        case POSITION_OBJECT_ENCODER:
+            if (speed) {
+                selectJointStatePolicy<POSITION_OBJECT_ENCODER, SPEED_OBJECT_FEEDBACK>();
+            }
+            else {
+                selectJointStatePolicy<POSITION_OBJECT_ENCODER, SPEED_OBJECT_NONE>();
+            }
+            break;
+        default:
+            if (speed) {
+                selectJointStatePolicy<POSITION_OBJECT_NONE, SPEED_OBJECT_FEEDBACK>();
+            }
+            else {
+                selectJointStatePolicy<POSITION_OBJECT_NONE, SPEED_OBJECT_NONE>();
+            }
+    }
 }
\ No newline at end of file
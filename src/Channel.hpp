@@ -49,6 +49,9 @@ namespace motors_roboteq_canopen {
         template<typename T>
         bool hasUpdatedObject(canopen_master::StateMachine::Update const& update) const;
 
+        template<typename T>
+        TrackedObject trackedObject(uint32_t tracking_bit) const;
+
         enum SpeedObject {
             SPEED_OBJECT_NONE,
             SPEED_OBJECT_FEEDBACK
@@ -84,13 +87,72 @@ namespace motors_roboteq_canopen {
         bool jointStateNeedsEncoder() const;
         bool jointStateNeedsFeedback() const;
 
-        uint32_t m_joint_state_tracking = 0;
-        uint32_t m_joint_state_mask = 0;
         uint32_t getJointStateMask() const;
 
         uint32_t m_analog_input_mask = 0;
         uint32_t getAnalogInputMask() const;
 
+        typedef void (Channel::*JointCommandHandler)(base::JointState const& cmd);
+        typedef void (Channel::*ConvertedJointCommandHandler)(
+            base::JointState const& cmd, int32_t raw
+        );
+        typedef base::JointState (Channel::*JointStateHandler)() const;
+        typedef RawJointState (Channel::*RawJointStateHandler)() const;
+
+        /** Implementation of setJointCommand for the current control mode
+         *
+         * @see selectPolicies
+         */
+        JointCommandHandler m_joint_command_handler;
+
+        /** Implementation of setConvertedJointCommand for the current control
+         * mode, along with the conversion it expects
+         *
+         * @see selectPolicies
+         */
+        ConvertedJointCommandHandler m_converted_joint_command_handler;
+        JointCommandConversions m_joint_command_conversion;
+
+        /** Implementation of getJointState and getRawJointState for the
+         * current control mode and joint state position source
+         *
+         * @see selectPolicies
+         */
+        JointStateHandler m_joint_state_handler;
+        RawJointStateHandler m_raw_joint_state_handler;
+
+        /** Select the command and joint state implementations matching the
+         * current configuration
+         *
+         * They are specialized at compile time for each configuration, so
+         * that the per-cycle paths do not have to test it
+         */
+        void selectPolicies();
+
+        template<ControlModes Mode>
+        void selectCommandPolicy();
+        template<PositionObject Position, SpeedObject Speed>
+        void selectJointStatePolicy();
+
+        template<ControlModes Mode>
+        void setJointCommandFor(base::JointState const& cmd);
+        void setJointCommandWithoutControl(base::JointState const& cmd);
+        void setJointCommandUnsupported(base::JointState const& cmd);
+
+        template<ControlModes Mode>
+        void setConvertedJointCommandFor(base::JointState const& cmd, int32_t raw);
+        void setConvertedJointCommandUnsupported(
+            base::JointState const& cmd, int32_t raw
+        );
+
+        template<PositionObject Position, SpeedObject Speed>
+        base::JointState getJointStateFor() const;
+        base::JointState getJointStateIgnored() const;
+
+        template<PositionObject Position, SpeedObject Speed>
+        RawJointState getRawJointStateFor() const;
+        RawJointState getRawJointStateIgnored() const;
+
     public:
         bool isIgnored() const;
 
@@ -103,6 +165,9 @@ namespace motors_roboteq_canopen {
         /** Get the channel's joint state */
         base::JointState getJointState() const;
 
+        /** Get the raw objects getJointState converts */
+        RawJointState getRawJointState() const;
+
         /** Add the joint state object to the PDO mapping */
         std::vector<canopen_master::PDOMapping> getJointStateTPDOMapping() const;
 
@@ -125,6 +190,14 @@ namespace motors_roboteq_canopen {
         /** Returns the last joint command set */
         base::JointState getJointCommand() const;
 
+        /** The conversion setJointCommand applies in the current control
+         * mode
+         */
+        JointCommandConversions getJointCommandConversion() const;
+
+        /** Set the command object from a value converted beforehand */
+        void setConvertedJointCommand(base::JointState const& cmd, int32_t raw);
+
         /** Return the SDO messages that would update the current command
          */
         std::vector<canbus::Message> queryJointCommandDownload() const;
@@ -140,16 +213,8 @@ namespace motors_roboteq_canopen {
          */
         bool updateJointStateTracking(canopen_master::StateMachine::Update const& update);
 
-        /** Whether all fields necessary for getJointState have been updated since
-         * the last call to resetJointStateTracking
-         *
-         * This assumes that you call updateJointStateTracking with the update
-         * call
-         */
-        bool hasJointStateUpdate() const;
-
-        /** Reset the internal tracking state of updateJointStateTracking */
-        void resetJointStateTracking();
+        /** The objects tracked by updateJointStateTracking */
+        std::vector<TrackedObject> getJointStateTrackedObjects() const;
 
         /** Change the data source for the joint state position field
          *
@@ -7,4 +7,74 @@ ChannelBase::~ChannelBase() {
 
 void ChannelBase::setFactors(Factors const& factors) {
     m_factors = factors;
+    ++m_factors_version;
+}
+
+Factors const& ChannelBase::getFactors() const {
+    return m_factors;
+}
+
+uint32_t ChannelBase::getFactorsVersion() const {
+    return m_factors_version;
+}
+
+bool ChannelBase::markJointStateUpdates(
+    uint32_t tracking_bits, base::Time const& time
+) {
+    for (int i = 0; i < MAX_TRACKED_OBJECTS; ++i) {
+        if (tracking_bits & (1 << i)) {
+            m_joint_state_times[i] = time;
+        }
+    }
+
+    m_joint_state_generation_tracking |= tracking_bits;
+    if (m_joint_state_mask && (m_joint_state_generation_tracking &
+        m_joint_state_mask) == m_joint_state_mask) {
+        ++m_joint_state_generation;
+        m_joint_state_generation_tracking = 0;
+    }
+
+    bool was_complete = hasJointStateUpdate();
+    m_joint_state_tracking |= tracking_bits;
+    bool complete = hasJointStateUpdate();
+    if (complete && !was_complete && m_joint_state_listener) {
+        m_joint_state_listener->jointStateCompleted(*this, getJointState());
+    }
+    return complete;
+}
+
+bool ChannelBase::hasJointStateUpdate() const {
+    return (m_joint_state_tracking & m_joint_state_mask) == m_joint_state_mask;
+}
+
+void ChannelBase::resetJointStateTracking() {
+    m_joint_state_tracking = 0;
+}
+
+uint64_t ChannelBase::getJointStateGeneration() const {
+    return m_joint_state_generation;
+}
+
+void ChannelBase::setJointStateListener(JointStateListener* listener) {
+    m_joint_state_listener = listener;
+}
+
+JointStateTimestamps ChannelBase::getJointStateTimestamps() const {
+    JointStateTimestamps timestamps;
+    bool first = true;
+    for (int i = 0; i < MAX_TRACKED_OBJECTS; ++i) {
+        if (!(m_joint_state_mask & (1 << i))) {
+            continue;
+        }
+
+        base::Time const& time = m_joint_state_times[i];
+        if (first || time < timestamps.oldest) {
+            timestamps.oldest = time;
+        }
+        if (first || time > timestamps.newest) {
+            timestamps.newest = time;
+        }
+        first = false;
+    }
+    return timestamps;
 }
\ No newline at end of file
@@ -4,23 +4,61 @@
 #include <vector>
 
 #include <base/JointState.hpp>
+#include <base/Time.hpp>
 #include <canopen_master/PDOMapping.hpp>
 #include <canopen_master/StateMachine.hpp>
 #include <motors_roboteq_canopen/Objects.hpp>
 #include <motors_roboteq_canopen/Factors.hpp>
 #include <motors_roboteq_canopen/Exceptions.hpp>
+#include <motors_roboteq_canopen/Listeners.hpp>
 
 namespace motors_roboteq_canopen {
     class DS402Driver;
 
+    /** Reception times of the objects that make up a joint state
+     *
+     * @see ChannelBase::getJointStateTimestamps
+     */
+    struct JointStateTimestamps {
+        /** Reception time of the oldest field of the joint state */
+        base::Time oldest;
+        /** Reception time of the newest field of the joint state */
+        base::Time newest;
+    };
+
     /**
      * Control of a single controller channel
      */
     class ChannelBase {
     protected:
         Factors m_factors;
+        uint32_t m_factors_version = 0;
+
+        /** Maximum number of objects a channel may track */
+        static const int MAX_TRACKED_OBJECTS = 8;
+
+        uint32_t m_joint_state_tracking = 0;
+        uint32_t m_joint_state_mask = 0;
+        base::Time m_joint_state_times[MAX_TRACKED_OBJECTS];
+
+        /** Fields received since the last joint state generation */
+        uint32_t m_joint_state_generation_tracking = 0;
+        uint64_t m_joint_state_generation = 0;
+
+        JointStateListener* m_joint_state_listener = nullptr;
 
     public:
+        /** An object whose reception is tracked to determine whether the
+         * joint state has been fully updated
+         *
+         * @see getJointStateTrackedObjects
+         */
+        struct TrackedObject {
+            int object_id;
+            int sub_id;
+            uint32_t tracking_bit;
+        };
+
         virtual ~ChannelBase();
 
         /** Set conversion factors for the given channel
@@ -30,6 +68,16 @@ namespace motors_roboteq_canopen {
          */
         virtual void setFactors(Factors const& factors);
 
+        /** Return the conversion factors set with setFactors */
+        Factors const& getFactors() const;
+
+        /** Number of times setFactors has been called
+         *
+         * It lets users of copies of the factors, such as FactorsTable, tell
+         * when they are stale
+         */
+        uint32_t getFactorsVersion() const;
+
         /** Whether this channel should simply be ignored by the rest of the system
          */
         virtual bool isIgnored() const = 0;
@@ -40,6 +88,13 @@ namespace motors_roboteq_canopen {
         /** Get the channel's joint state */
         virtual base::JointState getJointState() const = 0;
 
+        /** Get the raw objects getJointState converts
+         *
+         * Converting them with FactorsTable::toJointStates gives the result of
+         * getJointState
+         */
+        virtual RawJointState getRawJointState() const = 0;
+
         /** Add the joint state object to the PDO mapping */
         virtual std::vector<canopen_master::PDOMapping>
             getJointStateTPDOMapping() const = 0;
@@ -50,6 +105,28 @@ namespace motors_roboteq_canopen {
         /** Returns the last joint command set */
         virtual base::JointState getJointCommand() const = 0;
 
+        /** The conversion setJointCommand applies in the current
+         * configuration
+         *
+         * @see setConvertedJointCommand
+         */
+        virtual JointCommandConversions getJointCommandConversion() const = 0;
+
+        /** Set the command objects from a value converted beforehand
+         *
+         * This does what setJointCommand does, but uses the given value
+         * instead of converting the command's field itself
+         *
+         * @param cmd the joint command, validated as setJointCommand does
+         * @param raw the command's field, converted as
+         *   getJointCommandConversion says
+         * @throw std::logic_error if getJointCommandConversion is
+         *   JOINT_COMMAND_CONVERSION_NONE
+         */
+        virtual void setConvertedJointCommand(
+            base::JointState const& cmd, int32_t raw
+        ) = 0;
+
         /** Return the SDO messages that would update the current command
          */
         virtual std::vector<canbus::Message> queryJointCommandDownload() const = 0;
@@ -68,16 +145,61 @@ namespace motors_roboteq_canopen {
             canopen_master::StateMachine::Update const& update
         ) = 0;
 
+        /** The objects whose reception updateJointStateTracking tracks, along
+         * with the tracking bit each of them sets
+         *
+         * The list does not depend on the channel configuration. DriverBase
+         * uses it to build its object-to-tracking dispatch table
+         */
+        virtual std::vector<TrackedObject> getJointStateTrackedObjects() const = 0;
+
+        /** Mark joint state fields as received
+         *
+         * @param tracking_bits an OR-ed set of tracking bits, as returned by
+         *        getJointStateTrackedObjects
+         * @param time the reception time of the fields
+         * @return true if all expected fields have been received
+         * @see updateJointStateTracking
+         */
+        bool markJointStateUpdates(uint32_t tracking_bits, base::Time const& time);
+
+        /** Return the reception time of the oldest and newest fields that make
+         * up the current joint state
+         *
+         * Only the fields needed by getJointState in the current configuration
+         * are considered. Fields that were never received have a null time.
+         */
+        JointStateTimestamps getJointStateTimestamps() const;
+
         /** Whether all fields necessary for getJointState have been updated since
          * the last call to resetJointStateTracking
          *
          * This assumes that you call updateJointStateTracking with the update
          * call
          */
-        virtual bool hasJointStateUpdate() const = 0;
+        bool hasJointStateUpdate() const;
 
         /** Reset the internal tracking state of updateJointStateTracking */
-        virtual void resetJointStateTracking() = 0;
+        void resetJointStateTracking();
+
+        /** How many times all fields necessary for getJointState have been
+         * updated
+         *
+         * The generation is incremented each time every expected field has
+         * been received since the previous increment. Unlike
+         * hasJointStateUpdate, it does not depend on resetJointStateTracking,
+         * which lets a reader detect each new joint state without changing
+         * the tracking other readers rely on.
+         */
+        uint64_t getJointStateGeneration() const;
+
+        /** Register an object that will be notified when the joint state gets
+         * completed
+         *
+         * The listener is not owned by the channel. Set to nullptr to remove
+         * it.
+         */
+        void setJointStateListener(JointStateListener* listener);
     };
 }
 
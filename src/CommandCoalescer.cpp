@@ -0,0 +1,95 @@
+#include <motors_roboteq_canopen/CommandCoalescer.hpp>
+#include <motors_roboteq_canopen/DriverBase.hpp>
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+using namespace motors_roboteq_canopen;
+
+CommandCoalescer::CommandCoalescer(CoalescingPolicy policy)
+    : m_policy(policy) {
+}
+
+CoalescingPolicy CommandCoalescer::getPolicy() const {
+    return m_policy;
+}
+
+void CommandCoalescer::push(base::samples::Joints const& sample) {
+    lock_guard<mutex> lock(m_mutex);
+    if (m_sample_count != 0 &&
+        sample.elements.size() != m_pending.elements.size()) {
+        throw invalid_argument(
+            "joint command size differs from the previous samples"
+        );
+    }
+    reduce(sample);
+    ++m_sample_count;
+}
+
+void CommandCoalescer::reduce(base::samples::Joints const& sample) {
+    if (m_policy == COALESCE_LATEST || m_sample_count == 0) {
+        m_pending = sample;
+        if (m_policy == COALESCE_MEAN) {
+            m_field_counts.resize(sample.elements.size() * FIELD_COUNT);
+            for (size_t i = 0; i < sample.elements.size(); ++i) {
+                for (int field = 0; field < FIELD_COUNT; ++field) {
+                    double value = sample.elements[i].getField(field);
+                    m_field_counts[i * FIELD_COUNT + field] =
+                        base::isUnknown(value) ? 0 : 1;
+                }
+            }
+        }
+        return;
+    }
+
+    m_pending.time = sample.time;
+    m_pending.names = sample.names;
+    for (size_t i = 0; i < sample.elements.size(); ++i) {
+        base::JointState& pending = m_pending.elements[i];
+        for (int field = 0; field < FIELD_COUNT; ++field) {
+            double value = sample.elements[i].getField(field);
+            if (base::isUnknown(value)) {
+                continue;
+            }
+
+            double current = pending.getField(field);
+            if (base::isUnknown(current)) {
+                current = 0;
+            }
+
+            if (m_policy == COALESCE_MEAN) {
+                int& count = m_field_counts[i * FIELD_COUNT + field];
+                ++count;
+                pending.setField(field, current + (value - current) / count);
+            }
+            else if (std::fabs(value) >= std::fabs(current)) {
+                pending.setField(field, value);
+            }
+        }
+    }
+}
+
+size_t CommandCoalescer::getPendingSampleCount() const {
+    lock_guard<mutex> lock(m_mutex);
+    return m_sample_count;
+}
+
+bool CommandCoalescer::take(base::samples::Joints& command) {
+    lock_guard<mutex> lock(m_mutex);
+    if (m_sample_count == 0) {
+        return false;
+    }
+
+    std::swap(command, m_pending);
+    m_sample_count = 0;
+    return true;
+}
+
+bool CommandCoalescer::apply(DriverBase& driver) {
+    if (!take(m_applied)) {
+        return false;
+    }
+    driver.setJointCommand(m_applied);
+    return true;
+}
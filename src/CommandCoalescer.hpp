@@ -0,0 +1,86 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_COMMANDCOALESCER_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_COMMANDCOALESCER_HPP
+
+#include <mutex>
+#include <vector>
+
+#include <base/samples/Joints.hpp>
+
+namespace motors_roboteq_canopen {
+    class DriverBase;
+
+    /** How CommandCoalescer reduces the samples it receives within a cycle */
+    enum CoalescingPolicy {
+        /** Keep the last sample */
+        COALESCE_LATEST,
+        /** Average each field over the samples in which it is set */
+        COALESCE_MEAN,
+        /** Keep, for each field, the value with the largest magnitude */
+        COALESCE_MAX_MAGNITUDE
+    };
+
+    /**
+     * Decouples high-rate joint command producers from the bus cycle
+     *
+     * Producers call push() at their own rate, which only reduces the sample
+     * into the pending command. Once per bus cycle, apply() converts the
+     * pending command and writes it in the driver's object dictionary, just
+     * before the RPDOs are generated.
+     *
+     * push() may be called from any thread, concurrently with apply()
+     */
+    class CommandCoalescer {
+        static const int FIELD_COUNT = base::JointState::UNSET;
+
+        CoalescingPolicy m_policy;
+
+        mutable std::mutex m_mutex;
+        base::samples::Joints m_pending;
+        size_t m_sample_count = 0;
+
+        /** Per-element and per-field number of samples having the field set,
+         * used by COALESCE_MEAN
+         */
+        std::vector<int> m_field_counts;
+
+        /** Buffer used by apply(), kept to avoid allocating on each cycle */
+        base::samples::Joints m_applied;
+
+        void reduce(base::samples::Joints const& sample);
+
+    public:
+        explicit CommandCoalescer(CoalescingPolicy policy = COALESCE_LATEST);
+
+        CoalescingPolicy getPolicy() const;
+
+        /** Add a new sample to the pending command
+         *
+         * @throw std::invalid_argument if the sample does not have the same
+         *   number of elements than the other samples of the cycle
+         */
+        void push(base::samples::Joints const& sample);
+
+        /** How many samples have been pushed since the last take() or apply() */
+        size_t getPendingSampleCount() const;
+
+        /** Retrieve and clear the pending command
+         *
+         * The command's time and names are the ones of the last sample
+         *
+         * @return false if no sample has been pushed since the last call, in
+         *   which case \c command is left unchanged
+         */
+        bool take(base::samples::Joints& command);
+
+        /** Retrieve and clear the pending command, and pass it to
+         * DriverBase::setJointCommand
+         *
+         * Only one thread may call this method
+         *
+         * @return false if no sample has been pushed since the last call
+         */
+        bool apply(DriverBase& driver);
+    };
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include <base/Float.hpp>
+#include <base/Time.hpp>
 #include <base/Temperature.hpp>
 
 namespace motors_roboteq_canopen {
@@ -62,6 +63,21 @@ namespace motors_roboteq_canopen {
 
         /** @meta bitfields /motors_roboteq_canopen/ChannelStatusFlags */
         std::vector<uint16_t> channel_status_flags;
+
+        /** Time elapsed since each field was last received
+         *
+         * The ages are relative to the time given to
+         * DriverBase::getControllerStatus. They are base::Time::max() for the
+         * fields that have never been received.
+         */
+        base::Time voltage_internal_age = base::Time::max();
+        base::Time voltage_battery_age = base::Time::max();
+        base::Time voltage_5v_age = base::Time::max();
+        base::Time temperature_mcu_age = base::Time::max();
+        std::vector<base::Time> temperature_sensor_ages;
+        base::Time status_flags_age = base::Time::max();
+        base::Time fault_flags_age = base::Time::max();
+        std::vector<base::Time> channel_status_flags_ages;
     };
 }
 
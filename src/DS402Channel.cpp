@@ -11,6 +11,7 @@ DS402Channel::DS402Channel(DS402Driver& driver, int channel)
     : m_driver(driver)
     , m_channel(channel)
     , m_object_id_offset(channel * CHANNEL_OBJECT_ID_OFFSET) {
+    selectPolicies();
 }
 
 bool DS402Channel::isIgnored() const {
@@ -38,33 +39,26 @@ StatusWord DS402Channel::getDS402Status() const {
 }
 
 bool DS402Channel::updateJointStateTracking(canopen_master::StateMachine::Update const& update) {
+    uint32_t tracking = 0;
     if (hasUpdatedObject<MotorAmps>(update)) {
-        m_joint_state_tracking |= UPDATED_MOTOR_AMPS;
+        tracking |= UPDATED_MOTOR_AMPS;
     }
     if (hasUpdatedObject<AppliedPowerLevel>(update)) {
-        m_joint_state_tracking |= UPDATED_POWER_LEVEL;
+        tracking |= UPDATED_POWER_LEVEL;
     }
     if (hasUpdatedObject<ActualProfileVelocity>(update)) {
-        m_joint_state_tracking |= UPDATED_ACTUAL_PROFILE_VELOCITY;
+        tracking |= UPDATED_ACTUAL_PROFILE_VELOCITY;
     }
     if (hasUpdatedObject<ActualVelocity>(update)) {
-        m_joint_state_tracking |= UPDATED_ACTUAL_VELOCITY;
+        tracking |= UPDATED_ACTUAL_VELOCITY;
     }
     if (hasUpdatedObject<Position>(update)) {
-        m_joint_state_tracking |= UPDATED_POSITION;
+        tracking |= UPDATED_POSITION;
     }
     if (hasUpdatedObject<Torque>(update)) {
-        m_joint_state_tracking |= UPDATED_TORQUE;
+        tracking |= UPDATED_TORQUE;
     }
-    return hasJointStateUpdate();
-}
-
-bool DS402Channel::hasJointStateUpdate() const {
-    return (m_joint_state_tracking & m_joint_state_mask) == m_joint_state_mask;
-}
-
-void DS402Channel::resetJointStateTracking() {
-    m_joint_state_tracking = 0;
+    return markJointStateUpdates(tracking, base::Time::now());
 }
 
 vector<PDOMapping> DS402Channel::getJointStateTPDOMapping() const {
@@ -124,39 +118,7 @@ vector<canbus::Message> DS402Channel::queryJointState() const {
 }
 
 JointState DS402Channel::getJointState() const {
-    JointState state;
-    if (m_operation_mode == DS402_OPERATION_MODE_NONE) {
-        return state;
-    }
-
-    state.effort = m_factors.currentToTorqueSI(get<MotorAmps>());
-    state.raw = m_factors.pwmToFloat(get<AppliedPowerLevel>());
-
-    switch (m_operation_mode) {
-        case DS402_OPERATION_MODE_VELOCITY_POSITION_PROFILE:
-        case DS402_OPERATION_MODE_VELOCITY_PROFILE:
-            state.speed = m_factors.rpmToSI(get<ActualProfileVelocity>());
-            return state;
-        case DS402_OPERATION_MODE_VELOCITY_POSITION:
-        case DS402_OPERATION_MODE_VELOCITY:
-            state.speed = m_factors.rpmToSI(get<ActualVelocity>());
-            return state;
-        case DS402_OPERATION_MODE_ANALOG_VELOCITY:
-            state.speed = m_factors.relativeSpeedToSI(get<ActualVelocity>());
-            return state;
-        case DS402_OPERATION_MODE_ANALOG_POSITION:
-            state.position = m_factors.relativePositionToSI(get<ActualVelocity>());
-            return state;
-        case DS402_OPERATION_MODE_RELATIVE_POSITION_PROFILE:
-        case DS402_OPERATION_MODE_RELATIVE_POSITION:
-            state.position = m_factors.relativePositionToSI(get<Position>());
-            return state;
-        case DS402_OPERATION_MODE_TORQUE_PROFILE: {
-            return state;
-        }
-        default:
-            throw invalid_argument("unsupported operation mode");
-    }
+    return (this->*m_joint_state_handler)();
 }
 
 uint32_t DS402Channel::getJointStateMask() const {
@@ -203,6 +165,7 @@ vector<canbus::Message> DS402Channel::queryOperationModeDownload(
 
 void DS402Channel::setOperationMode(DS402OperationModes mode) {
     m_operation_mode = mode;
+    selectPolicies();
     m_joint_state_tracking = 0;
     m_joint_state_mask = getJointStateMask();
 }
@@ -247,7 +210,7 @@ typename T::OBJECT_TYPE DS402Channel::get() const {
 template<typename T>
 void DS402Channel::set(typename T::OBJECT_TYPE value) {
     auto offsets = getObjectOffsets<T>();
-    return m_driver.set<T>(value, offsets.first, offsets.second);
+    return m_driver.setRPDOObject<T>(value, offsets.first, offsets.second);
 }
 
 template<typename T>
@@ -275,6 +238,25 @@ bool DS402Channel::hasUpdatedObject(canopen_master::StateMachine::Update const&
     return update.hasUpdatedObject<T>(offsets.first, offsets.second);
 }
 
+template<typename T>
+ChannelBase::TrackedObject DS402Channel::trackedObject(uint32_t tracking_bit) const {
+    auto offsets = getObjectOffsets<T>();
+    return TrackedObject {
+        T::OBJECT_ID + offsets.first, T::OBJECT_SUB_ID + offsets.second, tracking_bit
+    };
+}
+
+vector<ChannelBase::TrackedObject> DS402Channel::getJointStateTrackedObjects() const {
+    return vector<TrackedObject> {
+        trackedObject<MotorAmps>(UPDATED_MOTOR_AMPS),
+        trackedObject<AppliedPowerLevel>(UPDATED_POWER_LEVEL),
+        trackedObject<ActualProfileVelocity>(UPDATED_ACTUAL_PROFILE_VELOCITY),
+        trackedObject<ActualVelocity>(UPDATED_ACTUAL_VELOCITY),
+        trackedObject<Position>(UPDATED_POSITION),
+        trackedObject<Torque>(UPDATED_TORQUE)
+    };
+}
+
 vector<PDOMapping> DS402Channel::getJointCommandRPDOMapping() const {
     vector<PDOMapping> mappings;
     mappings.push_back(PDOMapping());
@@ -323,65 +305,7 @@ base::JointState DS402Channel::getJointCommand() const {
 }
 
 void DS402Channel::setJointCommand(base::JointState const& cmd) {
-    switch (m_operation_mode) {
-        case DS402_OPERATION_MODE_VELOCITY_POSITION_PROFILE:
-        case DS402_OPERATION_MODE_VELOCITY_PROFILE: {
-            double acceleration = validateField(JointState::ACCELERATION, cmd);
-            uint32_t acceleration_roboteq = m_factors.rpmFromSI(acceleration) * 10;
-            double effort = validateField(JointState::EFFORT, cmd);
-            double velocity = validateField(JointState::SPEED, cmd);
-
-            set<TargetTorque>(m_factors.currentFromTorqueSI(effort));
-            set<ProfileAcceleration>(acceleration_roboteq);
-            set<ProfileDeceleration>(acceleration_roboteq);
-            set<TargetProfileVelocity>(m_factors.rpmFromSI(velocity));
-            break;
-        }
-        case DS402_OPERATION_MODE_VELOCITY_POSITION:
-        case DS402_OPERATION_MODE_VELOCITY: {
-            double velocity = validateField(JointState::SPEED, cmd);
-            set<TargetVelocity>(m_factors.rpmFromSI(velocity));
-            break;
-        }
-        case DS402_OPERATION_MODE_ANALOG_VELOCITY: {
-            double velocity = validateField(JointState::SPEED, cmd);
-            set<TargetVelocity>(m_factors.relativeSpeedFromSI(velocity));
-            break;
-        }
-        case DS402_OPERATION_MODE_ANALOG_POSITION: {
-            double position = validateField(JointState::POSITION, cmd);
-            set<TargetVelocity>(m_factors.relativePositionFromSI(position));
-            break;
-        }
-        case DS402_OPERATION_MODE_RELATIVE_POSITION_PROFILE: {
-            double velocity = validateField(JointState::SPEED, cmd);
-            double acceleration = validateField(JointState::ACCELERATION, cmd);
-            uint32_t acceleration_roboteq = m_factors.rpmFromSI(acceleration) * 10;
-            double position = validateField(JointState::POSITION, cmd);
-
-            set<TargetPosition>(m_factors.relativePositionFromSI(position));
-            set<ProfileVelocity>(m_factors.rpmFromSI(velocity));
-            set<ProfileAcceleration>(acceleration_roboteq);
-            set<ProfileDeceleration>(acceleration_roboteq);
-            break;
-        }
-        case DS402_OPERATION_MODE_RELATIVE_POSITION: {
-            double position = validateField(JointState::POSITION, cmd);
-            set<TargetPosition>(m_factors.relativePositionFromSI(position));
-            break;
-        }
-        case DS402_OPERATION_MODE_TORQUE_PROFILE: {
-            double effort = validateField(JointState::EFFORT, cmd);
-            double effort_slope = validateField(JointState::RAW, cmd);
-            set<TargetTorque>(m_factors.currentFromTorqueSI(effort));
-            set<TorqueSlope>(m_factors.currentSlopeFromTorqueSlopeSI(effort_slope));
-            break;
-        }
-        default:
-            throw invalid_argument("unsupported operation mode");
-    }
-
-    m_current_command = cmd;
+    (this->*m_joint_command_handler)(cmd);
 }
 
 vector<canbus::Message> DS402Channel::queryJointCommandDownload() const {
@@ -423,4 +347,292 @@ vector<canbus::Message> DS402Channel::queryJointCommandDownload() const {
         default:
             throw invalid_argument("unsupported operation mode");
     }
-}
\ No newline at end of file
+}
+
+// The policies are defined after the getObjectOffsets specializations they
+// depend on
+
+JointState DS402Channel::getJointStateIgnored() const {
+    return JointState();
+}
+
+JointState DS402Channel::getJointStateUnsupported() const {
+    throw invalid_argument("unsupported operation mode");
+}
+
+JointState DS402Channel::getCommonJointState() const {
+    JointState state;
+    state.effort = m_factors.currentToTorqueSI(get<MotorAmps>());
+    state.raw = m_factors.pwmToFloat(get<AppliedPowerLevel>());
+    return state;
+}
+
+template<>
+JointState DS402Channel::getJointStateFor<DS402_OPERATION_MODE_VELOCITY_PROFILE>() const {
+    JointState state = getCommonJointState();
+    state.speed = m_factors.rpmToSI(get<ActualProfileVelocity>());
+    return state;
+}
+
+template<>
+JointState DS402Channel::getJointStateFor<DS402_OPERATION_MODE_VELOCITY>() const {
+    JointState state = getCommonJointState();
+    state.speed = m_factors.rpmToSI(get<ActualVelocity>());
+    return state;
+}
+
+template<>
+JointState DS402Channel::getJointStateFor<DS402_OPERATION_MODE_ANALOG_VELOCITY>() const {
+    JointState state = getCommonJointState();
+    state.speed = m_factors.relativeSpeedToSI(get<ActualVelocity>());
+    return state;
+}
+
+template<>
+JointState DS402Channel::getJointStateFor<DS402_OPERATION_MODE_ANALOG_POSITION>() const {
+    JointState state = getCommonJointState();
+    state.position = m_factors.relativePositionToSI(get<ActualVelocity>());
+    return state;
+}
+
+template<>
+JointState DS402Channel::getJointStateFor<DS402_OPERATION_MODE_RELATIVE_POSITION>() const {
+    JointState state = getCommonJointState();
+    state.position = m_factors.relativePositionToSI(get<Position>());
+    return state;
+}
+
+template<>
+JointState DS402Channel::getJointStateFor<DS402_OPERATION_MODE_TORQUE_PROFILE>() const {
+    return getCommonJointState();
+}
+
+RawJointState DS402Channel::getRawJointState() const {
+    return (this->*m_raw_joint_state_handler)();
+}
+
+RawJointState DS402Channel::getRawJointStateIgnored() const {
+    return RawJointState();
+}
+
+RawJointState DS402Channel::getRawJointStateUnsupported() const {
+    throw invalid_argument("unsupported operation mode");
+}
+
+RawJointState DS402Channel::getCommonRawJointState() const {
+    RawJointState raw;
+    raw.valid = true;
+    raw.current = get<MotorAmps>();
+    raw.power_level = get<AppliedPowerLevel>();
+    return raw;
+}
+
+template<>
+RawJointState DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_VELOCITY_PROFILE>() const {
+    RawJointState raw = getCommonRawJointState();
+    raw.speed_unit = RawJointState::UNIT_RPM;
+    raw.speed = get<ActualProfileVelocity>();
+    return raw;
+}
+
+template<>
+RawJointState DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_VELOCITY>() const {
+    RawJointState raw = getCommonRawJointState();
+    raw.speed_unit = RawJointState::UNIT_RPM;
+    raw.speed = get<ActualVelocity>();
+    return raw;
+}
+
+template<>
+RawJointState DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_ANALOG_VELOCITY>() const {
+    RawJointState raw = getCommonRawJointState();
+    raw.speed_unit = RawJointState::UNIT_RELATIVE;
+    raw.speed = get<ActualVelocity>();
+    return raw;
+}
+
+template<>
+RawJointState DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_ANALOG_POSITION>() const {
+    RawJointState raw = getCommonRawJointState();
+    raw.position_unit = RawJointState::UNIT_RELATIVE;
+    raw.position = get<ActualVelocity>();
+    return raw;
+}
+
+template<>
+RawJointState DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_RELATIVE_POSITION>() const {
+    RawJointState raw = getCommonRawJointState();
+    raw.position_unit = RawJointState::UNIT_RELATIVE;
+    raw.position = get<Position>();
+    return raw;
+}
+
+template<>
+RawJointState DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_TORQUE_PROFILE>() const {
+    return getCommonRawJointState();
+}
+
+template<>
+void DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_VELOCITY_PROFILE>(
+    JointState const& cmd
+) {
+    double acceleration = validateField(JointState::ACCELERATION, cmd);
+    uint32_t acceleration_roboteq = m_factors.rpmFromSI(acceleration) * 10;
+    double effort = validateField(JointState::EFFORT, cmd);
+    double velocity = validateField(JointState::SPEED, cmd);
+
+    set<TargetTorque>(m_factors.currentFromTorqueSI(effort));
+    set<ProfileAcceleration>(acceleration_roboteq);
+    set<ProfileDeceleration>(acceleration_roboteq);
+    set<TargetProfileVelocity>(m_factors.rpmFromSI(velocity));
+    m_current_command = cmd;
+}
+
+template<>
+void DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_VELOCITY>(
+    JointState const& cmd
+) {
+    double velocity = validateField(JointState::SPEED, cmd);
+    set<TargetVelocity>(m_factors.rpmFromSI(velocity));
+    m_current_command = cmd;
+}
+
+template<>
+void DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_ANALOG_VELOCITY>(
+    JointState const& cmd
+) {
+    double velocity = validateField(JointState::SPEED, cmd);
+    set<TargetVelocity>(m_factors.relativeSpeedFromSI(velocity));
+    m_current_command = cmd;
+}
+
+template<>
+void DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_ANALOG_POSITION>(
+    JointState const& cmd
+) {
+    double position = validateField(JointState::POSITION, cmd);
+    set<TargetVelocity>(m_factors.relativePositionFromSI(position));
+    m_current_command = cmd;
+}
+
+template<>
+void DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_RELATIVE_POSITION_PROFILE>(
+    JointState const& cmd
+) {
+    double velocity = validateField(JointState::SPEED, cmd);
+    double acceleration = validateField(JointState::ACCELERATION, cmd);
+    uint32_t acceleration_roboteq = m_factors.rpmFromSI(acceleration) * 10;
+    double position = validateField(JointState::POSITION, cmd);
+
+    set<TargetPosition>(m_factors.relativePositionFromSI(position));
+    set<ProfileVelocity>(m_factors.rpmFromSI(velocity));
+    set<ProfileAcceleration>(acceleration_roboteq);
+    set<ProfileDeceleration>(acceleration_roboteq);
+    m_current_command = cmd;
+}
+
+template<>
+void DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_RELATIVE_POSITION>(
+    JointState const& cmd
+) {
+    double position = validateField(JointState::POSITION, cmd);
+    set<TargetPosition>(m_factors.relativePositionFromSI(position));
+    m_current_command = cmd;
+}
+
+template<>
+void DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_TORQUE_PROFILE>(
+    JointState const& cmd
+) {
+    double effort = validateField(JointState::EFFORT, cmd);
+    double effort_slope = validateField(JointState::RAW, cmd);
+    set<TargetTorque>(m_factors.currentFromTorqueSI(effort));
+    set<TorqueSlope>(m_factors.currentSlopeFromTorqueSlopeSI(effort_slope));
+    m_current_command = cmd;
+}
+
+void DS402Channel::setJointCommandUnsupported(JointState const&) {
+    throw invalid_argument("unsupported operation mode");
+}
+
+JointCommandConversions DS402Channel::getJointCommandConversion() const {
+    // Most DS402 modes command several objects, and the single-object ones
+    // convert to RPM or truncate to 16 bits. Leave them to setJointCommand.
+    return JOINT_COMMAND_CONVERSION_NONE;
+}
+
+void DS402Channel::setConvertedJointCommand(JointState const&, int32_t) {
+    throw logic_error("the joint command of DS402 channels is not converted by batch");
+}
+
+void DS402Channel::selectPolicies() {
+    switch (m_operation_mode) {
+        case DS402_OPERATION_MODE_NONE:
+            m_joint_command_handler = &DS402Channel::setJointCommandUnsupported;
+            m_joint_state_handler = &DS402Channel::getJointStateIgnored;
+            m_raw_joint_state_handler = &DS402Channel::getRawJointStateIgnored;
+            break;
+        case DS402_OPERATION_MODE_VELOCITY_POSITION_PROFILE:
+        case DS402_OPERATION_MODE_VELOCITY_PROFILE:
+            m_joint_command_handler =
+                &DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_VELOCITY_PROFILE>;
+            m_joint_state_handler =
+                &DS402Channel::getJointStateFor<DS402_OPERATION_MODE_VELOCITY_PROFILE>;
+            m_raw_joint_state_handler =
+                &DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_VELOCITY_PROFILE>;
+            break;
+        case DS402_OPERATION_MODE_VELOCITY_POSITION:
+        case DS402_OPERATION_MODE_VELOCITY:
+            m_joint_command_handler =
+                &DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_VELOCITY>;
+            m_joint_state_handler =
+                &DS402Channel::getJointStateFor<DS402_OPERATION_MODE_VELOCITY>;
+            m_raw_joint_state_handler =
+                &DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_VELOCITY>;
+            break;
+        case DS402_OPERATION_MODE_ANALOG_VELOCITY:
+            m_joint_command_handler =
+                &DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_ANALOG_VELOCITY>;
+            m_joint_state_handler =
+                &DS402Channel::getJointStateFor<DS402_OPERATION_MODE_ANALOG_VELOCITY>;
+            m_raw_joint_state_handler =
+                &DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_ANALOG_VELOCITY>;
+            break;
+        case DS402_OPERATION_MODE_ANALOG_POSITION:
+            m_joint_command_handler =
+                &DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_ANALOG_POSITION>;
+            m_joint_state_handler =
+                &DS402Channel::getJointStateFor<DS402_OPERATION_MODE_ANALOG_POSITION>;
+            m_raw_joint_state_handler =
+                &DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_ANALOG_POSITION>;
+            break;
+        case DS402_OPERATION_MODE_RELATIVE_POSITION_PROFILE:
+            m_joint_command_handler =
+                &DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_RELATIVE_POSITION_PROFILE>;
+            m_joint_state_handler =
+                &DS402Channel::getJointStateFor<DS402_OPERATION_MODE_RELATIVE_POSITION>;
+            m_raw_joint_state_handler =
+                &DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_RELATIVE_POSITION>;
+            break;
+        case DS402_OPERATION_MODE_RELATIVE_POSITION:
+            m_joint_command_handler =
+                &DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_RELATIVE_POSITION>;
+            m_joint_state_handler =
+                &DS402Channel::getJointStateFor<DS402_OPERATION_MODE_RELATIVE_POSITION>;
+            m_raw_joint_state_handler =
+                &DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_RELATIVE_POSITION>;
+            break;
+        case DS402_OPERATION_MODE_TORQUE_PROFILE:
+            m_joint_command_handler =
+                &DS402Channel::setJointCommandFor<DS402_OPERATION_MODE_TORQUE_PROFILE>;
+            m_joint_state_handler =
+                &DS402Channel::getJointStateFor<DS402_OPERATION_MODE_TORQUE_PROFILE>;
+            m_raw_joint_state_handler =
+                &DS402Channel::getRawJointStateFor<DS402_OPERATION_MODE_TORQUE_PROFILE>;
+            break;
+        default:
+            m_joint_command_handler = &DS402Channel::setJointCommandUnsupported;
+            m_joint_state_handler = &DS402Channel::getJointStateUnsupported;
+            m_raw_joint_state_handler = &DS402Channel::getRawJointStateUnsupported;
+    }
+}
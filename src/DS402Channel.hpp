@@ -59,6 +59,9 @@ namespace motors_roboteq_canopen {
         template<typename T>
         bool hasUpdatedObject(canopen_master::StateMachine::Update const& update) const;
 
+        template<typename T>
+        TrackedObject trackedObject(uint32_t tracking_bit) const;
+
         enum JointStateTracking {
             UPDATED_MOTOR_AMPS = 0x1,
             UPDATED_POWER_LEVEL = 0x2,
@@ -68,10 +71,50 @@ namespace motors_roboteq_canopen {
             UPDATED_TORQUE = 0x20
         };
 
-        uint8_t m_joint_state_tracking = 0;
-        uint8_t m_joint_state_mask = 0;
         uint32_t getJointStateMask() const;
 
+        typedef void (DS402Channel::*JointCommandHandler)(base::JointState const& cmd);
+        typedef base::JointState (DS402Channel::*JointStateHandler)() const;
+        typedef RawJointState (DS402Channel::*RawJointStateHandler)() const;
+
+        /** Implementation of setJointCommand for the current operation mode
+         *
+         * @see selectPolicies
+         */
+        JointCommandHandler m_joint_command_handler;
+
+        /** Implementation of getJointState and getRawJointState for the
+         * current operation mode
+         *
+         * @see selectPolicies
+         */
+        JointStateHandler m_joint_state_handler;
+        RawJointStateHandler m_raw_joint_state_handler;
+
+        /** Select the command and joint state implementations matching the
+         * current operation mode
+         *
+         * They are specialized at compile time for each mode, so that the
+         * per-cycle paths do not have to test it
+         */
+        void selectPolicies();
+
+        template<DS402OperationModes Mode>
+        void setJointCommandFor(base::JointState const& cmd);
+        void setJointCommandUnsupported(base::JointState const& cmd);
+
+        template<DS402OperationModes Mode>
+        base::JointState getJointStateFor() const;
+        base::JointState getJointStateIgnored() const;
+        base::JointState getJointStateUnsupported() const;
+        base::JointState getCommonJointState() const;
+
+        template<DS402OperationModes Mode>
+        RawJointState getRawJointStateFor() const;
+        RawJointState getRawJointStateIgnored() const;
+        RawJointState getRawJointStateUnsupported() const;
+        RawJointState getCommonRawJointState() const;
+
     public:
         bool isIgnored() const;
 
@@ -92,6 +135,9 @@ namespace motors_roboteq_canopen {
         /** Get the channel's joint state */
         base::JointState getJointState() const;
 
+        /** Get the raw objects getJointState converts */
+        RawJointState getRawJointState() const;
+
         /** Add the joint state object to the PDO mapping */
         std::vector<canopen_master::PDOMapping> getJointStateTPDOMapping() const;
 
@@ -119,6 +165,17 @@ namespace motors_roboteq_canopen {
         /** Returns the last joint command set */
         base::JointState getJointCommand() const;
 
+        /** Always JOINT_COMMAND_CONVERSION_NONE, DS402 commands are converted
+         * by setJointCommand
+         */
+        JointCommandConversions getJointCommandConversion() const;
+
+        /** Not supported, see getJointCommandConversion
+         *
+         * @throw std::logic_error
+         */
+        void setConvertedJointCommand(base::JointState const& cmd, int32_t raw);
+
         /** Return the SDO messages that would update the current command
          */
         std::vector<canbus::Message> queryJointCommandDownload() const;
@@ -134,16 +191,8 @@ namespace motors_roboteq_canopen {
          */
         bool updateJointStateTracking(canopen_master::StateMachine::Update const& update);
 
-        /** Whether all fields necessary for getJointState have been updated since
-         * the last call to resetJointStateTracking
-         *
-         * This assumes that you call updateJointStateTracking with the update
-         * call
-         */
-        bool hasJointStateUpdate() const;
-
-        /** Reset the internal tracking state of updateJointStateTracking */
-        void resetJointStateTracking();
+        /** The objects tracked by updateJointStateTracking */
+        std::vector<TrackedObject> getJointStateTrackedObjects() const;
     };
 }
 
@@ -68,6 +68,11 @@ namespace motors_roboteq_canopen {
      * returns true, read the joint state and call \c Channel.resetJointStateTracking
      * to be able to wait for a new update.
      *
+     * Instead of polling, one can register a \c DriverListener with
+     * \c setListener (or a \c JointStateListener on the channel). It is called
+     * from within \c process as soon as a joint state, or one of the analog and
+     * encoder groups described below, is complete.
+     *
      * ## Analog readings
      *
      * Periodic analog readings via PDOs are managed the same way than the joint state
@@ -1,5 +1,8 @@
 #include <motors_roboteq_canopen/DriverBase.hpp>
 #include <motors_roboteq_canopen/Objects.hpp>
+#include <canopen_master/SDO.hpp>
+
+#include <algorithm>
 
 using namespace std;
 using namespace base;
@@ -13,6 +16,47 @@ DriverBase::DriverBase(canopen_master::StateMachine& state_machine)
     state_machine.setQuirks(
         canopen_master::StateMachine::PDO_COBID_MESSAGE_RESERVED_BIT_QUIRK
     );
+
+    addGroupTrackingDispatch(
+        AnalogInput::OBJECT_ID, TRACKING_GROUP_ANALOG_INPUTS
+    );
+    addGroupTrackingDispatch(
+        ConvertedAnalogInput::OBJECT_ID, TRACKING_GROUP_CONVERTED_ANALOG_INPUTS
+    );
+    addGroupTrackingDispatch(
+        EncoderCounter::OBJECT_ID, TRACKING_GROUP_ENCODER_COUNTERS
+    );
+
+    addStatusTrackingDispatch(
+        VoltageInternal::OBJECT_ID, VoltageInternal::OBJECT_SUB_ID,
+        STATUS_FIELD_VOLTAGE_INTERNAL
+    );
+    addStatusTrackingDispatch(
+        VoltageBattery::OBJECT_ID, VoltageBattery::OBJECT_SUB_ID,
+        STATUS_FIELD_VOLTAGE_BATTERY
+    );
+    addStatusTrackingDispatch(
+        Voltage5V::OBJECT_ID, Voltage5V::OBJECT_SUB_ID, STATUS_FIELD_VOLTAGE_5V
+    );
+    addStatusTrackingDispatch(
+        TemperatureMCU::OBJECT_ID, TemperatureMCU::OBJECT_SUB_ID,
+        STATUS_FIELD_TEMPERATURE_MCU
+    );
+    addStatusTrackingDispatch(
+        StatusFlagsRaw::OBJECT_ID, StatusFlagsRaw::OBJECT_SUB_ID,
+        STATUS_FIELD_STATUS_FLAGS
+    );
+    addStatusTrackingDispatch(
+        FaultFlagsRaw::OBJECT_ID, FaultFlagsRaw::OBJECT_SUB_ID,
+        STATUS_FIELD_FAULT_FLAGS
+    );
+}
+
+TPDORateTiers::TPDORateTiers()
+    : joint_state(PDOCommunicationParameters::Sync(1))
+    , status(PDOCommunicationParameters::Sync(10)) {
+    housekeeping.transmission_mode = canopen_master::PDO_ASYNCHRONOUS;
+    housekeeping.timer_period = base::Time::fromSeconds(1);
 }
 
 DriverBase::~DriverBase() {
@@ -27,27 +71,489 @@ size_t DriverBase::getChannelCount() const {
 
 void DriverBase::addChannel(ChannelBase* channel) {
     m_channels.push_back(channel);
+    m_temperature_sensor_times.push_back(base::Time());
+    m_channel_status_flags_times.push_back(base::Time());
+    addChannelTrackingDispatch(m_channels.size() - 1);
 }
 
-canopen_master::StateMachine::Update DriverBase::process(canbus::Message const& message) {
-    auto update = canopen_master::Slave::process(message);
-    for (auto c : m_channels) {
-        c->updateJointStateTracking(update);
+uint32_t DriverBase::getTrackingKey(int object_id, int sub_id) {
+    return (static_cast<uint32_t>(object_id) << 8) | (sub_id & 0xFF);
+}
+
+void DriverBase::addGroupTrackingDispatch(int object_id, TrackingGroups group) {
+    for (int i = 0; i < 32; ++i) {
+        auto& entry = m_tracking_dispatch[getTrackingKey(object_id, i + 1)];
+        entry.group = group;
+        entry.group_bits = 1 << i;
     }
-    for (auto single_update : update) {
-        if (single_update.first == AnalogInput::OBJECT_ID) {
-            m_received_analog_inputs_mask |= 1 << (single_update.second - 1);
+}
+
+void DriverBase::addStatusTrackingDispatch(
+    int object_id, int sub_id, StatusFields field, int index
+) {
+    auto& entry = m_tracking_dispatch[getTrackingKey(object_id, sub_id)];
+    entry.status_field = field;
+    entry.status_index = index;
+}
+
+void DriverBase::addChannelTrackingDispatch(int channel_index) {
+    addStatusTrackingDispatch(
+        TemperatureSensor0::OBJECT_ID,
+        TemperatureSensor0::OBJECT_SUB_ID + channel_index,
+        STATUS_FIELD_TEMPERATURE_SENSOR, channel_index
+    );
+    addStatusTrackingDispatch(
+        ChannelStatusFlagsRaw::OBJECT_ID,
+        ChannelStatusFlagsRaw::OBJECT_SUB_ID + channel_index,
+        STATUS_FIELD_CHANNEL_STATUS_FLAGS, channel_index
+    );
+
+    auto objects = m_channels[channel_index]->getJointStateTrackedObjects();
+    for (auto const& object : objects) {
+        auto& entry = m_tracking_dispatch[
+            getTrackingKey(object.object_id, object.sub_id)
+        ];
+        entry.channel = channel_index;
+        entry.channel_bits |= object.tracking_bit;
+    }
+}
+
+void DriverBase::dispatchUpdate(int object_id, int sub_id) {
+    auto it = m_tracking_dispatch.find(getTrackingKey(object_id, sub_id));
+    if (it == m_tracking_dispatch.end()) {
+        return;
+    }
+
+    applyTracking(it->second);
+}
+
+void DriverBase::applyTracking(TrackingDispatch const& entry) {
+    if (entry.channel >= 0) {
+        markChannelUpdates(entry.channel, entry.channel_bits);
+    }
+    if (entry.group != TRACKING_GROUP_NONE) {
+        markGroupUpdates(entry.group, entry.group_bits);
+    }
+    if (entry.status_field != STATUS_FIELD_NONE) {
+        recordStatusTime(entry.status_field, entry.status_index);
+        if (m_state_snapshot_enabled) {
+            updateStatusSnapshot(entry.status_field, entry.status_index);
         }
-        else if (single_update.first == ConvertedAnalogInput::OBJECT_ID) {
-            m_received_converted_analog_inputs_mask |= 1 << (single_update.second - 1);
+    }
+}
+
+void DriverBase::recordStatusTime(StatusFields field, int index) {
+    switch (field) {
+        case STATUS_FIELD_TEMPERATURE_SENSOR:
+            m_temperature_sensor_times[index] = m_message_time;
+            break;
+        case STATUS_FIELD_CHANNEL_STATUS_FLAGS:
+            m_channel_status_flags_times[index] = m_message_time;
+            break;
+        default:
+            m_status_field_times[field] = m_message_time;
+    }
+}
+
+void DriverBase::updateStatusSnapshot(StatusFields field, int index) {
+    switch (field) {
+        case STATUS_FIELD_VOLTAGE_INTERNAL:
+            m_state_snapshot.voltage_internal =
+                static_cast<float>(get<VoltageInternal>()) / 10;
+            break;
+        case STATUS_FIELD_VOLTAGE_BATTERY:
+            m_state_snapshot.voltage_battery =
+                static_cast<float>(get<VoltageBattery>()) / 10;
+            break;
+        case STATUS_FIELD_VOLTAGE_5V:
+            m_state_snapshot.voltage_5v =
+                static_cast<float>(get<Voltage5V>()) / 1000;
+            break;
+        case STATUS_FIELD_TEMPERATURE_MCU:
+            m_state_snapshot.temperature_mcu =
+                Temperature::fromCelsius(get<TemperatureMCU>());
+            break;
+        case STATUS_FIELD_TEMPERATURE_SENSOR:
+            m_state_snapshot.temperature_sensors[index] =
+                Temperature::fromCelsius(get<TemperatureSensor0>(0, index));
+            break;
+        case STATUS_FIELD_STATUS_FLAGS:
+            m_state_snapshot.status_flags = get<StatusFlagsRaw>();
+            break;
+        case STATUS_FIELD_FAULT_FLAGS:
+            m_state_snapshot.fault_flags = get<FaultFlagsRaw>();
+            break;
+        case STATUS_FIELD_CHANNEL_STATUS_FLAGS:
+            m_state_snapshot.channel_status_flags[index] =
+                get<ChannelStatusFlagsRaw>(0, index);
+            break;
+        default:
+            return;
+    }
+    m_state_snapshot_dirty = true;
+}
+
+void DriverBase::publishStateSnapshot() {
+    if (!m_state_snapshot_dirty) {
+        return;
+    }
+
+    m_published_state_snapshot.write(m_state_snapshot);
+    m_state_snapshot_dirty = false;
+}
+
+void DriverBase::enableStateSnapshot() {
+    if (m_channels.size() > DriverStateSnapshot::MAX_CHANNELS) {
+        throw std::invalid_argument(
+            "state snapshots are limited to " +
+            to_string(DriverStateSnapshot::MAX_CHANNELS) + " channels"
+        );
+    }
+
+    m_state_snapshot = DriverStateSnapshot();
+    m_state_snapshot.channel_count = m_channels.size();
+    m_state_snapshot_enabled = true;
+}
+
+uint32_t DriverBase::readStateSnapshot(DriverStateSnapshot& snapshot) const {
+    return m_published_state_snapshot.read(snapshot);
+}
+
+void DriverBase::markChannelUpdates(int channel_index, uint32_t bits) {
+    ChannelBase& channel = *m_channels[channel_index];
+    bool was_complete = channel.hasJointStateUpdate();
+    uint64_t generation = channel.getJointStateGeneration();
+    bool complete = channel.markJointStateUpdates(bits, m_message_time);
+    if (complete && m_state_snapshot_enabled) {
+        m_state_snapshot.joint_states[channel_index] = channel.getJointState();
+        m_state_snapshot_dirty = true;
+    }
+
+    // The queue follows the channel's generation rather than its tracking,
+    // as the consumer thread cannot reset the tracking without locking the
+    // driver
+    if (m_joint_state_queue && channel.getJointStateGeneration() != generation) {
+        JointStateSnapshot snapshot;
+        snapshot.time = m_message_time;
+        snapshot.channel = channel_index;
+        snapshot.state = channel.getJointState();
+        if (!m_joint_state_queue->push(snapshot)) {
+            ++m_joint_state_queue_drops;
+        }
+    }
+    if (complete && !was_complete && m_listener) {
+        m_listener->jointStateCompleted(
+            *this, channel_index, channel.getJointState()
+        );
+    }
+}
+
+void DriverBase::markGroupUpdates(TrackingGroups group, uint32_t bits) {
+    switch (group) {
+        case TRACKING_GROUP_ANALOG_INPUTS: {
+            bool was_complete = hasAnalogInputUpdate();
+            m_received_analog_inputs_mask |= bits;
+            if (!was_complete && hasAnalogInputUpdate() && m_listener) {
+                m_listener->analogInputsCompleted(*this);
+            }
+            break;
+        }
+        case TRACKING_GROUP_CONVERTED_ANALOG_INPUTS: {
+            bool was_complete = hasConvertedAnalogInputUpdate();
+            m_received_converted_analog_inputs_mask |= bits;
+            if (!was_complete && hasConvertedAnalogInputUpdate() && m_listener) {
+                m_listener->convertedAnalogInputsCompleted(*this);
+            }
+            break;
         }
-        else if (single_update.first == EncoderCounter::OBJECT_ID) {
-            m_received_encoder_counter_mask |= 1 << (single_update.second - 1);
+        case TRACKING_GROUP_ENCODER_COUNTERS: {
+            bool was_complete = hasEncoderCounterUpdate();
+            m_received_encoder_counter_mask |= bits;
+            if (!was_complete && hasEncoderCounterUpdate() && m_listener) {
+                m_listener->encoderCountersCompleted(*this);
+            }
+            break;
         }
+        default:
+            break;
+    }
+}
+
+void DriverBase::setListener(DriverListener* listener) {
+    m_listener = listener;
+}
+
+void DriverBase::enableJointStateQueue(size_t capacity) {
+    m_joint_state_queue.reset(new SPSCQueue<JointStateSnapshot>(capacity));
+}
+
+bool DriverBase::popJointState(JointStateSnapshot& snapshot) {
+    if (!m_joint_state_queue) {
+        return false;
+    }
+    return m_joint_state_queue->pop(snapshot);
+}
+
+uint64_t DriverBase::getJointStateQueueDropCount() const {
+    return m_joint_state_queue_drops;
+}
+
+/** Object ID of the first TPDO communication parameter record */
+static const int TPDO_PARAMETERS_OBJECT_ID = 0x1800;
+
+/** Object ID of the first RPDO communication parameter record */
+static const int RPDO_PARAMETERS_OBJECT_ID = 0x1400;
+
+/** Find the COB-ID the given setup messages assign to a PDO
+ *
+ * @param parametersObjectId the object ID of the PDO's communication parameter
+ *   record
+ * @return the COB-ID, or -1 if the messages do not set it
+ */
+static int findPDOCOBId(
+    vector<canbus::Message> const& messages, int parametersObjectId
+) {
+    int cobId = -1;
+    for (auto const& msg : messages) {
+        if (canopen_master::getSDOCommand(msg).command !=
+            canopen_master::SDO_INITIATE_DOMAIN_DOWNLOAD) {
+            continue;
+        }
+        else if (canopen_master::getSDOObjectID(msg) != parametersObjectId ||
+                 canopen_master::getSDOObjectSubID(msg) != 1) {
+            continue;
+        }
+
+        cobId = (msg.data[5] << 8 | msg.data[4]) & 0x7FF;
+    }
+    return cobId;
+}
+
+void DriverBase::compileTPDODecoder(
+    PDOMapping const& mapping, vector<canbus::Message> const& setupMessages,
+    int pdoIndex
+) {
+    ++m_tpdo_decoder_generation;
+
+    // The mapping or the COB-ID of this TPDO may have changed, drop the
+    // decoder of its previous setup
+    auto previous = m_tpdo_decoder_cob_ids.find(pdoIndex);
+    if (previous != m_tpdo_decoder_cob_ids.end()) {
+        m_tpdo_decoders.erase(previous->second);
+        m_tpdo_decoder_cob_ids.erase(previous);
+    }
+
+    int cobId = findPDOCOBId(
+        setupMessages, TPDO_PARAMETERS_OBJECT_ID + pdoIndex
+    );
+    if (cobId < 0) {
+        return;
+    }
+
+    TPDODecoder decoder;
+    for (auto const& object : mapping.mappings) {
+        TPDOField field;
+        field.object_id = object.objectId;
+        field.sub_id = object.subId;
+        field.offset = decoder.size;
+        field.size = object.size;
+
+        auto it = m_tracking_dispatch.find(
+            getTrackingKey(object.objectId, object.subId)
+        );
+        if (it != m_tracking_dispatch.end()) {
+            field.tracking = it->second;
+        }
+        decoder.fields.push_back(field);
+        decoder.size += object.size;
+    }
+    m_tpdo_decoders[cobId] = decoder;
+    m_tpdo_decoder_cob_ids[pdoIndex] = cobId;
+}
+
+template<typename T>
+static T decodeLittleEndian(uint8_t const* data) {
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value |= static_cast<T>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+static void encodeLittleEndian(uint8_t* data, size_t size, uint32_t value) {
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+canopen_master::StateMachine::Update DriverBase::decodeTPDO(
+    TPDODecoder const& decoder, canbus::Message const& message
+) {
+    canopen_master::StateMachine::Update update;
+    for (auto const& field : decoder.fields) {
+        uint8_t const* data = message.data + field.offset;
+        switch (field.size) {
+            case 1:
+                mCANOpen.set<uint8_t>(field.object_id, field.sub_id, data[0]);
+                break;
+            case 2:
+                mCANOpen.set<uint16_t>(
+                    field.object_id, field.sub_id, decodeLittleEndian<uint16_t>(data)
+                );
+                break;
+            case 4:
+                mCANOpen.set<uint32_t>(
+                    field.object_id, field.sub_id, decodeLittleEndian<uint32_t>(data)
+                );
+                break;
+        }
+        update.addUpdate(field.object_id, field.sub_id);
+        applyTracking(field.tracking);
     }
     return update;
 }
 
+void DriverBase::compileRPDOTemplate(
+    PDOMapping const& mapping, vector<canbus::Message> const& setupMessages,
+    int pdoIndex
+) {
+    int cobId = findPDOCOBId(
+        setupMessages, RPDO_PARAMETERS_OBJECT_ID + pdoIndex
+    );
+    if (cobId < 0) {
+        throw std::invalid_argument(
+            "the RPDO setup messages do not define the RPDO's COB-ID"
+        );
+    }
+
+    canbus::Message message;
+    message.can_id = cobId;
+    message.size = 0;
+    std::fill(message.data, message.data + 8, 0);
+
+    for (auto const& object : mapping.mappings) {
+        RPDOField field;
+        field.message_index = m_rpdo_templates.size();
+        field.offset = message.size;
+        field.size = object.size;
+        m_rpdo_fields[getTrackingKey(object.objectId, object.subId)] = field;
+
+        // Initialize the payload with the values already set, if there are any
+        uint32_t value = 0;
+        try {
+            switch (object.size) {
+                case 1:
+                    value = mCANOpen.get<uint8_t>(object.objectId, object.subId);
+                    break;
+                case 2:
+                    value = mCANOpen.get<uint16_t>(object.objectId, object.subId);
+                    break;
+                case 4:
+                    value = mCANOpen.get<uint32_t>(object.objectId, object.subId);
+                    break;
+            }
+        }
+        catch (std::exception const&) {
+        }
+        encodeLittleEndian(message.data + message.size, object.size, value);
+        message.size += object.size;
+    }
+    RPDOEmission emission;
+    auto keepalive = m_rpdo_keepalive_periods.find(m_rpdo_templates.size());
+    emission.keepalive_period = (keepalive == m_rpdo_keepalive_periods.end()) ?
+        m_rpdo_keepalive_period : keepalive->second;
+
+    m_rpdo_templates.push_back(message);
+    m_rpdo_emissions.push_back(emission);
+}
+
+void DriverBase::patchRPDOTemplate(int object_id, int sub_id, uint32_t value) {
+    auto it = m_rpdo_fields.find(getTrackingKey(object_id, sub_id));
+    if (it == m_rpdo_fields.end()) {
+        return;
+    }
+
+    RPDOField const& field = it->second;
+    canbus::Message& message = m_rpdo_templates[field.message_index];
+    uint8_t encoded[4];
+    encodeLittleEndian(encoded, field.size, value);
+    if (!std::equal(encoded, encoded + field.size, message.data + field.offset)) {
+        std::copy(encoded, encoded + field.size, message.data + field.offset);
+        m_rpdo_emissions[field.message_index].dirty = true;
+    }
+}
+
+/** The reception time of a message, or the current time if it is not set */
+static base::Time getReceptionTime(canbus::Message const& message) {
+    return message.time.isNull() ? base::Time::now() : message.time;
+}
+
+canopen_master::StateMachine::Update DriverBase::process(canbus::Message const& message) {
+    return process(message, getReceptionTime(message));
+}
+
+canopen_master::StateMachine::Update DriverBase::process(
+    canbus::Message const& message, base::Time const& time
+) {
+    auto update = processMessage(message, time);
+    publishStateSnapshot();
+    return update;
+}
+
+canopen_master::StateMachine::Update DriverBase::processMessage(
+    canbus::Message const& message, base::Time const& time
+) {
+    m_message_time = time;
+
+    auto decoder = m_tpdo_decoders.find(message.can_id);
+    if (decoder != m_tpdo_decoders.end() && message.size >= decoder->second.size) {
+        return decodeTPDO(decoder->second, message);
+    }
+
+    auto update = canopen_master::Slave::process(message);
+    for (auto single_update : update) {
+        dispatchUpdate(single_update.first, single_update.second);
+    }
+    return update;
+}
+
+uint32_t DriverBase::getCompletedJointStates() const {
+    uint32_t completed = 0;
+    for (size_t i = 0; i < m_channels.size(); ++i) {
+        if (m_channels[i]->hasJointStateUpdate()) {
+            completed |= 1 << i;
+        }
+    }
+    return completed;
+}
+
+BatchUpdate DriverBase::processMessages(
+    canbus::Message const* messages, size_t count
+) {
+    uint32_t joint_states = getCompletedJointStates();
+    bool analog_inputs = hasAnalogInputUpdate();
+    bool converted_analog_inputs = hasConvertedAnalogInputUpdate();
+    bool encoder_counters = hasEncoderCounterUpdate();
+
+    for (size_t i = 0; i < count; ++i) {
+        processMessage(messages[i], getReceptionTime(messages[i]));
+    }
+    publishStateSnapshot();
+
+    BatchUpdate result;
+    result.message_count = count;
+    result.joint_states = getCompletedJointStates() & ~joint_states;
+    result.analog_inputs = !analog_inputs && hasAnalogInputUpdate();
+    result.converted_analog_inputs =
+        !converted_analog_inputs && hasConvertedAnalogInputUpdate();
+    result.encoder_counters = !encoder_counters && hasEncoderCounterUpdate();
+    return result;
+}
+
+BatchUpdate DriverBase::processMessages(vector<canbus::Message> const& messages) {
+    return processMessages(messages.data(), messages.size());
+}
+
 bool DriverBase::hasAnalogInputUpdate() const {
     return m_expected_analog_inputs_mask == m_received_analog_inputs_mask;
 }
@@ -100,6 +606,18 @@ void DriverBase::resetConvertedAnalogInputTracking() {
     m_received_converted_analog_inputs_mask = 0;
 }
 
+int16_t DriverBase::getAnalogInput(int index) const {
+    return get<AnalogInput>(0, index + 1);
+}
+
+int16_t DriverBase::getConvertedAnalogInput(int index) const {
+    return get<ConvertedAnalogInput>(0, index + 1);
+}
+
+int32_t DriverBase::getEncoderCounter(int index) const {
+    return get<EncoderCounter>(0, index + 1);
+}
+
 canbus::Message DriverBase::queryAnalogInput(int index) const {
     return queryUpload<AnalogInput>(0, index + 1);
 }
@@ -128,7 +646,21 @@ vector<canbus::Message> DriverBase::queryControllerStatus() {
     return queries;
 }
 
+/** Time elapsed since a field has been received, or base::Time::max() if it
+ * never was
+ */
+static base::Time getFieldAge(base::Time const& now, base::Time const& received) {
+    if (received.isNull()) {
+        return base::Time::max();
+    }
+    return now - received;
+}
+
 ControllerStatus DriverBase::getControllerStatus() const {
+    return getControllerStatus(base::Time::now());
+}
+
+ControllerStatus DriverBase::getControllerStatus(base::Time const& now) const {
     ControllerStatus status;
     status.voltage_internal = static_cast<float>(get<VoltageInternal>()) / 10;
     status.voltage_battery = static_cast<float>(get<VoltageBattery>()) / 10;
@@ -146,6 +678,27 @@ ControllerStatus DriverBase::getControllerStatus() const {
     for (size_t i = 0; i < m_channels.size(); ++i) {
         status.channel_status_flags[i] = get<ChannelStatusFlagsRaw>(0, i);
     }
+
+    status.voltage_internal_age =
+        getFieldAge(now, m_status_field_times[STATUS_FIELD_VOLTAGE_INTERNAL]);
+    status.voltage_battery_age =
+        getFieldAge(now, m_status_field_times[STATUS_FIELD_VOLTAGE_BATTERY]);
+    status.voltage_5v_age =
+        getFieldAge(now, m_status_field_times[STATUS_FIELD_VOLTAGE_5V]);
+    status.temperature_mcu_age =
+        getFieldAge(now, m_status_field_times[STATUS_FIELD_TEMPERATURE_MCU]);
+    status.status_flags_age =
+        getFieldAge(now, m_status_field_times[STATUS_FIELD_STATUS_FLAGS]);
+    status.fault_flags_age =
+        getFieldAge(now, m_status_field_times[STATUS_FIELD_FAULT_FLAGS]);
+    for (size_t i = 0; i < m_channels.size(); ++i) {
+        status.temperature_sensor_ages.push_back(
+            getFieldAge(now, m_temperature_sensor_times[i])
+        );
+        status.channel_status_flags_ages.push_back(
+            getFieldAge(now, m_channel_status_flags_times[i])
+        );
+    }
     return status;
 }
 
@@ -159,12 +712,10 @@ int DriverBase::setupJointStateTPDOs(vector<canbus::Message>& messages,
     int pdoIndex = pdoStartIndex;
     for (auto channel : m_channels) {
         vector<PDOMapping> mappings = channel->getJointStateTPDOMapping();
-        for (size_t i = 0; i < mappings.size(); ++i, ++pdoIndex) {
-            auto msgs = mCANOpen.configurePDO(
-                true, pdoIndex, parameters, mappings[i]
+        for (auto const& mapping : mappings) {
+            pdoIndex = setupTPDO(
+                mapping, messages, pdoIndex, parameters, PDO_PRIORITY_JOINT_STATE
             );
-            mCANOpen.declareTPDOMapping(pdoIndex, mappings[i]);
-            messages.insert(messages.end(), msgs.begin(), msgs.end());
         }
     }
     return pdoIndex;
@@ -173,68 +724,368 @@ int DriverBase::setupJointStateTPDOs(vector<canbus::Message>& messages,
 int DriverBase::setupJointCommandRPDOs(vector<canbus::Message>& messages,
     int pdoStartIndex, PDOCommunicationParameters const& parameters
 ) {
+    m_rpdo_templates.clear();
+    m_rpdo_fields.clear();
+    m_rpdo_emissions.clear();
+    m_configured_pdos.erase(
+        remove_if(
+            m_configured_pdos.begin(), m_configured_pdos.end(),
+            [](ConfiguredPDO const& pdo) { return !pdo.transmit; }
+        ),
+        m_configured_pdos.end()
+    );
+
     int pdoIndex = pdoStartIndex;
     for (auto const channel : m_channels) {
         vector<PDOMapping> mappings = channel->getJointCommandRPDOMapping();
         for (size_t i = 0; i < mappings.size(); ++i, ++pdoIndex) {
-            auto msgs = mCANOpen.configurePDO(
-                false, pdoIndex, parameters, mappings[i]
+            auto msgs = configurePDO(false, pdoIndex, parameters, mappings[i]);
+            admitPDO(
+                false, pdoIndex, mappings[i], parameters, msgs,
+                PDO_PRIORITY_COMMAND
             );
             mCANOpen.declareRPDOMapping(pdoIndex, mappings[i]);
-            messages.insert(messages.end(), msgs.begin(), msgs.end());
+            compileRPDOTemplate(mappings[i], msgs, pdoIndex);
+            appendPDOSetup(false, pdoIndex, msgs, messages);
         }
     }
-    m_rpdo_begin = pdoStartIndex;
-    m_rpdo_end = pdoIndex;
     return pdoIndex;
 }
 
 int DriverBase::setupTPDO(
     PDOMapping mapping, vector<canbus::Message>& messages, int pdoIndex,
-    PDOCommunicationParameters const& parameters
+    PDOCommunicationParameters const& parameters, PDOPriorityClass priority_class
 ) {
-    auto msgs = mCANOpen.configurePDO(true, pdoIndex, parameters, mapping);
-    messages.insert(messages.end(), msgs.begin(), msgs.end());
+    auto msgs = configurePDO(true, pdoIndex, parameters, mapping);
+    admitPDO(true, pdoIndex, mapping, parameters, msgs, priority_class);
+    appendPDOSetup(true, pdoIndex, msgs, messages);
     mCANOpen.declareTPDOMapping(pdoIndex, mapping);
+    compileTPDODecoder(mapping, msgs, pdoIndex);
     return pdoIndex + 1;
 }
 
-int DriverBase::setupAnalogTPDOsInternal(
-    uint32_t const mask, int objectOffset, std::vector<canbus::Message>& messages,
-    int pdoIndex, canopen_master::PDOCommunicationParameters const& parameters
+static bool isSameMessage(canbus::Message const& a, canbus::Message const& b) {
+    return a.can_id == b.can_id && a.size == b.size &&
+           std::equal(a.data, a.data + a.size, b.data);
+}
+
+/** Whether a setup message writes to the given object, and optionally to the
+ * given sub-index
+ */
+static bool isWriteTo(canbus::Message const& msg, int objectId, int subId = -1) {
+    if (canopen_master::getSDOCommand(msg).command !=
+        canopen_master::SDO_INITIATE_DOMAIN_DOWNLOAD) {
+        return false;
+    }
+    return canopen_master::getSDOObjectID(msg) == objectId &&
+           (subId < 0 || canopen_master::getSDOObjectSubID(msg) == subId);
+}
+
+void DriverBase::appendPDOSetup(
+    bool transmit, int pdoIndex, vector<canbus::Message> const& setup,
+    vector<canbus::Message>& messages
 ) {
-    bool first = true;
-    PDOMapping mapping;
-    for (int i = 0; i < 32; ++i) {
-        if (!(mask & (1 << i))) {
+    auto& active = (transmit ? m_active_tpdo_setups : m_active_rpdo_setups)[pdoIndex];
+    vector<canbus::Message> previous;
+    previous.swap(active);
+    active = setup;
+
+    if (!m_incremental_pdo_setup || previous.empty()) {
+        messages.insert(messages.end(), setup.begin(), setup.end());
+        return;
+    }
+
+    // Split the messages between the communication parameters that CiA 301
+    // allows to change while the PDO is enabled (transmission type and event
+    // timer), and the rest. The COB-ID, inhibit time and SYNC start value can
+    // only be written while the PDO is disabled, so changing any of them
+    // requires the full sequence
+    int parametersObjectId = pdoIndex +
+        (transmit ? TPDO_PARAMETERS_OBJECT_ID : RPDO_PARAMETERS_OBJECT_ID);
+    auto isParameter = [parametersObjectId](canbus::Message const& msg) {
+        return isWriteTo(msg, parametersObjectId, 2) ||
+               isWriteTo(msg, parametersObjectId, 5);
+    };
+
+    vector<canbus::Message> mapping, previousMapping;
+    for (auto const& msg : setup) {
+        if (!isParameter(msg)) {
+            mapping.push_back(msg);
+        }
+    }
+    for (auto const& msg : previous) {
+        if (!isParameter(msg)) {
+            previousMapping.push_back(msg);
+        }
+    }
+
+    if (mapping.size() != previousMapping.size() ||
+        !std::equal(mapping.begin(), mapping.end(), previousMapping.begin(),
+                    isSameMessage)) {
+        messages.insert(messages.end(), setup.begin(), setup.end());
+        return;
+    }
+
+    for (auto const& msg : setup) {
+        if (!isParameter(msg)) {
+            continue;
+        }
+        bool unchanged = std::any_of(
+            previous.begin(), previous.end(),
+            [&msg](canbus::Message const& p) { return isSameMessage(msg, p); }
+        );
+        if (!unchanged) {
+            messages.push_back(msg);
+        }
+    }
+}
+
+void DriverBase::setIncrementalPDOSetup(bool enable) {
+    m_incremental_pdo_setup = enable;
+}
+
+void DriverBase::resetActivePDOSetup() {
+    m_active_tpdo_setups.clear();
+    m_active_rpdo_setups.clear();
+}
+
+/** Re-emit the last COB-ID write of a PDO setup with the 'invalid' bit set
+ *
+ * @return false if the setup has no COB-ID write
+ */
+static bool appendPDODisable(
+    vector<canbus::Message>& messages, vector<canbus::Message> const& setup,
+    int parametersObjectId
+) {
+    for (auto msg = setup.rbegin(); msg != setup.rend(); ++msg) {
+        if (isWriteTo(*msg, parametersObjectId, 1)) {
+            canbus::Message disable = *msg;
+            disable.data[7] |= 0x80;
+            messages.push_back(disable);
+            return true;
+        }
+    }
+    return false;
+}
+
+void DriverBase::disablePDO(
+    vector<canbus::Message>& messages, bool transmit, int pdoIndex
+) const {
+    int parametersObjectId = pdoIndex +
+        (transmit ? TPDO_PARAMETERS_OBJECT_ID : RPDO_PARAMETERS_OBJECT_ID);
+    auto const& active = transmit ? m_active_tpdo_setups : m_active_rpdo_setups;
+    auto it = active.find(pdoIndex);
+    if (it != active.end() &&
+        appendPDODisable(messages, it->second, parametersObjectId)) {
+        return;
+    }
+
+    for (auto const& pdo : m_configured_pdos) {
+        if (pdo.transmit == transmit && pdo.index == pdoIndex && pdo.cob_id >= 0) {
+            messages.push_back(mCANOpen.download<uint32_t>(
+                parametersObjectId, 1, pdo.cob_id | 0x80000000
+            ));
+            return;
+        }
+    }
+}
+
+void DriverBase::disablePDOsFrom(
+    vector<canbus::Message>& messages, bool transmit, int pdoIndex
+) {
+    auto& active = transmit ? m_active_tpdo_setups : m_active_rpdo_setups;
+    auto it = active.lower_bound(pdoIndex);
+    while (it != active.end()) {
+        int parametersObjectId = it->first +
+            (transmit ? TPDO_PARAMETERS_OBJECT_ID : RPDO_PARAMETERS_OBJECT_ID);
+        int cobId = findPDOCOBId(it->second, parametersObjectId);
+        appendPDODisable(messages, it->second, parametersObjectId);
+
+        int index = it->first;
+        if (transmit) {
+            m_tpdo_decoders.erase(cobId);
+            m_tpdo_decoder_cob_ids.erase(index);
+            ++m_tpdo_decoder_generation;
+        }
+        m_configured_pdos.erase(
+            remove_if(
+                m_configured_pdos.begin(), m_configured_pdos.end(),
+                [transmit, index](ConfiguredPDO const& pdo) {
+                    return pdo.transmit == transmit && pdo.index == index;
+                }
+            ),
+            m_configured_pdos.end()
+        );
+        it = active.erase(it);
+    }
+}
+
+static const uint32_t FNV1A_OFFSET_BASIS = 2166136261u;
+static const uint32_t FNV1A_PRIME = 16777619u;
+
+static uint32_t hashFNV1a(uint32_t hash, uint8_t byte) {
+    return (hash ^ byte) * FNV1A_PRIME;
+}
+
+static uint32_t hashSetups(
+    uint32_t hash, map<int, vector<canbus::Message>> const& setups
+) {
+    for (auto const& setup : setups) {
+        for (auto const& msg : setup.second) {
+            for (int i = 0; i < 4; ++i) {
+                hash = hashFNV1a(hash, (msg.can_id >> (8 * i)) & 0xFF);
+            }
+            hash = hashFNV1a(hash, msg.size);
+            for (int i = 0; i < msg.size; ++i) {
+                hash = hashFNV1a(hash, msg.data[i]);
+            }
+        }
+    }
+    return hash;
+}
+
+uint32_t DriverBase::getPDOSetupFingerprint() const {
+    uint32_t hash = hashSetups(FNV1A_OFFSET_BASIS, m_active_tpdo_setups);
+    // Separate the TPDOs from the RPDOs
+    hash = hashFNV1a(hash, 0xFF);
+    hash = hashSetups(hash, m_active_rpdo_setups);
+    // Zero marks an invalidated fingerprint
+    return hash ? hash : 1;
+}
+
+canbus::Message DriverBase::queryPDOFingerprintUpload(int variable) const {
+    return queryUpload<UserIntegerVariable>(0, variable - 1);
+}
+
+canbus::Message DriverBase::queryPDOFingerprintDownload(int variable) const {
+    return queryDownload<SetUserIntegerVariable>(
+        static_cast<int32_t>(getPDOSetupFingerprint()), 0, variable - 1
+    );
+}
+
+canbus::Message DriverBase::queryPDOFingerprintInvalidate(int variable) const {
+    return queryDownload<SetUserIntegerVariable>(0, 0, variable - 1);
+}
+
+bool DriverBase::isPDOSetupCurrent(int variable) const {
+    int32_t stored;
+    try {
+        stored = get<UserIntegerVariable>(0, variable - 1);
+    }
+    catch (std::exception const&) {
+        return false;
+    }
+    return static_cast<uint32_t>(stored) == getPDOSetupFingerprint();
+}
+
+vector<canbus::Message> DriverBase::preparePDOSetup(
+    vector<canbus::Message> const& setupMessages, int variable
+) const {
+    vector<canbus::Message> messages;
+    if (isPDOSetupCurrent(variable)) {
+        return messages;
+    }
+
+    messages.reserve(setupMessages.size() + 2);
+    messages.push_back(queryPDOFingerprintInvalidate(variable));
+    messages.insert(messages.end(), setupMessages.begin(), setupMessages.end());
+    messages.push_back(queryPDOFingerprintDownload(variable));
+    return messages;
+}
+
+vector<canbus::Message> DriverBase::configurePDO(
+    bool transmit, int pdoIndex, PDOCommunicationParameters const& parameters,
+    PDOMapping const& mapping
+) {
+    auto msgs = mCANOpen.configurePDO(transmit, pdoIndex, parameters, mapping);
+
+    auto const& overrides = transmit ? m_tpdo_cob_ids : m_rpdo_cob_ids;
+    auto it = overrides.find(pdoIndex);
+    if (it == overrides.end()) {
+        return msgs;
+    }
+
+    int parametersObjectId = pdoIndex +
+        (transmit ? TPDO_PARAMETERS_OBJECT_ID : RPDO_PARAMETERS_OBJECT_ID);
+    for (auto& msg : msgs) {
+        if (!isWriteTo(msg, parametersObjectId, 1)) {
             continue;
         }
 
-        mapping.add<AnalogInput>(objectOffset, i + 1);
-        if (!first) {
-            pdoIndex = setupTPDO(mapping, messages, pdoIndex, parameters);
-            mapping = PDOMapping();
+        // Replace the 11-bit CAN ID, keeping the valid and RTR bits
+        msg.data[4] = it->second & 0xFF;
+        msg.data[5] = (msg.data[5] & 0xF8) | ((it->second >> 8) & 0x7);
+    }
+    return msgs;
+}
+
+void DriverBase::admitPDO(
+    bool transmit, int index, PDOMapping const& mapping,
+    PDOCommunicationParameters const& parameters,
+    vector<canbus::Message> const& setupMessages, PDOPriorityClass priority_class
+) {
+    int size = 0;
+    for (auto const& object : mapping.mappings) {
+        size += object.size;
+    }
+    int cobId = findPDOCOBId(
+        setupMessages,
+        index + (transmit ? TPDO_PARAMETERS_OBJECT_ID : RPDO_PARAMETERS_OBJECT_ID)
+    );
+    ConfiguredPDO pdo = {
+        transmit, index, size, parameters, cobId, priority_class
+    };
+
+    vector<ConfiguredPDO> pdos;
+    for (auto const& configured : m_configured_pdos) {
+        if (configured.transmit != transmit || configured.index != index) {
+            pdos.push_back(configured);
         }
+    }
+    pdos.push_back(pdo);
 
-        first = !first;
+    if (m_has_bus_load_budget) {
+        BusLoad load(m_bus_load_model);
+        for (auto const& configured : pdos) {
+            if (configured.transmit) {
+                load.addTPDO(0, configured.size, configured.parameters);
+            }
+            else {
+                load.addRPDO(0, configured.size);
+            }
+        }
+        load.checkBudget(m_bus_load_budget);
     }
+    m_configured_pdos = pdos;
+}
 
-    if (!first) {
-        pdoIndex = setupTPDO(mapping, messages, pdoIndex, parameters);
+template<typename T>
+int DriverBase::setupAnalogTPDOsInternal(
+    uint32_t const mask, std::vector<canbus::Message>& messages,
+    int pdoIndex, canopen_master::PDOCommunicationParameters const& parameters
+) {
+    TPDOPlanner planner(MAX_TPDO_COUNT - pdoIndex);
+    for (int i = 0; i < 32; ++i) {
+        if (mask & (1 << i)) {
+            planner.add<T>(0, i + 1);
+        }
     }
 
+    for (auto const& mapping : planner.plan()) {
+        pdoIndex = setupTPDO(
+            mapping, messages, pdoIndex, parameters, PDO_PRIORITY_ANALOG
+        );
+    }
     return pdoIndex;
 }
 
 int DriverBase::setupAnalogTPDOs(std::vector<canbus::Message>& messages,
     int pdoIndex, canopen_master::PDOCommunicationParameters const& parameters) {
-    pdoIndex = setupAnalogTPDOsInternal(
-        m_expected_analog_inputs_mask, 0, messages,
-        pdoIndex, parameters
+    pdoIndex = setupAnalogTPDOsInternal<AnalogInput>(
+        m_expected_analog_inputs_mask, messages, pdoIndex, parameters
     );
-    pdoIndex = setupAnalogTPDOsInternal(
-        m_expected_converted_analog_inputs_mask, 1, messages,
-        pdoIndex, parameters
+    pdoIndex = setupAnalogTPDOsInternal<ConvertedAnalogInput>(
+        m_expected_converted_analog_inputs_mask, messages, pdoIndex, parameters
     );
     return pdoIndex;
 }
@@ -250,7 +1101,9 @@ int DriverBase::setupEncoderTPDOs(std::vector<canbus::Message>& messages,
 
         mapping.add<EncoderCounter>(0, i + 1);
         if (!first) {
-            pdoIndex = setupTPDO(mapping, messages, pdoIndex, parameters);
+            pdoIndex = setupTPDO(
+                mapping, messages, pdoIndex, parameters, PDO_PRIORITY_ENCODER
+            );
             mapping = PDOMapping();
         }
 
@@ -258,7 +1111,9 @@ int DriverBase::setupEncoderTPDOs(std::vector<canbus::Message>& messages,
     }
 
     if (!first) {
-        pdoIndex = setupTPDO(mapping, messages, pdoIndex, parameters);
+        pdoIndex = setupTPDO(
+            mapping, messages, pdoIndex, parameters, PDO_PRIORITY_ENCODER
+        );
     }
 
     return pdoIndex;
@@ -267,30 +1122,133 @@ int DriverBase::setupEncoderTPDOs(std::vector<canbus::Message>& messages,
 int DriverBase::setupStatusTPDOs(std::vector<canbus::Message>& messages,
     int pdoIndex, canopen_master::PDOCommunicationParameters const& parameters
 ) {
-    {
-        PDOMapping mapping;
-        mapping.add<StatusFlagsRaw>();
-        mapping.add<FaultFlagsRaw>();
-        mapping.add<VoltageInternal>();
-        mapping.add<VoltageBattery>();
-        auto msgs = mCANOpen.configurePDO(true, pdoIndex, parameters, mapping);
-        messages.insert(messages.end(), msgs.begin(), msgs.end());
-        mCANOpen.declareTPDOMapping(pdoIndex, mapping);
-    }
-
-    {
-        PDOMapping mapping;
-        mapping.add<Voltage5V>();
-        mapping.add<TemperatureMCU>();
+    TPDOPlanner planner(MAX_TPDO_COUNT - pdoIndex);
+    planner.add<StatusFlagsRaw>();
+    planner.add<FaultFlagsRaw>();
+    planner.add<VoltageInternal>();
+    planner.add<VoltageBattery>();
+    planner.add<Voltage5V>();
+    planner.add<TemperatureMCU>();
+    for (size_t i = 0; i < m_channels.size(); ++i) {
+        planner.add<TemperatureSensor0>(0, i);
+    }
+
+    for (auto const& mapping : planner.plan()) {
+        pdoIndex = setupTPDO(
+            mapping, messages, pdoIndex, parameters, PDO_PRIORITY_STATUS
+        );
+    }
+    return pdoIndex;
+}
+
+int DriverBase::setupStatusFlagsTPDOs(std::vector<canbus::Message>& messages,
+    int pdoIndex, canopen_master::PDOCommunicationParameters const& parameters
+) {
+    PDOMapping mapping;
+    mapping.add<StatusFlagsRaw>();
+    mapping.add<FaultFlagsRaw>();
+    return setupTPDO(
+        mapping, messages, pdoIndex, parameters, PDO_PRIORITY_STATUS
+    );
+}
+
+int DriverBase::setupHousekeepingTPDOs(std::vector<canbus::Message>& messages,
+    int pdoIndex, canopen_master::PDOCommunicationParameters const& parameters
+) {
+    TPDOPlanner planner(MAX_TPDO_COUNT - pdoIndex);
+    planner.add<VoltageInternal>();
+    planner.add<VoltageBattery>();
+    planner.add<Voltage5V>();
+    planner.add<TemperatureMCU>();
+    for (size_t i = 0; i < m_channels.size(); ++i) {
+        planner.add<TemperatureSensor0>(0, i);
+    }
+
+    for (auto const& mapping : planner.plan()) {
+        pdoIndex = setupTPDO(
+            mapping, messages, pdoIndex, parameters, PDO_PRIORITY_HOUSEKEEPING
+        );
+    }
+    return pdoIndex;
+}
+
+int DriverBase::setupTieredTPDOs(std::vector<canbus::Message>& messages,
+    int pdoIndex, TPDORateTiers const& tiers
+) {
+    pdoIndex = setupJointStateTPDOs(messages, pdoIndex, tiers.joint_state);
+    pdoIndex = setupStatusFlagsTPDOs(messages, pdoIndex, tiers.status);
+    return setupHousekeepingTPDOs(messages, pdoIndex, tiers.housekeeping);
+}
+
+TPDOPlanner DriverBase::planTPDOs(int contents, int pdoStartIndex) const {
+    TPDOPlanner planner(MAX_TPDO_COUNT - pdoStartIndex);
+    if (contents & TPDO_JOINT_STATE) {
+        for (auto channel : m_channels) {
+            for (auto const& mapping : channel->getJointStateTPDOMapping()) {
+                planner.add(mapping);
+            }
+        }
+    }
+
+    if (contents & TPDO_STATUS) {
+        planner.add<StatusFlagsRaw>();
+        planner.add<FaultFlagsRaw>();
+        planner.add<VoltageInternal>();
+        planner.add<VoltageBattery>();
+        planner.add<Voltage5V>();
+        planner.add<TemperatureMCU>();
         for (size_t i = 0; i < m_channels.size(); ++i) {
-            mapping.add<TemperatureSensor0>(0, i);
+            planner.add<TemperatureSensor0>(0, i);
+        }
+    }
+
+    if (contents & TPDO_ENCODERS) {
+        for (int i = 0; i < 32; ++i) {
+            if (m_expected_encoder_counter_mask & (1 << i)) {
+                planner.add<EncoderCounter>(0, i + 1);
+            }
+        }
+    }
+
+    if (contents & TPDO_ANALOG_INPUTS) {
+        for (int i = 0; i < 32; ++i) {
+            if (m_expected_analog_inputs_mask & (1 << i)) {
+                planner.add<AnalogInput>(0, i + 1);
+            }
         }
+        for (int i = 0; i < 32; ++i) {
+            if (m_expected_converted_analog_inputs_mask & (1 << i)) {
+                planner.add<ConvertedAnalogInput>(0, i + 1);
+            }
+        }
+    }
+    return planner;
+}
 
-        auto msgs = mCANOpen.configurePDO(true, pdoIndex + 1, parameters, mapping);
-        messages.insert(messages.end(), msgs.begin(), msgs.end());
-        mCANOpen.declareTPDOMapping(pdoIndex + 1, mapping);
+int DriverBase::setupPackedTPDOs(std::vector<canbus::Message>& messages,
+    int pdoIndex, canopen_master::PDOCommunicationParameters const& parameters,
+    int contents
+) {
+    // Packed PDOs mix objects, give them the priority of the most urgent
+    // contents
+    PDOPriorityClass priority_class = PDO_PRIORITY_ANALOG;
+    if (contents & TPDO_JOINT_STATE) {
+        priority_class = PDO_PRIORITY_JOINT_STATE;
     }
-    return pdoIndex + 2;
+    else if (contents & TPDO_ENCODERS) {
+        priority_class = PDO_PRIORITY_ENCODER;
+    }
+    else if (contents & TPDO_STATUS) {
+        priority_class = PDO_PRIORITY_STATUS;
+    }
+
+    auto mappings = planTPDOs(contents, pdoIndex).plan();
+    for (auto const& mapping : mappings) {
+        pdoIndex = setupTPDO(
+            mapping, messages, pdoIndex, parameters, priority_class
+        );
+    }
+    return pdoIndex;
 }
 
 void DriverBase::setJointCommand(base::samples::Joints const& command) {
@@ -324,14 +1282,196 @@ base::samples::Joints DriverBase::getJointCommand() const {
     return command;
 }
 
+size_t DriverBase::getNonIgnoredChannelCount() const {
+    size_t count = 0;
+    for (auto channel : m_channels) {
+        if (!channel->isIgnored()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void DriverBase::setJointNames(std::vector<std::string> const& names) {
+    if (!names.empty() && names.size() != getNonIgnoredChannelCount()) {
+        throw std::invalid_argument(
+            "expected one joint name per non-ignored channel"
+        );
+    }
+    m_joint_names = names;
+}
+
+void DriverBase::readJointState(base::samples::Joints& joints) const {
+    size_t count = getNonIgnoredChannelCount();
+    if (!m_joint_names.empty() && m_joint_names.size() != count) {
+        throw std::invalid_argument(
+            "the number of joint names does not match the number of "
+            "non-ignored channels"
+        );
+    }
+    if (joints.elements.size() != count) {
+        joints.elements.resize(count);
+    }
+    if (joints.names.size() != m_joint_names.size()) {
+        joints.names = m_joint_names;
+    }
+
+    size_t i = 0;
+    base::Time time;
+    for (auto channel : m_channels) {
+        if (channel->isIgnored()) {
+            continue;
+        }
+
+        joints.elements[i++] = channel->getJointState();
+        base::Time newest = channel->getJointStateTimestamps().newest;
+        if (newest > time) {
+            time = newest;
+        }
+    }
+    joints.time = time;
+}
+
 std::vector<canbus::Message> DriverBase::getRPDOMessages() const {
     std::vector<canbus::Message> messages;
-    for (int i = m_rpdo_begin; i != m_rpdo_end; ++i) {
-        messages.push_back(mCANOpen.getRPDOMessage(i));
-    }
+    getRPDOMessages(messages);
     return messages;
 }
 
+void DriverBase::getRPDOMessages(std::vector<canbus::Message>& messages) const {
+    messages.insert(
+        messages.end(), m_rpdo_templates.begin(), m_rpdo_templates.end()
+    );
+}
+
+size_t DriverBase::getRPDOMessages(
+    canbus::Message* buffer, size_t capacity
+) const {
+    if (capacity < m_rpdo_templates.size()) {
+        throw std::invalid_argument("RPDO buffer too small");
+    }
+    std::copy(m_rpdo_templates.begin(), m_rpdo_templates.end(), buffer);
+    return m_rpdo_templates.size();
+}
+
+size_t DriverBase::getRPDOCount() const {
+    return m_rpdo_templates.size();
+}
+
+size_t DriverBase::getChangedRPDOMessages(
+    canbus::Message* buffer, size_t capacity, base::Time const& time
+) {
+    if (capacity < m_rpdo_templates.size()) {
+        throw std::invalid_argument("RPDO buffer too small");
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < m_rpdo_templates.size(); ++i) {
+        RPDOEmission& emission = m_rpdo_emissions[i];
+        bool expired =
+            time - emission.last_emission >= emission.keepalive_period;
+        if (!emission.dirty && !expired) {
+            ++m_suppressed_rpdo_count;
+            continue;
+        }
+
+        buffer[count++] = m_rpdo_templates[i];
+        emission.dirty = false;
+        emission.last_emission = time;
+    }
+    return count;
+}
+
+void DriverBase::setRPDOKeepalivePeriod(int index, base::Time const& period) {
+    m_rpdo_emissions.at(index).keepalive_period = period;
+    m_rpdo_keepalive_periods[index] = period;
+}
+
+void DriverBase::setRPDOKeepalivePeriod(base::Time const& period) {
+    m_rpdo_keepalive_period = period;
+    m_rpdo_keepalive_periods.clear();
+    for (auto& emission : m_rpdo_emissions) {
+        emission.keepalive_period = period;
+    }
+}
+
+vector<DriverBase::ConfiguredPDO> const& DriverBase::getConfiguredPDOs() const {
+    return m_configured_pdos;
+}
+
+bool DriverBase::hasTPDODecoder(uint32_t cob_id) const {
+    return m_tpdo_decoders.find(cob_id) != m_tpdo_decoders.end();
+}
+
+uint64_t DriverBase::getTPDODecoderGeneration() const {
+    return m_tpdo_decoder_generation;
+}
+
+void DriverBase::addToBusLoad(BusLoad& load) const {
+    for (auto const& pdo : m_configured_pdos) {
+        if (pdo.transmit) {
+            load.addTPDO(mCANOpen.nodeId, pdo.size, pdo.parameters);
+        }
+        else {
+            load.addRPDO(mCANOpen.nodeId, pdo.size);
+        }
+    }
+}
+
+void DriverBase::setBusLoadBudget(BusLoadModel const& model, double max_utilization) {
+    m_bus_load_model = model;
+    m_bus_load_budget = max_utilization;
+    m_has_bus_load_budget = true;
+}
+
+void DriverBase::clearBusLoadBudget() {
+    m_has_bus_load_budget = false;
+}
+
+vector<ScheduledFrame> DriverBase::getScheduledFrames(BusLoadModel const& model) const {
+    vector<ScheduledFrame> frames;
+    for (auto const& pdo : m_configured_pdos) {
+        double frequency = pdo.transmit ?
+            model.getTPDOFrequency(pdo.parameters) : model.getRPDOFrequency();
+        if (frequency == 0) {
+            continue;
+        }
+
+        ScheduledFrame frame;
+        frame.node_id = mCANOpen.nodeId;
+        frame.transmit = pdo.transmit;
+        frame.pdo_index = pdo.index;
+        frame.priority_class = pdo.priority_class;
+        frame.cob_id = pdo.cob_id;
+        frame.size = pdo.size;
+        frame.period = base::Time::fromSeconds(1.0 / frequency);
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+void DriverBase::setPDOCOBId(bool transmit, int pdoIndex, int cob_id) {
+    if (cob_id <= 0 || cob_id > 0x7FF) {
+        throw std::invalid_argument("COB-ID out of range");
+    }
+
+    if (transmit) {
+        m_tpdo_cob_ids[pdoIndex] = cob_id;
+    }
+    else {
+        m_rpdo_cob_ids[pdoIndex] = cob_id;
+    }
+}
+
+void DriverBase::clearPDOCOBIds() {
+    m_tpdo_cob_ids.clear();
+    m_rpdo_cob_ids.clear();
+}
+
+uint64_t DriverBase::getSuppressedRPDOCount() const {
+    return m_suppressed_rpdo_count;
+}
+
 std::vector<canbus::Message> DriverBase::queryJointCommandDownload() const {
     std::vector<canbus::Message> messages;
     for (auto channel : m_channels) {
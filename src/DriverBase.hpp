@@ -1,14 +1,77 @@
 #ifndef MOTORS_ROBOTEQ_CANOPEN_BASE_DRIVER_HPP
 #define MOTORS_ROBOTEQ_CANOPEN_BASE_DRIVER_HPP
 
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
 #include <canopen_master/Slave.hpp>
 #include <canopen_master/PDOCommunicationParameters.hpp>
 #include <motors_roboteq_canopen/ControllerStatus.hpp>
 #include <motors_roboteq_canopen/ChannelBase.hpp>
+#include <motors_roboteq_canopen/Listeners.hpp>
+#include <motors_roboteq_canopen/SPSCQueue.hpp>
+#include <motors_roboteq_canopen/Seqlock.hpp>
+#include <motors_roboteq_canopen/DriverStateSnapshot.hpp>
+#include <motors_roboteq_canopen/TPDOPlanner.hpp>
+#include <motors_roboteq_canopen/BusLoad.hpp>
+#include <motors_roboteq_canopen/ResponseTimeAnalysis.hpp>
 #include <base/JointState.hpp>
 #include <base/samples/Joints.hpp>
 
 namespace motors_roboteq_canopen {
+    /** Aggregated result of DriverBase::processMessages
+     *
+     * The fields report the groups that got completed while processing the
+     * batch, i.e. that were not complete before the call and are after
+     */
+    struct BatchUpdate {
+        /** How many messages have been processed */
+        size_t message_count = 0;
+
+        /** Bitmask of the channels whose joint state got completed */
+        uint32_t joint_states = 0;
+
+        /** Whether the analog inputs got completed */
+        bool analog_inputs = false;
+
+        /** Whether the converted analog inputs got completed */
+        bool converted_analog_inputs = false;
+
+        /** Whether the encoder counters got completed */
+        bool encoder_counters = false;
+    };
+
+    /** Joint state of a single channel at the time it got completed
+     *
+     * @see DriverBase::enableJointStateQueue
+     */
+    struct JointStateSnapshot {
+        /** Reception time of the message that completed the joint state */
+        base::Time time;
+        /** Index of the channel in the driver */
+        int channel = -1;
+        base::JointState state;
+    };
+
+    /** TPDO communication parameters of each rate tier
+     *
+     * @see DriverBase::setupTieredTPDOs
+     */
+    struct TPDORateTiers {
+        /** The joint state TPDOs, by default sent at every SYNC */
+        canopen_master::PDOCommunicationParameters joint_state;
+        /** The status and fault flags TPDO, by default sent every 10 SYNCs */
+        canopen_master::PDOCommunicationParameters status;
+        /** The voltages and temperatures TPDOs, by default sent every second
+         * regardless of the SYNC
+         */
+        canopen_master::PDOCommunicationParameters housekeeping;
+
+        TPDORateTiers();
+    };
+
     /**
      * Common CANOpen-related functionality for DS402 and direct CANOpen protocols
      *
@@ -19,6 +82,7 @@ namespace motors_roboteq_canopen {
     class DriverBase : public canopen_master::Slave {
     private:
         std::vector<ChannelBase*> m_channels;
+        std::vector<std::string> m_joint_names;
 
         int m_joint_state_sync_period;
         base::Time m_joint_state_period;
@@ -32,19 +96,265 @@ namespace motors_roboteq_canopen {
         uint32_t m_received_converted_analog_inputs_mask = 0;
         uint32_t m_expected_converted_analog_inputs_mask = 0;
 
-        int m_rpdo_begin = 0;
-        int m_rpdo_end = 0;
+        /** A field of a precompiled RPDO */
+        struct RPDOField {
+            uint16_t message_index;
+            uint8_t offset;
+            uint8_t size;
+        };
+
+        /** Pre-encoded RPDOs, in PDO order
+         *
+         * @see setupJointCommandRPDOs setRPDOObject
+         */
+        std::vector<canbus::Message> m_rpdo_templates;
+
+        /** Location of the RPDO-mapped objects in m_rpdo_templates, indexed
+         * by (object id, sub id)
+         */
+        std::unordered_map<uint32_t, RPDOField> m_rpdo_fields;
+
+        /** Emission state of a pre-encoded RPDO
+         *
+         * @see getChangedRPDOMessages
+         */
+        struct RPDOEmission {
+            /** Whether the payload changed since the RPDO was last emitted */
+            bool dirty = true;
+            base::Time last_emission;
+            base::Time keepalive_period;
+        };
+
+        /** Emission state of each entry in m_rpdo_templates */
+        std::vector<RPDOEmission> m_rpdo_emissions;
+
+        /** Keepalive period of the RPDOs that have no specific one
+         *
+         * These are kept separately from m_rpdo_emissions so that they
+         * survive a new call to setupJointCommandRPDOs
+         */
+        base::Time m_rpdo_keepalive_period;
+
+        /** Keepalive periods set for specific RPDOs, indexed by the RPDO's
+         * index in m_rpdo_templates
+         */
+        std::map<int, base::Time> m_rpdo_keepalive_periods;
+
+        /** How many RPDOs getChangedRPDOMessages did not emit */
+        uint64_t m_suppressed_rpdo_count = 0;
+
+    public:
+        /** A PDO configured by one of the setup methods */
+        struct ConfiguredPDO {
+            /** True for a TPDO, false for a RPDO */
+            bool transmit;
+            int index;
+            /** Payload size in bytes */
+            int size;
+            canopen_master::PDOCommunicationParameters parameters;
+            int cob_id;
+            PDOPriorityClass priority_class;
+        };
+
+    private:
+        std::vector<ConfiguredPDO> m_configured_pdos;
+
+        bool m_incremental_pdo_setup = false;
+
+        /** Setup messages of the configuration currently active on each
+         * PDO, indexed by PDO index
+         */
+        std::map<int, std::vector<canbus::Message>> m_active_tpdo_setups;
+        std::map<int, std::vector<canbus::Message>> m_active_rpdo_setups;
+
+        /** Append to \c messages the setup messages of a PDO, and record
+         * them as the PDO's active configuration
+         *
+         * If incremental setup is enabled, only the messages needed to go
+         * from the active configuration to the new one are appended
+         */
+        void appendPDOSetup(
+            bool transmit, int pdoIndex, std::vector<canbus::Message> const& setup,
+            std::vector<canbus::Message>& messages
+        );
+
+        /** COB-IDs set by setPDOCOBId, indexed by PDO index */
+        std::map<int, int> m_tpdo_cob_ids;
+        std::map<int, int> m_rpdo_cob_ids;
+
+        /** Generate the messages configuring a PDO, applying the COB-ID set
+         * by setPDOCOBId if there is one
+         */
+        std::vector<canbus::Message> configurePDO(
+            bool transmit, int pdoIndex,
+            canopen_master::PDOCommunicationParameters const& parameters,
+            canopen_master::PDOMapping const& mapping
+        );
+
+        bool m_has_bus_load_budget = false;
+        BusLoadModel m_bus_load_model;
+        double m_bus_load_budget = 0;
+
+        /** Record a new PDO in m_configured_pdos
+         *
+         * @throw BusOverload if the PDO would make the node exceed its bus
+         *   load budget, in which case it is not recorded
+         */
+        void admitPDO(
+            bool transmit, int index, canopen_master::PDOMapping const& mapping,
+            canopen_master::PDOCommunicationParameters const& parameters,
+            std::vector<canbus::Message> const& setupMessages,
+            PDOPriorityClass priority_class
+        );
+
+        DriverListener* m_listener = nullptr;
+
+        std::unique_ptr<SPSCQueue<JointStateSnapshot>> m_joint_state_queue;
+        uint64_t m_joint_state_queue_drops = 0;
+
+        /** Reception time of the message being processed */
+        base::Time m_message_time;
+
+        bool m_state_snapshot_enabled = false;
+        bool m_state_snapshot_dirty = false;
+        DriverStateSnapshot m_state_snapshot;
+        Seqlock<DriverStateSnapshot> m_published_state_snapshot;
+
+        /** Driver-level groups of objects tracked by process() */
+        enum TrackingGroups {
+            TRACKING_GROUP_NONE,
+            TRACKING_GROUP_ANALOG_INPUTS,
+            TRACKING_GROUP_CONVERTED_ANALOG_INPUTS,
+            TRACKING_GROUP_ENCODER_COUNTERS
+        };
+
+        /** Controller status fields tracked by process() */
+        enum StatusFields {
+            STATUS_FIELD_NONE,
+            STATUS_FIELD_VOLTAGE_INTERNAL,
+            STATUS_FIELD_VOLTAGE_BATTERY,
+            STATUS_FIELD_VOLTAGE_5V,
+            STATUS_FIELD_TEMPERATURE_MCU,
+            STATUS_FIELD_TEMPERATURE_SENSOR,
+            STATUS_FIELD_STATUS_FLAGS,
+            STATUS_FIELD_FAULT_FLAGS,
+            STATUS_FIELD_CHANNEL_STATUS_FLAGS
+        };
+
+        /** Reception time of the controller-level status fields, indexed
+         * by StatusFields
+         */
+        base::Time m_status_field_times[STATUS_FIELD_CHANNEL_STATUS_FLAGS + 1];
+        /** Reception time of the per-channel status fields */
+        std::vector<base::Time> m_temperature_sensor_times;
+        std::vector<base::Time> m_channel_status_flags_times;
+
+        void recordStatusTime(StatusFields field, int index);
+
+        /** Entry of the object-to-tracking dispatch table
+         *
+         * A single object may contribute both to a channel's joint state and
+         * to one of the driver-level groups (e.g. EncoderCounter)
+         */
+        struct TrackingDispatch {
+            int channel = -1;
+            uint32_t channel_bits = 0;
+            TrackingGroups group = TRACKING_GROUP_NONE;
+            uint32_t group_bits = 0;
+            StatusFields status_field = STATUS_FIELD_NONE;
+            int status_index = 0;
+        };
+
+        /** Mapping from (object id, sub id) to the tracking bits the object
+         * sets, used by process() to avoid scanning the update once per
+         * channel and per tracked object
+         */
+        std::unordered_map<uint32_t, TrackingDispatch> m_tracking_dispatch;
+
+        static uint32_t getTrackingKey(int object_id, int sub_id);
+        void addGroupTrackingDispatch(int object_id, TrackingGroups group);
+        void markGroupUpdates(TrackingGroups group, uint32_t bits);
+        void markChannelUpdates(int channel, uint32_t bits);
+        void addStatusTrackingDispatch(
+            int object_id, int sub_id, StatusFields field, int index = 0
+        );
+        void addChannelTrackingDispatch(int channel_index);
+        void updateStatusSnapshot(StatusFields field, int index);
+        void publishStateSnapshot();
+        canopen_master::StateMachine::Update processMessage(
+            canbus::Message const& message, base::Time const& time
+        );
+        void dispatchUpdate(int object_id, int sub_id);
+
+        /** A field of a precompiled TPDO decoder */
+        struct TPDOField {
+            int object_id;
+            int sub_id;
+            uint8_t offset;
+            uint8_t size;
+            TrackingDispatch tracking;
+        };
+
+        /** Precompiled decoder for a TPDO whose mapping is known
+         *
+         * @see setupTPDO
+         */
+        struct TPDODecoder {
+            uint8_t size = 0;
+            std::vector<TPDOField> fields;
+        };
+
+        /** Decoders of the TPDOs declared by the setup methods, indexed by
+         * their COB-ID
+         */
+        std::unordered_map<uint32_t, TPDODecoder> m_tpdo_decoders;
+
+        /** COB-ID under which the decoder of each TPDO index is registered
+         * in m_tpdo_decoders
+         */
+        std::map<int, uint32_t> m_tpdo_decoder_cob_ids;
+
+        /** Incremented each time m_tpdo_decoders changes */
+        uint64_t m_tpdo_decoder_generation = 0;
+
+        void compileTPDODecoder(
+            canopen_master::PDOMapping const& mapping,
+            std::vector<canbus::Message> const& setupMessages, int pdoIndex
+        );
+        void applyTracking(TrackingDispatch const& entry);
+        void compileRPDOTemplate(
+            canopen_master::PDOMapping const& mapping,
+            std::vector<canbus::Message> const& setupMessages, int pdoIndex
+        );
+        void patchRPDOTemplate(int object_id, int sub_id, uint32_t value);
+        canopen_master::StateMachine::Update decodeTPDO(
+            TPDODecoder const& decoder, canbus::Message const& message
+        );
+
+        /** Bitmask of the channels for which hasJointStateUpdate is true */
+        uint32_t getCompletedJointStates() const;
+
+        /** Number of channels that are not ignored */
+        size_t getNonIgnoredChannelCount() const;
 
         canopen_master::PDOCommunicationParameters
             getJointStateTPDOParameters();
 
         int setupTPDO(
             canopen_master::PDOMapping mapping, std::vector<canbus::Message>& messages,
-            int pdoIndex, canopen_master::PDOCommunicationParameters const& parameters
+            int pdoIndex, canopen_master::PDOCommunicationParameters const& parameters,
+            PDOPriorityClass priority_class
         );
 
+        /** Setup the TPDOs of the analog inputs in \c mask, packing four
+         * inputs per PDO
+         *
+         * @tparam T the analog input object, AnalogInput or
+         *   ConvertedAnalogInput
+         */
+        template<typename T>
         int setupAnalogTPDOsInternal(
-            uint32_t const mask, int objectOffset, std::vector<canbus::Message>& messages,
+            uint32_t const mask, std::vector<canbus::Message>& messages,
             int pdoIndex, canopen_master::PDOCommunicationParameters const& parameters
         );
 
@@ -55,10 +365,60 @@ namespace motors_roboteq_canopen {
         DriverBase(canopen_master::StateMachine& state_machine);
         virtual ~DriverBase();
 
+        /** Set an object in the dictionary, updating the pre-encoded RPDOs
+         * that contain it
+         *
+         * Channels set all their command objects through this method, so
+         * that getRPDOMessages only has to copy the pre-encoded frames
+         */
+        template<typename T>
+        void setRPDOObject(typename T::OBJECT_TYPE value, int offset = 0, int sub = 0) {
+            set<T>(value, offset, sub);
+            if (!m_rpdo_fields.empty()) {
+                patchRPDOTemplate(
+                    T::OBJECT_ID + offset, T::OBJECT_SUB_ID + sub,
+                    static_cast<uint32_t>(value)
+                );
+            }
+        }
+
+        /** Process a received CAN message
+         *
+         * It updates the object dictionary as well as the joint state, analog
+         * input and encoder tracking
+         *
+         * TPDOs declared through the setup methods are decoded by decoders
+         * precompiled at setup time. Other messages (SDOs, unknown PDOs, ...)
+         * go through the generic canopen_master processing.
+         */
         canopen_master::StateMachine::Update process(
             canbus::Message const& message
         );
 
+        /** Process a received CAN message, giving its reception time
+         *
+         * The time is recorded as the reception time of the objects the
+         * message updates, see ChannelBase::getJointStateTimestamps. The
+         * single-argument version uses the message's \c time field, or the
+         * current time if it is null.
+         */
+        canopen_master::StateMachine::Update process(
+            canbus::Message const& message, base::Time const& time
+        );
+
+        /** Process a burst of received CAN messages
+         *
+         * This is equivalent to calling process() on each message, but
+         * the completion of the tracked groups is computed once for the whole
+         * batch
+         */
+        BatchUpdate processMessages(
+            canbus::Message const* messages, size_t count
+        );
+
+        /** @overload */
+        BatchUpdate processMessages(std::vector<canbus::Message> const& messages);
+
         /** Return the SDO queries to update the controller status */
         std::vector<canbus::Message> queryControllerStatus();
 
@@ -69,6 +429,76 @@ namespace motors_roboteq_canopen {
          */
         ControllerStatus getControllerStatus() const;
 
+        /** Return the controller status, computing the field ages relative
+         * to the given time
+         *
+         * The no-argument version uses the current time
+         */
+        ControllerStatus getControllerStatus(base::Time const& now) const;
+
+        /** Register an object that will be notified when the joint states
+         * and the driver-level groups get completed
+         *
+         * The listener is not owned by the driver. Set to nullptr to remove
+         * it.
+         */
+        void setListener(DriverListener* listener);
+
+        /** Publish joint state snapshots into a single-producer/single-consumer
+         * queue
+         *
+         * Once enabled, process() pushes a snapshot each time a channel's
+         * joint state gets completed. Another thread can then consume them with
+         * popJointState without locking the driver. If the queue is full, the
+         * new snapshot is dropped.
+         *
+         * A snapshot is pushed each time all the fields of the channel's
+         * joint state have been received again (see
+         * ChannelBase::getJointStateGeneration). The joint state tracking is
+         * left untouched, so hasJointStateUpdate and the readiness of the Bus
+         * keep working on drivers whose queue is enabled.
+         *
+         * This must be called before processing starts
+         *
+         * @param capacity the minimum number of snapshots the queue can hold
+         */
+        void enableJointStateQueue(size_t capacity);
+
+        /** Pop the oldest joint state snapshot from the queue
+         *
+         * This is wait-free and may be called from a thread other than the one
+         * calling process(), as long as only one thread consumes the queue
+         *
+         * @return false if the queue is empty or not enabled
+         */
+        bool popJointState(JointStateSnapshot& snapshot);
+
+        /** How many snapshots got dropped because the queue was full */
+        uint64_t getJointStateQueueDropCount() const;
+
+        /** Maintain a DriverStateSnapshot published through a sequence lock
+         *
+         * Once enabled, process() updates the snapshot with the last complete
+         * joint state of each channel and the controller status objects as they
+         * are received. Any number of threads can then copy it with
+         * readStateSnapshot, without blocking the thread calling process()
+         *
+         * This must be called before processing starts
+         *
+         * @throw std::invalid_argument if the driver has more channels than
+         *   DriverStateSnapshot::MAX_CHANNELS
+         */
+        void enableStateSnapshot();
+
+        /** Copy the last published state snapshot
+         *
+         * This may be called from any thread, concurrently with process()
+         *
+         * @return the snapshot version. It is zero if nothing has been published
+         *   yet, and grows each time a new snapshot is published
+         */
+        uint32_t readStateSnapshot(DriverStateSnapshot& snapshot) const;
+
         /** Return how many channels have been declared on this driver
          */
         size_t getChannelCount() const;
@@ -94,6 +524,9 @@ namespace motors_roboteq_canopen {
          *
          * The inputs must have been configured first with @c setAnalogInputEnableInTPDO
          * or @c setAnalogInputConvertedEnableInTPDO
+         *
+         * The inputs are packed four per PDO, raw and converted inputs being
+         * in separate PDOs
          */
         int setupAnalogTPDOs(
             std::vector<canbus::Message>& messages, int pdoStartIndex,
@@ -125,11 +558,95 @@ namespace motors_roboteq_canopen {
             canopen_master::PDOCommunicationParameters const& parameters
         );
 
+        /** Setup TPDOs to receive the controller status
+         *
+         * This maps the status and fault flags, the voltages and the
+         * temperatures. The objects are packed with TPDOPlanner, so the
+         * number of PDOs used depends on the number of channels
+         *
+         * @return the next usable PDO index
+         * @throw TooManyPDOs if the objects do not fit in the PDOs that
+         *   remain after pdoStartIndex
+         */
         int setupStatusTPDOs(
             std::vector<canbus::Message>& messages, int pdoStartIndex,
             canopen_master::PDOCommunicationParameters const& parameters
         );
 
+        /** Setup a TPDO to receive the status and fault flags
+         *
+         * Unlike setupStatusTPDOs, the voltages and temperatures are left to
+         * setupHousekeepingTPDOs so that the two can run at different rates
+         */
+        int setupStatusFlagsTPDOs(
+            std::vector<canbus::Message>& messages, int pdoStartIndex,
+            canopen_master::PDOCommunicationParameters const& parameters
+        );
+
+        /** Setup TPDOs to receive the voltages and the temperatures
+         *
+         * The objects are packed in as few TPDOs as possible, see TPDOPlanner
+         */
+        int setupHousekeepingTPDOs(
+            std::vector<canbus::Message>& messages, int pdoStartIndex,
+            canopen_master::PDOCommunicationParameters const& parameters
+        );
+
+        /** Setup the joint state, status and housekeeping TPDOs, each at the
+         * rate of its tier
+         *
+         * @see setupJointStateTPDOs setupStatusFlagsTPDOs setupHousekeepingTPDOs
+         */
+        int setupTieredTPDOs(
+            std::vector<canbus::Message>& messages, int pdoStartIndex,
+            TPDORateTiers const& tiers
+        );
+
+        /** Number of TPDOs provided by the controller */
+        static const int MAX_TPDO_COUNT = 16;
+
+        /** Objects mapped by planTPDOs and setupPackedTPDOs */
+        enum TPDOContents {
+            /** The objects of all channels' getJointStateTPDOMapping */
+            TPDO_JOINT_STATE = 0x1,
+            /** The objects mapped by setupStatusTPDOs */
+            TPDO_STATUS = 0x2,
+            /** The objects mapped by setupEncoderTPDOs */
+            TPDO_ENCODERS = 0x4,
+            /** The objects mapped by setupAnalogTPDOs */
+            TPDO_ANALOG_INPUTS = 0x8,
+            TPDO_ALL = 0xF
+        };
+
+        /** Collect the objects of the given TPDO contents into a planner
+         *
+         * Use TPDOPlanner::getFrameCount to know how many TPDOs
+         * setupPackedTPDOs would use
+         *
+         * @param contents bitmask of TPDOContents
+         * @param pdoStartIndex the index of the first PDO, used to limit the
+         *   plan to the PDOs that remain available on the controller
+         */
+        TPDOPlanner planTPDOs(int contents, int pdoStartIndex = 0) const;
+
+        /** Setup TPDOs for the given contents, packing the objects of all
+         * channels and features in the minimum number of PDOs
+         *
+         * This replaces the corresponding calls to setupJointStateTPDOs,
+         * setupStatusTPDOs, setupEncoderTPDOs and setupAnalogTPDOs, which use
+         * at least one PDO per channel or feature.
+         *
+         * @param contents bitmask of TPDOContents
+         * @return the next usable PDO index
+         * @throw TooManyPDOs if the objects do not fit in the controller's
+         *   remaining PDOs
+         */
+        int setupPackedTPDOs(
+            std::vector<canbus::Message>& messages, int pdoStartIndex,
+            canopen_master::PDOCommunicationParameters const& parameters,
+            int contents = TPDO_ALL
+        );
+
         /** Update the object dictionary to reflect the given command
          */
         void setJointCommand(base::samples::Joints const& command);
@@ -137,13 +654,266 @@ namespace motors_roboteq_canopen {
         /** Get the last set joint command */
         base::samples::Joints getJointCommand() const;
 
+        /** Set the names readJointState gives to the joints
+         *
+         * There must be one name per non-ignored channel, or none at all
+         *
+         * @throw std::invalid_argument if the number of names does not match
+         *   the number of non-ignored channels
+         */
+        void setJointNames(std::vector<std::string> const& names);
+
+        /** Read the joint states of the non-ignored channels into a
+         * caller-owned sample
+         *
+         * The sample's elements (and names, see setJointNames) are resized
+         * only if their size does not match the number of non-ignored
+         * channels, so reusing the same sample from one cycle to the next
+         * does not allocate. The sample time is the reception time of the
+         * newest field of the joint states (see
+         * ChannelBase::getJointStateTimestamps)
+         *
+         * @throw std::invalid_argument if joint names have been set and the
+         *   number of non-ignored channels changed since then
+         */
+        void readJointState(base::samples::Joints& joints) const;
+
         /** Generate the RPDO messages to be sent on the bus to
          * apply the last set command
          *
+         * The frames are pre-encoded by setupJointCommandRPDOs, and updated
+         * in place as the command objects are set
+         *
          * @see setupJointCommandRPDOs setJointCommand
          */
         std::vector<canbus::Message> getRPDOMessages() const;
 
+        /** Append the RPDO messages to the given vector
+         *
+         * @overload
+         */
+        void getRPDOMessages(std::vector<canbus::Message>& messages) const;
+
+        /** Copy the RPDO messages into a caller-provided buffer
+         *
+         * This does not allocate
+         *
+         * @return the number of messages written
+         * @throw std::invalid_argument if capacity is lower than getRPDOCount()
+         * @overload
+         */
+        size_t getRPDOMessages(canbus::Message* buffer, size_t capacity) const;
+
+        /** How many RPDOs setupJointCommandRPDOs declared */
+        size_t getRPDOCount() const;
+
+        /** Copy the RPDOs that need to be sent into a caller-provided buffer
+         *
+         * Unlike getRPDOMessages, only the RPDOs whose payload changed since
+         * they were last emitted by this method, or whose keepalive period
+         * has expired, are written. The other ones are counted in
+         * getSuppressedRPDOCount.
+         *
+         * This does not allocate
+         *
+         * @param time the current time, used to evaluate the keepalive periods
+         * @return the number of messages written
+         * @throw std::invalid_argument if capacity is lower than getRPDOCount()
+         * @see setRPDOKeepalivePeriod
+         */
+        size_t getChangedRPDOMessages(
+            canbus::Message* buffer, size_t capacity, base::Time const& time
+        );
+
+        /** Set the period after which an unchanged RPDO is emitted anyways
+         * by getChangedRPDOMessages
+         *
+         * A null period (the default) makes getChangedRPDOMessages emit the
+         * RPDO on every call
+         *
+         * The period is kept if the RPDOs are set up again
+         *
+         * @param index the index of the RPDO, in [0, getRPDOCount()[
+         * @throw std::out_of_range if there is no such RPDO
+         */
+        void setRPDOKeepalivePeriod(int index, base::Time const& period);
+
+        /** Set the keepalive period of all RPDOs
+         *
+         * This overrides the periods set for specific RPDOs. It may be
+         * called before the RPDOs are set up, and is kept if they are set up
+         * again
+         *
+         * @overload
+         */
+        void setRPDOKeepalivePeriod(base::Time const& period);
+
+        /** How many RPDOs getChangedRPDOMessages did not emit because they
+         * were unchanged
+         */
+        uint64_t getSuppressedRPDOCount() const;
+
+        /** The PDOs configured by the setup methods so far */
+        std::vector<ConfiguredPDO> const& getConfiguredPDOs() const;
+
+        /** Whether the setup methods declared a TPDO with this COB-ID, i.e.
+         * whether process() decodes it
+         */
+        bool hasTPDODecoder(uint32_t cob_id) const;
+
+        /** A counter that changes each time the set of TPDOs decoded by
+         * process() changes
+         *
+         * Bus uses it to know when COB-IDs it could not route may have
+         * become routable
+         */
+        uint64_t getTPDODecoderGeneration() const;
+
+        /** Add the frames of the configured PDOs to a bus load computation */
+        void addToBusLoad(BusLoad& load) const;
+
+        /** Refuse PDO setups that would make this node exceed a share of the
+         * bus
+         *
+         * Once set, the PDO setup methods throw BusOverload instead of
+         * configuring a PDO that would make this node's utilization (see
+         * BusLoad::getNodeUtilization) exceed \c max_utilization. The
+         * budget applies to PDOs set up after the call.
+         *
+         * Use Bus::computeBusLoad to check the load of the whole bus
+         */
+        void setBusLoadBudget(BusLoadModel const& model, double max_utilization);
+
+        /** Remove the budget set by setBusLoadBudget */
+        void clearBusLoadBudget();
+
+        /** The configured PDOs, as periodic frames for the response time
+         * analysis
+         *
+         * PDOs that are never sent periodically (RTR-only TPDOs) are not
+         * included
+         */
+        std::vector<ScheduledFrame> getScheduledFrames(BusLoadModel const& model) const;
+
+        /** Override the COB-ID of a PDO
+         *
+         * The override is applied by the PDO setup methods called after this
+         * one, which then configure the controller with it and use it to
+         * decode the TPDO or generate the RPDO
+         *
+         * @see Bus::applyCOBIDs proposeCOBIDs
+         */
+        void setPDOCOBId(bool transmit, int pdoIndex, int cob_id);
+
+        /** Remove all overrides set by setPDOCOBId */
+        void clearPDOCOBIds();
+
+        /** Make the PDO setup methods emit only what changed
+         *
+         * When enabled, the setup methods compare each PDO's configuration
+         * with the one they last emitted for the same PDO index. Nothing is
+         * emitted for the PDOs whose configuration did not change. If only
+         * the transmission type or the event timer changed, only the
+         * corresponding SDOs are emitted. Otherwise, the full sequence is
+         * emitted, as the mapping, COB-ID, inhibit time and SYNC start value
+         * can only be changed with the PDO disabled.
+         *
+         * This assumes the controller keeps the configuration. Call
+         * resetActivePDOSetup after it got reset.
+         *
+         * It is disabled by default.
+         */
+        void setIncrementalPDOSetup(bool enable);
+
+        /** Forget the configurations emitted so far, so that the next setup
+         * emits all PDOs in full
+         */
+        void resetActivePDOSetup();
+
+        /** Fingerprint of the PDO configuration generated by the setup
+         * methods so far
+         *
+         * This is a 32-bit FNV-1a hash of the full setup messages of all
+         * TPDOs and RPDOs, in PDO index order. It does not depend on whether
+         * incremental setup is enabled. It is never zero, which is the value
+         * queryPDOFingerprintInvalidate stores.
+         *
+         * It is meant to skip the PDO configuration at startup when the
+         * controller already has it:
+         *
+         * 1. run the setup methods, keeping the messages aside. They already
+         *    declare the mappings locally
+         * 2. send queryPDOFingerprintUpload and process the reply
+         * 3. send the messages returned by preparePDOSetup
+         */
+        uint32_t getPDOSetupFingerprint() const;
+
+        /** SDO query reading the fingerprint stored on the controller
+         *
+         * @param variable the index (starting at 1) of the controller's user
+         *   integer variable that holds the fingerprint. It must not be used
+         *   by the controller's scripts
+         */
+        canbus::Message queryPDOFingerprintUpload(int variable) const;
+
+        /** SDO query storing getPDOSetupFingerprint on the controller
+         *
+         * @see queryPDOFingerprintUpload
+         */
+        canbus::Message queryPDOFingerprintDownload(int variable) const;
+
+        /** SDO query clearing the fingerprint stored on the controller
+         *
+         * It must be sent before the first setup SDO, so that a setup that
+         * gets interrupted does not leave a stale fingerprint behind
+         *
+         * @see queryPDOFingerprintUpload
+         */
+        canbus::Message queryPDOFingerprintInvalidate(int variable) const;
+
+        /** Whether the fingerprint read with queryPDOFingerprintUpload
+         * matches getPDOSetupFingerprint
+         *
+         * Returns false if the fingerprint has not been read
+         */
+        bool isPDOSetupCurrent(int variable) const;
+
+        /** Return the messages needed to bring the controller to the PDO
+         * setup generated so far
+         *
+         * The fingerprint must have been read with queryPDOFingerprintUpload
+         * beforehand. If it matches, nothing needs to be sent and the
+         * returned list is empty. Otherwise, the setup messages are wrapped
+         * between queryPDOFingerprintInvalidate and
+         * queryPDOFingerprintDownload, so that the fingerprint only matches
+         * once the whole setup has been applied.
+         *
+         * @param setupMessages the messages generated by the setup methods
+         * @see queryPDOFingerprintUpload
+         */
+        std::vector<canbus::Message> preparePDOSetup(
+            std::vector<canbus::Message> const& setupMessages, int variable
+        ) const;
+
+        /** Append the SDO that disables the given PDO, keeping its current
+         * COB-ID
+         *
+         * Nothing is appended if the PDO has not been set up
+         */
+        void disablePDO(
+            std::vector<canbus::Message>& messages, bool transmit, int pdoIndex
+        ) const;
+
+        /** Disable the PDOs that have been set up with an index greater than
+         * or equal to the given one
+         *
+         * Use it after a reconfiguration that uses fewer PDOs than the
+         * previous one, with the index returned by the setup methods
+         */
+        void disablePDOsFrom(
+            std::vector<canbus::Message>& messages, bool transmit, int pdoIndex
+        );
+
         /** Get the SDO write messages that update the joint command */
         std::vector<canbus::Message> queryJointCommandDownload() const;
 
@@ -178,19 +948,30 @@ namespace motors_roboteq_canopen {
          */
         void resetEncoderCounterTracking();
 
+        /** Return the last received value of the given analog input */
+        int16_t getAnalogInput(int index) const;
+
+        /** Return the last received value of the given converted analog input */
+        int16_t getConvertedAnalogInput(int index) const;
+
+        /** Return the last received value of the given encoder counter */
+        int32_t getEncoderCounter(int index) const;
+
         /**
          * Get query messages to receive the current value of the given analog
          * input
          *
          * This should be processed as a SDO query, that you can send it but have
-         * to wait for a reply before another SDO query can be sent
+         * to wait for a reply before another SDO query can be sent. SDOPipeline
+         * does the sequencing
          */
         canbus::Message queryAnalogInput(int index) const;
 
         /** Get query message to receive the current value of the given encoder
          *
          * This should be processed as a SDO query, that you can send it but have
-         * to wait for a reply before another SDO query can be sent
+         * to wait for a reply before another SDO query can be sent. SDOPipeline
+         * does the sequencing
          */
         canbus::Message queryEncoderCounter(int index) const;
 
@@ -0,0 +1,48 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_DRIVERSTATESNAPSHOT_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_DRIVERSTATESNAPSHOT_HPP
+
+#include <cstdint>
+
+#include <base/Float.hpp>
+#include <base/JointState.hpp>
+#include <base/Temperature.hpp>
+
+namespace motors_roboteq_canopen {
+    /** Fixed-size copy of the state of all channels of a driver, along with
+     * the controller status
+     *
+     * Unlike ControllerStatus, it does not contain any dynamically allocated
+     * field, so that it can be published through a Seqlock
+     *
+     * @see DriverBase::enableStateSnapshot
+     */
+    struct DriverStateSnapshot {
+        /** Maximum number of channels a snapshot can represent */
+        static const int MAX_CHANNELS = 4;
+
+        /** Number of valid entries in the per-channel arrays */
+        int channel_count = 0;
+
+        /** Last complete joint state of each channel */
+        base::JointState joint_states[MAX_CHANNELS];
+
+        float voltage_internal = base::unknown<float>();
+        float voltage_battery = base::unknown<float>();
+        float voltage_5v = base::unknown<float>();
+        base::Temperature temperature_mcu;
+        base::Temperature temperature_sensors[MAX_CHANNELS];
+
+        /** @meta bitfield /motors_roboteq_canopen/StatusFlags
+         */
+        uint16_t status_flags = 0xFFFF;
+
+        /** @meta bitfield /motors_roboteq_canopen/FaultFlags
+         */
+        uint16_t fault_flags = 0xFFFF;
+
+        /** @meta bitfields /motors_roboteq_canopen/ChannelStatusFlags */
+        uint16_t channel_status_flags[MAX_CHANNELS] = { 0, 0, 0, 0 };
+    };
+}
+
+#endif
@@ -10,6 +10,20 @@ namespace motors_roboteq_canopen {
     struct InvalidJointCommand : std::runtime_error {
         using std::runtime_error::runtime_error;
     };
+
+    /** Exception thrown when a configuration needs more PDOs than the
+     * controller provides
+     */
+    struct TooManyPDOs : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    /** Exception thrown when the configured PDOs would exceed the bus load
+     * budget
+     */
+    struct BusOverload : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
 }
 
 #endif
\ No newline at end of file
@@ -67,6 +67,59 @@ namespace motors_roboteq_canopen {
         /** Clamp a float value in [-1000, 1000], returning it as integer */
         static int32_t clamp1000(float value);
     };
+
+    /** Raw objects a channel's joint state is computed from
+     *
+     * @see ChannelBase::getRawJointState FactorsTable::toJointStates
+     */
+    struct RawJointState {
+        /** Unit of a raw position or speed */
+        enum Unit {
+            /** The field is not part of the joint state */
+            UNIT_NONE,
+            /** Relative value, converted with relativePositionToSI or
+             * relativeSpeedToSI
+             */
+            UNIT_RELATIVE,
+            /** Encoder counts, converted with encoderToSI (position only) */
+            UNIT_ENCODER,
+            /** RPM, converted with rpmToSI (speed only) */
+            UNIT_RPM
+        };
+
+        /** Whether the channel reports a joint state at all
+         *
+         * Ignored channels do not, their joint state is left unknown
+         */
+        bool valid = false;
+        /** Motor current in A * 10 */
+        int16_t current = 0;
+        /** Applied power level, converted with pwmToFloat */
+        int16_t power_level = 0;
+        Unit position_unit = UNIT_NONE;
+        int32_t position = 0;
+        Unit speed_unit = UNIT_NONE;
+        int32_t speed = 0;
+    };
+
+    /** Conversion a channel applies to its joint command
+     *
+     * @see ChannelBase::getJointCommandConversion FactorsTable::fromJointCommands
+     */
+    enum JointCommandConversions {
+        /** The command is not converted by batch, the channel's
+         * setJointCommand must be used
+         */
+        JOINT_COMMAND_CONVERSION_NONE,
+        /** The raw field, converted with clamp1000(raw * 1000) */
+        JOINT_COMMAND_CONVERSION_POWER_LEVEL,
+        /** The speed field, converted with relativeSpeedFromSI */
+        JOINT_COMMAND_CONVERSION_RELATIVE_SPEED,
+        /** The position field, converted with relativePositionFromSI */
+        JOINT_COMMAND_CONVERSION_RELATIVE_POSITION,
+        /** The effort field, converted with relativeTorqueFromSI */
+        JOINT_COMMAND_CONVERSION_RELATIVE_TORQUE
+    };
 }
 
 #endif
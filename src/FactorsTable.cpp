@@ -0,0 +1,749 @@
+#include <motors_roboteq_canopen/FactorsTable.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace motors_roboteq_canopen;
+
+/* Scalar kernels
+ *
+ * They process [begin, end[ and replicate the operations of the Factors
+ * methods, in the same order
+ */
+
+static void toSIScalar(
+    size_t begin, size_t end, int32_t const* relative, float* si,
+    float const* range, float const* min
+) {
+    for (size_t i = begin; i < end; ++i) {
+        si[i] = (relative[i] + 1000) * range[i] / 2000 + min[i];
+    }
+}
+
+static int32_t fromSIValue(float si, float range, float min) {
+    float v = 2000 * (si - min) / range - 1000;
+    return Factors::clamp1000(std::round(v));
+}
+
+static void fromSIScalar(
+    size_t begin, size_t end, float const* si, int32_t* relative,
+    float const* range, float const* min
+) {
+    for (size_t i = begin; i < end; ++i) {
+        relative[i] = fromSIValue(si[i], range[i], min[i]);
+    }
+}
+
+static void currentToTorqueScalar(
+    size_t begin, size_t end, int16_t const* current, float* torque,
+    double const* torque_constant
+) {
+    for (size_t i = begin; i < end; ++i) {
+        torque[i] = static_cast<float>(current[i]) / 10.0 / torque_constant[i];
+    }
+}
+
+static void torqueFromSIScalar(
+    size_t begin, size_t end, float const* torque, int32_t* relative,
+    double const* torque_constant, float const* range, float const* min
+) {
+    for (size_t i = begin; i < end; ++i) {
+        int16_t current = torque[i] * torque_constant[i] * 100;
+        relative[i] = fromSIValue(current, range[i], min[i]);
+    }
+}
+
+static void encoderToSIScalar(
+    size_t begin, size_t end, int32_t const* encoder, float* si,
+    float const* factor
+) {
+    for (size_t i = begin; i < end; ++i) {
+        si[i] = encoder[i] * factor[i];
+    }
+}
+
+static void pwmToFloatScalar(
+    size_t begin, size_t end, int16_t const* pwm, float* value
+) {
+    for (size_t i = begin; i < end; ++i) {
+        value[i] = static_cast<float>(pwm[i]) / 1000;
+    }
+}
+
+static void rpmToSIScalar(size_t begin, size_t end, float const* rpm, float* si) {
+    for (size_t i = begin; i < end; ++i) {
+        si[i] = rpm[i] * 2 * M_PI / 60;
+    }
+}
+
+static void powerLevelFromFloatScalar(
+    size_t begin, size_t end, float const* raw, int32_t* power_level
+) {
+    for (size_t i = begin; i < end; ++i) {
+        power_level[i] = Factors::clamp1000(raw[i] * 1000);
+    }
+}
+
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+
+/* SIMD kernels
+ *
+ * They process as many elements as they can by whole vectors, and return
+ * how many they processed. The scalar kernels handle the rest.
+ *
+ * std::round rounds half away from zero, which has no SSE/AVX equivalent. It
+ * is emulated by truncating, and adding the sign of the value if the
+ * fractional part is at least 0.5. The fractional part of a float is always
+ * representable, so this is exact.
+ */
+
+__attribute__((target("sse4.1")))
+static __m128 roundSSE41(__m128 v) {
+    __m128 sign_mask = _mm_set1_ps(-0.0f);
+    __m128 truncated = _mm_round_ps(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m128 fraction = _mm_andnot_ps(sign_mask, _mm_sub_ps(v, truncated));
+    __m128 increment = _mm_or_ps(_mm_and_ps(v, sign_mask), _mm_set1_ps(1.0f));
+    __m128 round_up = _mm_cmpge_ps(fraction, _mm_set1_ps(0.5f));
+    return _mm_add_ps(truncated, _mm_and_ps(round_up, increment));
+}
+
+__attribute__((target("sse4.1")))
+static __m128i clamp1000SSE41(__m128 v) {
+    __m128i result = _mm_cvttps_epi32(roundSSE41(v));
+    result = _mm_min_epi32(result, _mm_set1_epi32(1000));
+    return _mm_max_epi32(result, _mm_set1_epi32(-1000));
+}
+
+__attribute__((target("sse4.1")))
+static __m128i fromSISSE41(__m128 si, __m128 range, __m128 min) {
+    __m128 v = _mm_mul_ps(_mm_set1_ps(2000.0f), _mm_sub_ps(si, min));
+    v = _mm_sub_ps(_mm_div_ps(v, range), _mm_set1_ps(1000.0f));
+    return clamp1000SSE41(v);
+}
+
+__attribute__((target("sse4.1")))
+static size_t toSISSE41(
+    size_t size, int32_t const* relative, float* si,
+    float const* range, float const* min
+) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i r = _mm_loadu_si128(reinterpret_cast<__m128i const*>(relative + i));
+        __m128 v = _mm_cvtepi32_ps(_mm_add_epi32(r, _mm_set1_epi32(1000)));
+        v = _mm_div_ps(_mm_mul_ps(v, _mm_loadu_ps(range + i)), _mm_set1_ps(2000.0f));
+        _mm_storeu_ps(si + i, _mm_add_ps(v, _mm_loadu_ps(min + i)));
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t fromSISSE41(
+    size_t size, float const* si, int32_t* relative,
+    float const* range, float const* min
+) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i result = fromSISSE41(
+            _mm_loadu_ps(si + i), _mm_loadu_ps(range + i), _mm_loadu_ps(min + i)
+        );
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(relative + i), result);
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t currentToTorqueSSE41(
+    size_t size, int16_t const* current, float* torque,
+    double const* torque_constant
+) {
+    size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        __m128d v = _mm_set_pd(current[i + 1], current[i]);
+        v = _mm_div_pd(_mm_div_pd(v, _mm_set1_pd(10.0)), _mm_loadu_pd(torque_constant + i));
+        __m128 result = _mm_cvtpd_ps(v);
+        _mm_storel_pi(reinterpret_cast<__m64*>(torque + i), result);
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1")))
+static __m128i currentFromTorqueSSE41(__m128 torque, double const* torque_constant) {
+    __m128d hundred = _mm_set1_pd(100.0);
+    __m128d low = _mm_cvtps_pd(torque);
+    __m128d high = _mm_cvtps_pd(_mm_movehl_ps(torque, torque));
+    low = _mm_mul_pd(_mm_mul_pd(low, _mm_loadu_pd(torque_constant)), hundred);
+    high = _mm_mul_pd(_mm_mul_pd(high, _mm_loadu_pd(torque_constant + 2)), hundred);
+    __m128i current = _mm_unpacklo_epi64(_mm_cvttpd_epi32(low), _mm_cvttpd_epi32(high));
+    // Wrap to int16_t, as the scalar conversion does
+    return _mm_srai_epi32(_mm_slli_epi32(current, 16), 16);
+}
+
+__attribute__((target("sse4.1")))
+static size_t torqueFromSISSE41(
+    size_t size, float const* torque, int32_t* relative,
+    double const* torque_constant, float const* range, float const* min
+) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i current = currentFromTorqueSSE41(
+            _mm_loadu_ps(torque + i), torque_constant + i
+        );
+        __m128i result = fromSISSE41(
+            _mm_cvtepi32_ps(current), _mm_loadu_ps(range + i), _mm_loadu_ps(min + i)
+        );
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(relative + i), result);
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t encoderToSISSE41(
+    size_t size, int32_t const* encoder, float* si, float const* factor
+) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i e = _mm_loadu_si128(reinterpret_cast<__m128i const*>(encoder + i));
+        __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(e), _mm_loadu_ps(factor + i));
+        _mm_storeu_ps(si + i, v);
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t pwmToFloatSSE41(size_t size, int16_t const* pwm, float* value) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i p = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(pwm + i));
+        __m128 v = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(p));
+        _mm_storeu_ps(value + i, _mm_div_ps(v, _mm_set1_ps(1000.0f)));
+    }
+    return i;
+}
+
+/* rpmToSI multiplies by two in single precision and does the rest in double
+ * precision, as Factors::rpmToSI does
+ */
+__attribute__((target("sse4.1")))
+static size_t rpmToSISSE41(size_t size, float const* rpm, float* si) {
+    __m128d pi = _mm_set1_pd(M_PI);
+    __m128d sixty = _mm_set1_pd(60.0);
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(rpm + i), _mm_set1_ps(2.0f));
+        __m128d low = _mm_cvtps_pd(v);
+        __m128d high = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+        low = _mm_div_pd(_mm_mul_pd(low, pi), sixty);
+        high = _mm_div_pd(_mm_mul_pd(high, pi), sixty);
+        _mm_storeu_ps(si + i, _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high)));
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t powerLevelFromFloatSSE41(
+    size_t size, float const* raw, int32_t* power_level
+) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(raw + i), _mm_set1_ps(1000.0f));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(power_level + i), clamp1000SSE41(v)
+        );
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static __m256 roundAVX2(__m256 v) {
+    __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    __m256 truncated = _mm256_round_ps(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m256 fraction = _mm256_andnot_ps(sign_mask, _mm256_sub_ps(v, truncated));
+    __m256 increment = _mm256_or_ps(_mm256_and_ps(v, sign_mask), _mm256_set1_ps(1.0f));
+    __m256 round_up = _mm256_cmp_ps(fraction, _mm256_set1_ps(0.5f), _CMP_GE_OQ);
+    return _mm256_add_ps(truncated, _mm256_and_ps(round_up, increment));
+}
+
+__attribute__((target("avx2")))
+static __m256i clamp1000AVX2(__m256 v) {
+    __m256i result = _mm256_cvttps_epi32(roundAVX2(v));
+    result = _mm256_min_epi32(result, _mm256_set1_epi32(1000));
+    return _mm256_max_epi32(result, _mm256_set1_epi32(-1000));
+}
+
+__attribute__((target("avx2")))
+static __m256i fromSIAVX2(__m256 si, __m256 range, __m256 min) {
+    __m256 v = _mm256_mul_ps(_mm256_set1_ps(2000.0f), _mm256_sub_ps(si, min));
+    v = _mm256_sub_ps(_mm256_div_ps(v, range), _mm256_set1_ps(1000.0f));
+    return clamp1000AVX2(v);
+}
+
+__attribute__((target("avx2")))
+static size_t toSIAVX2(
+    size_t size, int32_t const* relative, float* si,
+    float const* range, float const* min
+) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(relative + i));
+        __m256 v = _mm256_cvtepi32_ps(_mm256_add_epi32(r, _mm256_set1_epi32(1000)));
+        v = _mm256_div_ps(
+            _mm256_mul_ps(v, _mm256_loadu_ps(range + i)), _mm256_set1_ps(2000.0f)
+        );
+        _mm256_storeu_ps(si + i, _mm256_add_ps(v, _mm256_loadu_ps(min + i)));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t fromSIAVX2(
+    size_t size, float const* si, int32_t* relative,
+    float const* range, float const* min
+) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i result = fromSIAVX2(
+            _mm256_loadu_ps(si + i), _mm256_loadu_ps(range + i),
+            _mm256_loadu_ps(min + i)
+        );
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(relative + i), result);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t currentToTorqueAVX2(
+    size_t size, int16_t const* current, float* torque,
+    double const* torque_constant
+) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i c = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(current + i));
+        __m256d v = _mm256_cvtepi32_pd(_mm_cvtepi16_epi32(c));
+        v = _mm256_div_pd(
+            _mm256_div_pd(v, _mm256_set1_pd(10.0)),
+            _mm256_loadu_pd(torque_constant + i)
+        );
+        _mm_storeu_ps(torque + i, _mm256_cvtpd_ps(v));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t torqueFromSIAVX2(
+    size_t size, float const* torque, int32_t* relative,
+    double const* torque_constant, float const* range, float const* min
+) {
+    __m256d hundred = _mm256_set1_pd(100.0);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256 t = _mm256_loadu_ps(torque + i);
+        __m256d low = _mm256_cvtps_pd(_mm256_castps256_ps128(t));
+        __m256d high = _mm256_cvtps_pd(_mm256_extractf128_ps(t, 1));
+        low = _mm256_mul_pd(
+            _mm256_mul_pd(low, _mm256_loadu_pd(torque_constant + i)), hundred
+        );
+        high = _mm256_mul_pd(
+            _mm256_mul_pd(high, _mm256_loadu_pd(torque_constant + i + 4)), hundred
+        );
+        __m256i current = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm256_cvttpd_epi32(low)),
+            _mm256_cvttpd_epi32(high), 1
+        );
+        // Wrap to int16_t, as the scalar conversion does
+        current = _mm256_srai_epi32(_mm256_slli_epi32(current, 16), 16);
+
+        __m256i result = fromSIAVX2(
+            _mm256_cvtepi32_ps(current), _mm256_loadu_ps(range + i),
+            _mm256_loadu_ps(min + i)
+        );
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(relative + i), result);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t encoderToSIAVX2(
+    size_t size, int32_t const* encoder, float* si, float const* factor
+) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i e = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(encoder + i));
+        __m256 v = _mm256_mul_ps(_mm256_cvtepi32_ps(e), _mm256_loadu_ps(factor + i));
+        _mm256_storeu_ps(si + i, v);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t pwmToFloatAVX2(size_t size, int16_t const* pwm, float* value) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pwm + i));
+        __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(p));
+        _mm256_storeu_ps(value + i, _mm256_div_ps(v, _mm256_set1_ps(1000.0f)));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t rpmToSIAVX2(size_t size, float const* rpm, float* si) {
+    __m256d pi = _mm256_set1_pd(M_PI);
+    __m256d sixty = _mm256_set1_pd(60.0);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(rpm + i), _mm256_set1_ps(2.0f));
+        __m256d low = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+        __m256d high = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+        low = _mm256_div_pd(_mm256_mul_pd(low, pi), sixty);
+        high = _mm256_div_pd(_mm256_mul_pd(high, pi), sixty);
+        __m256 result = _mm256_insertf128_ps(
+            _mm256_castps128_ps256(_mm256_cvtpd_ps(low)), _mm256_cvtpd_ps(high), 1
+        );
+        _mm256_storeu_ps(si + i, result);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t powerLevelFromFloatAVX2(
+    size_t size, float const* raw, int32_t* power_level
+) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(raw + i), _mm256_set1_ps(1000.0f));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(power_level + i), clamp1000AVX2(v)
+        );
+    }
+    return i;
+}
+
+#endif
+
+FactorsTable::FactorsTable(size_t size)
+    : m_simd_level(detectSIMDLevel()) {
+    resize(size);
+}
+
+FactorsTable::FactorsTable(vector<Factors> const& factors)
+    : m_simd_level(detectSIMDLevel()) {
+    resize(factors.size());
+    for (size_t i = 0; i < factors.size(); ++i) {
+        set(i, factors[i]);
+    }
+}
+
+size_t FactorsTable::size() const {
+    return m_torque_constant.size();
+}
+
+void FactorsTable::resize(size_t size) {
+    size_t old_size = this->size();
+    m_position_min.resize(size);
+    m_position_range.resize(size);
+    m_speed_min.resize(size);
+    m_speed_range.resize(size);
+    m_current_min.resize(size);
+    m_current_range.resize(size);
+    m_torque_constant.resize(size);
+    m_encoder_factor.resize(size);
+
+    m_raw_current.resize(size);
+    m_raw_power_level.resize(size);
+    m_raw_position.resize(size);
+    m_raw_speed.resize(size);
+    m_raw_rpm.resize(size);
+    m_si_effort.resize(size);
+    m_si_raw.resize(size);
+    m_si_position.resize(size);
+    m_si_encoder.resize(size);
+    m_si_speed.resize(size);
+    m_si_rpm.resize(size);
+    m_command.resize(size);
+
+    for (size_t i = old_size; i < size; ++i) {
+        set(i, Factors());
+    }
+}
+
+void FactorsTable::set(int index, Factors const& factors) {
+    // The Factors methods convert their bounds to float before computing the
+    // range. Do the same.
+    float position_min = factors.position_min;
+    float position_max = factors.position_max;
+    m_position_min.at(index) = position_min;
+    m_position_range.at(index) = position_max - position_min;
+
+    float speed_min = factors.speed_min;
+    float speed_max = factors.speed_max;
+    m_speed_min.at(index) = speed_min;
+    m_speed_range.at(index) = speed_max - speed_min;
+
+    float current_min = -factors.max_current;
+    float current_max = factors.max_current;
+    m_current_min.at(index) = current_min;
+    m_current_range.at(index) = current_max - current_min;
+
+    m_torque_constant.at(index) = factors.torque_constant;
+    m_encoder_factor.at(index) = factors.encoder_position_factor;
+}
+
+SIMDLevel FactorsTable::detectSIMDLevel() {
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_AVX2;
+    }
+    else if (__builtin_cpu_supports("sse4.1")) {
+        return SIMD_SSE41;
+    }
+#endif
+    return SIMD_SCALAR;
+}
+
+SIMDLevel FactorsTable::getSIMDLevel() const {
+    return m_simd_level;
+}
+
+void FactorsTable::setSIMDLevel(SIMDLevel level) {
+    m_simd_level = std::min(level, detectSIMDLevel());
+}
+
+void FactorsTable::relativePositionToSI(int32_t const* relative, float* si) const {
+    size_t done = 0;
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+    if (m_simd_level == SIMD_AVX2) {
+        done = toSIAVX2(size(), relative, si, m_position_range.data(), m_position_min.data());
+    }
+    else if (m_simd_level == SIMD_SSE41) {
+        done = toSISSE41(size(), relative, si, m_position_range.data(), m_position_min.data());
+    }
+#endif
+    toSIScalar(done, size(), relative, si, m_position_range.data(), m_position_min.data());
+}
+
+void FactorsTable::relativeSpeedToSI(int32_t const* relative, float* si) const {
+    size_t done = 0;
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+    if (m_simd_level == SIMD_AVX2) {
+        done = toSIAVX2(size(), relative, si, m_speed_range.data(), m_speed_min.data());
+    }
+    else if (m_simd_level == SIMD_SSE41) {
+        done = toSISSE41(size(), relative, si, m_speed_range.data(), m_speed_min.data());
+    }
+#endif
+    toSIScalar(done, size(), relative, si, m_speed_range.data(), m_speed_min.data());
+}
+
+void FactorsTable::currentToTorqueSI(int16_t const* current, float* torque) const {
+    size_t done = 0;
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+    if (m_simd_level == SIMD_AVX2) {
+        done = currentToTorqueAVX2(size(), current, torque, m_torque_constant.data());
+    }
+    else if (m_simd_level == SIMD_SSE41) {
+        done = currentToTorqueSSE41(size(), current, torque, m_torque_constant.data());
+    }
+#endif
+    currentToTorqueScalar(done, size(), current, torque, m_torque_constant.data());
+}
+
+void FactorsTable::relativePositionFromSI(float const* si, int32_t* relative) const {
+    size_t done = 0;
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+    if (m_simd_level == SIMD_AVX2) {
+        done = fromSIAVX2(size(), si, relative, m_position_range.data(), m_position_min.data());
+    }
+    else if (m_simd_level == SIMD_SSE41) {
+        done = fromSISSE41(size(), si, relative, m_position_range.data(), m_position_min.data());
+    }
+#endif
+    fromSIScalar(done, size(), si, relative, m_position_range.data(), m_position_min.data());
+}
+
+void FactorsTable::relativeSpeedFromSI(float const* si, int32_t* relative) const {
+    size_t done = 0;
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+    if (m_simd_level == SIMD_AVX2) {
+        done = fromSIAVX2(size(), si, relative, m_speed_range.data(), m_speed_min.data());
+    }
+    else if (m_simd_level == SIMD_SSE41) {
+        done = fromSISSE41(size(), si, relative, m_speed_range.data(), m_speed_min.data());
+    }
+#endif
+    fromSIScalar(done, size(), si, relative, m_speed_range.data(), m_speed_min.data());
+}
+
+void FactorsTable::relativeTorqueFromSI(float const* torque, int32_t* relative) const {
+    size_t done = 0;
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+    if (m_simd_level == SIMD_AVX2) {
+        done = torqueFromSIAVX2(
+            size(), torque, relative, m_torque_constant.data(),
+            m_current_range.data(), m_current_min.data()
+        );
+    }
+    else if (m_simd_level == SIMD_SSE41) {
+        done = torqueFromSISSE41(
+            size(), torque, relative, m_torque_constant.data(),
+            m_current_range.data(), m_current_min.data()
+        );
+    }
+#endif
+    torqueFromSIScalar(
+        done, size(), torque, relative, m_torque_constant.data(),
+        m_current_range.data(), m_current_min.data()
+    );
+}
+
+void FactorsTable::encoderToSI(int32_t const* encoder, float* si) const {
+    size_t done = 0;
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+    if (m_simd_level == SIMD_AVX2) {
+        done = encoderToSIAVX2(size(), encoder, si, m_encoder_factor.data());
+    }
+    else if (m_simd_level == SIMD_SSE41) {
+        done = encoderToSISSE41(size(), encoder, si, m_encoder_factor.data());
+    }
+#endif
+    encoderToSIScalar(done, size(), encoder, si, m_encoder_factor.data());
+}
+
+void FactorsTable::pwmToFloat(int16_t const* pwm, float* value) const {
+    size_t done = 0;
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+    if (m_simd_level == SIMD_AVX2) {
+        done = pwmToFloatAVX2(size(), pwm, value);
+    }
+    else if (m_simd_level == SIMD_SSE41) {
+        done = pwmToFloatSSE41(size(), pwm, value);
+    }
+#endif
+    pwmToFloatScalar(done, size(), pwm, value);
+}
+
+void FactorsTable::rpmToSI(float const* rpm, float* si) const {
+    size_t done = 0;
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+    if (m_simd_level == SIMD_AVX2) {
+        done = rpmToSIAVX2(size(), rpm, si);
+    }
+    else if (m_simd_level == SIMD_SSE41) {
+        done = rpmToSISSE41(size(), rpm, si);
+    }
+#endif
+    rpmToSIScalar(done, size(), rpm, si);
+}
+
+void FactorsTable::powerLevelFromFloat(float const* raw, int32_t* power_level) const {
+    size_t done = 0;
+#ifdef MOTORS_ROBOTEQ_CANOPEN_X86_KERNELS
+    if (m_simd_level == SIMD_AVX2) {
+        done = powerLevelFromFloatAVX2(size(), raw, power_level);
+    }
+    else if (m_simd_level == SIMD_SSE41) {
+        done = powerLevelFromFloatSSE41(size(), raw, power_level);
+    }
+#endif
+    powerLevelFromFloatScalar(done, size(), raw, power_level);
+}
+
+void FactorsTable::toJointStates(RawJointState const* raw, base::JointState* states) {
+    bool relative_position = false;
+    bool encoder_position = false;
+    bool relative_speed = false;
+    bool rpm_speed = false;
+    for (size_t i = 0; i < size(); ++i) {
+        m_raw_current[i] = raw[i].current;
+        m_raw_power_level[i] = raw[i].power_level;
+        m_raw_position[i] = raw[i].position;
+        m_raw_speed[i] = raw[i].speed;
+        m_raw_rpm[i] = raw[i].speed;
+        relative_position |= raw[i].position_unit == RawJointState::UNIT_RELATIVE;
+        encoder_position |= raw[i].position_unit == RawJointState::UNIT_ENCODER;
+        relative_speed |= raw[i].speed_unit == RawJointState::UNIT_RELATIVE;
+        rpm_speed |= raw[i].speed_unit == RawJointState::UNIT_RPM;
+    }
+
+    currentToTorqueSI(m_raw_current.data(), m_si_effort.data());
+    pwmToFloat(m_raw_power_level.data(), m_si_raw.data());
+    if (relative_position) {
+        relativePositionToSI(m_raw_position.data(), m_si_position.data());
+    }
+    if (encoder_position) {
+        encoderToSI(m_raw_position.data(), m_si_encoder.data());
+    }
+    if (relative_speed) {
+        relativeSpeedToSI(m_raw_speed.data(), m_si_speed.data());
+    }
+    if (rpm_speed) {
+        rpmToSI(m_raw_rpm.data(), m_si_rpm.data());
+    }
+
+    for (size_t i = 0; i < size(); ++i) {
+        base::JointState state;
+        if (!raw[i].valid) {
+            states[i] = state;
+            continue;
+        }
+
+        state.effort = m_si_effort[i];
+        state.raw = m_si_raw[i];
+        if (raw[i].position_unit == RawJointState::UNIT_RELATIVE) {
+            state.position = m_si_position[i];
+        }
+        else if (raw[i].position_unit == RawJointState::UNIT_ENCODER) {
+            state.position = m_si_encoder[i];
+        }
+
+        if (raw[i].speed_unit == RawJointState::UNIT_RELATIVE) {
+            state.speed = m_si_speed[i];
+        }
+        else if (raw[i].speed_unit == RawJointState::UNIT_RPM) {
+            state.speed = m_si_rpm[i];
+        }
+        states[i] = state;
+    }
+}
+
+void FactorsTable::fromJointCommands(
+    JointCommandConversions const* conversions, float const* values, int32_t* raw
+) {
+    bool used[JOINT_COMMAND_CONVERSION_RELATIVE_TORQUE + 1] = { false };
+    for (size_t i = 0; i < size(); ++i) {
+        used[conversions[i]] = true;
+    }
+
+    for (int c = JOINT_COMMAND_CONVERSION_POWER_LEVEL;
+         c <= JOINT_COMMAND_CONVERSION_RELATIVE_TORQUE; ++c) {
+        if (!used[c]) {
+            continue;
+        }
+
+        switch (c) {
+            case JOINT_COMMAND_CONVERSION_POWER_LEVEL:
+                powerLevelFromFloat(values, m_command.data());
+                break;
+            case JOINT_COMMAND_CONVERSION_RELATIVE_SPEED:
+                relativeSpeedFromSI(values, m_command.data());
+                break;
+            case JOINT_COMMAND_CONVERSION_RELATIVE_POSITION:
+                relativePositionFromSI(values, m_command.data());
+                break;
+            case JOINT_COMMAND_CONVERSION_RELATIVE_TORQUE:
+                relativeTorqueFromSI(values, m_command.data());
+                break;
+        }
+        for (size_t i = 0; i < size(); ++i) {
+            if (conversions[i] == c) {
+                raw[i] = m_command[i];
+            }
+        }
+    }
+}
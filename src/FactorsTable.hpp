@@ -0,0 +1,161 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_FACTORSTABLE_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_FACTORSTABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <base/JointState.hpp>
+#include <motors_roboteq_canopen/Factors.hpp>
+
+namespace motors_roboteq_canopen {
+    /** Instruction sets the FactorsTable kernels can use */
+    enum SIMDLevel {
+        SIMD_SCALAR,
+        SIMD_SSE41,
+        SIMD_AVX2
+    };
+
+    /**
+     * Conversion factors of several channels, stored as a structure of arrays
+     *
+     * The batch conversion methods convert one value per channel in a single
+     * pass, using SSE4.1 or AVX2 kernels when the CPU supports them. The
+     * instruction set is detected at runtime.
+     *
+     * The results are bit-for-bit identical to the ones of the corresponding
+     * Factors methods: the table stores the range and minimum of each
+     * conversion (instead of a fused scale) so that the kernels can perform
+     * the same floating-point operations in the same order. The only
+     * exception are inputs for which the scalar conversion to integer is
+     * undefined (NaN, or values outside of the int32 range), for which the
+     * kernels return the value x86's scalar conversion returns.
+     *
+     * All arrays passed to the conversion methods must have size() elements
+     *
+     * toJointStates and fromJointCommands convert whole joint states and
+     * commands, as Channel and DS402Channel do one channel at a time. Bus
+     * uses them to convert the joint states and commands of all its
+     * channels at once (Bus::readJointStates and Bus::setJointCommands).
+     */
+    class FactorsTable {
+        std::vector<float> m_position_min;
+        std::vector<float> m_position_range;
+        std::vector<float> m_speed_min;
+        std::vector<float> m_speed_range;
+        std::vector<float> m_current_min;
+        std::vector<float> m_current_range;
+        std::vector<double> m_torque_constant;
+        std::vector<float> m_encoder_factor;
+
+        SIMDLevel m_simd_level;
+
+        /** Structure-of-arrays scratch buffers of toJointStates and
+         * fromJointCommands
+         */
+        std::vector<int16_t> m_raw_current;
+        std::vector<int16_t> m_raw_power_level;
+        std::vector<int32_t> m_raw_position;
+        std::vector<int32_t> m_raw_speed;
+        std::vector<float> m_raw_rpm;
+        std::vector<float> m_si_effort;
+        std::vector<float> m_si_raw;
+        std::vector<float> m_si_position;
+        std::vector<float> m_si_encoder;
+        std::vector<float> m_si_speed;
+        std::vector<float> m_si_rpm;
+        std::vector<int32_t> m_command;
+
+    public:
+        /** Create a table for the given number of channels
+         *
+         * All channels are initialized with default-constructed Factors
+         */
+        explicit FactorsTable(size_t size = 0);
+
+        /** Create a table with the given channel factors */
+        explicit FactorsTable(std::vector<Factors> const& factors);
+
+        /** Return the number of channels */
+        size_t size() const;
+
+        /** Change the number of channels
+         *
+         * New channels are initialized with default-constructed Factors
+         */
+        void resize(size_t size);
+
+        /** Set the factors of a given channel */
+        void set(int index, Factors const& factors);
+
+        /** The best instruction set supported by the CPU */
+        static SIMDLevel detectSIMDLevel();
+
+        /** The instruction set used by the conversion methods */
+        SIMDLevel getSIMDLevel() const;
+
+        /** Select the instruction set used by the conversion methods
+         *
+         * This is mostly meant for testing and benchmarking. The level is
+         * capped to what the CPU supports.
+         */
+        void setSIMDLevel(SIMDLevel level);
+
+        /** @see Factors::relativePositionToSI */
+        void relativePositionToSI(int32_t const* relative, float* si) const;
+
+        /** @see Factors::relativeSpeedToSI */
+        void relativeSpeedToSI(int32_t const* relative, float* si) const;
+
+        /** @see Factors::currentToTorqueSI */
+        void currentToTorqueSI(int16_t const* current, float* torque) const;
+
+        /** @see Factors::relativePositionFromSI */
+        void relativePositionFromSI(float const* si, int32_t* relative) const;
+
+        /** @see Factors::relativeSpeedFromSI */
+        void relativeSpeedFromSI(float const* si, int32_t* relative) const;
+
+        /** @see Factors::relativeTorqueFromSI */
+        void relativeTorqueFromSI(float const* torque, int32_t* relative) const;
+
+        /** @see Factors::encoderToSI */
+        void encoderToSI(int32_t const* encoder, float* si) const;
+
+        /** @see Factors::pwmToFloat */
+        void pwmToFloat(int16_t const* pwm, float* value) const;
+
+        /** @see Factors::rpmToSI */
+        void rpmToSI(float const* rpm, float* si) const;
+
+        /** Convert open-loop commands to power levels, as
+         * Factors::clamp1000(raw * 1000)
+         */
+        void powerLevelFromFloat(float const* raw, int32_t* power_level) const;
+
+        /** Convert the raw joint states of all channels to SI
+         *
+         * The result is the one of the channels' getJointState. Only the
+         * conversions some channel needs are run.
+         *
+         * This uses buffers owned by the table, so a table must not be used
+         * by several threads at once.
+         */
+        void toJointStates(RawJointState const* raw, base::JointState* states);
+
+        /** Convert one joint command field per channel to the raw value the
+         * channels' setJointCommand would compute
+         *
+         * Values of channels whose conversion is JOINT_COMMAND_CONVERSION_NONE
+         * are left untouched
+         *
+         * @see toJointStates
+         */
+        void fromJointCommands(
+            JointCommandConversions const* conversions, float const* values,
+            int32_t* raw
+        );
+    };
+}
+
+#endif
@@ -0,0 +1,23 @@
+#include <motors_roboteq_canopen/Listeners.hpp>
+
+using namespace motors_roboteq_canopen;
+
+JointStateListener::~JointStateListener() {
+}
+
+DriverListener::~DriverListener() {
+}
+
+void DriverListener::jointStateCompleted(
+    DriverBase&, int, base::JointState const&
+) {
+}
+
+void DriverListener::analogInputsCompleted(DriverBase&) {
+}
+
+void DriverListener::convertedAnalogInputsCompleted(DriverBase&) {
+}
+
+void DriverListener::encoderCountersCompleted(DriverBase&) {
+}
@@ -0,0 +1,82 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_LISTENERS_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_LISTENERS_HPP
+
+#include <base/JointState.hpp>
+
+namespace motors_roboteq_canopen {
+    class ChannelBase;
+    class DriverBase;
+
+    /** Interface notified when a channel's joint state gets completed
+     *
+     * The listener is called from within DriverBase::process, as soon as
+     * the last field of the joint state has been received. Implementations
+     * should not block.
+     *
+     * It is only called when the joint state goes from incomplete to
+     * complete. To be notified of the next update, the channel's
+     * ChannelBase::resetJointStateTracking must be called, e.g. from the
+     * callback itself.
+     *
+     * @see ChannelBase::setJointStateListener
+     */
+    struct JointStateListener {
+        virtual ~JointStateListener();
+
+        /** Called when all fields needed by getJointState have been received
+         *
+         * @param channel the channel whose joint state got completed
+         * @param state the channel's joint state, as returned by getJointState
+         */
+        virtual void jointStateCompleted(
+            ChannelBase& channel, base::JointState const& state
+        ) = 0;
+    };
+
+    /** Interface notified when one of the groups tracked by a driver gets
+     * completed
+     *
+     * The listener is called from within DriverBase::process, as soon as the
+     * last object of a group has been received. The default implementations
+     * do nothing. Implementations should not block.
+     *
+     * As for JointStateListener, the callbacks are only called when a group
+     * goes from incomplete to complete. The group's tracking must be reset
+     * (ChannelBase::resetJointStateTracking, DriverBase::resetAnalogInputTracking,
+     * ...) to be notified of the next update.
+     *
+     * @see DriverBase::setListener
+     */
+    struct DriverListener {
+        virtual ~DriverListener();
+
+        /** Called when the given channel's joint state got completed
+         *
+         * @param channel the index of the channel in the driver
+         * @param state the channel's joint state, as returned by getJointState
+         */
+        virtual void jointStateCompleted(
+            DriverBase& driver, int channel, base::JointState const& state
+        );
+
+        /** Called when all expected analog inputs have been received
+         *
+         * @see DriverBase::getAnalogInput
+         */
+        virtual void analogInputsCompleted(DriverBase& driver);
+
+        /** Called when all expected converted analog inputs have been received
+         *
+         * @see DriverBase::getConvertedAnalogInput
+         */
+        virtual void convertedAnalogInputsCompleted(DriverBase& driver);
+
+        /** Called when all expected encoder counters have been received
+         *
+         * @see DriverBase::getEncoderCounter
+         */
+        virtual void encoderCountersCompleted(DriverBase& driver);
+    };
+}
+
+#endif
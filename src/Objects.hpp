@@ -6,6 +6,7 @@
 namespace motors_roboteq_canopen {
     CANOPEN_DEFINE_OBJECT(0x2000, 1, SetCommand,                    std::int32_t);
     CANOPEN_DEFINE_OBJECT(0x2002, 1, SetSpeedTarget,                std::int16_t);
+    CANOPEN_DEFINE_OBJECT(0x2005, 1, SetUserIntegerVariable,        std::int32_t);
     CANOPEN_DEFINE_OBJECT(0x2009, 0, ActivateDigitalOutput,         std::uint8_t);
     CANOPEN_DEFINE_OBJECT(0x200A, 0, ResetDigitalOutput,            std::uint8_t);
     CANOPEN_DEFINE_OBJECT(0x200C, 0, EmergencyShutdown,             std::uint8_t);
@@ -16,6 +17,7 @@ namespace motors_roboteq_canopen {
     CANOPEN_DEFINE_OBJECT(0x2102, 1, AppliedPowerLevel,             std::int16_t);
     CANOPEN_DEFINE_OBJECT(0x210C, 1, BatteryAmps,                   std::int16_t);
     CANOPEN_DEFINE_OBJECT(0x2104, 1, EncoderCounter,                std::int32_t);
+    CANOPEN_DEFINE_OBJECT(0x2106, 1, UserIntegerVariable,           std::int32_t);
     CANOPEN_DEFINE_OBJECT(0x210D, 1, VoltageInternal,               std::uint16_t);
     CANOPEN_DEFINE_OBJECT(0x210D, 2, VoltageBattery,                std::uint16_t);
     CANOPEN_DEFINE_OBJECT(0x210D, 3, Voltage5V,                     std::uint16_t);
@@ -0,0 +1,118 @@
+#include <motors_roboteq_canopen/ResponseTimeAnalysis.hpp>
+#include <motors_roboteq_canopen/BusLoad.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <stdexcept>
+
+using namespace std;
+using namespace motors_roboteq_canopen;
+
+static double getDeadline(ScheduledFrame const& frame) {
+    if (frame.deadline.isNull()) {
+        return frame.period.toSeconds();
+    }
+    return frame.deadline.toSeconds();
+}
+
+vector<FrameResponseTime> motors_roboteq_canopen::computeWorstCaseResponseTimes(
+    vector<ScheduledFrame> const& frames, int bitrate
+) {
+    if (bitrate <= 0) {
+        throw invalid_argument("the bitrate must be strictly positive");
+    }
+
+    set<int> cob_ids;
+    for (auto const& frame : frames) {
+        if (!cob_ids.insert(frame.cob_id).second) {
+            throw invalid_argument("two frames share the same COB-ID");
+        }
+        else if (frame.period <= base::Time()) {
+            throw invalid_argument("all frames must have a period");
+        }
+    }
+
+    double bit_time = 1.0 / bitrate;
+    vector<double> transmission_times;
+    for (auto const& frame : frames) {
+        transmission_times.push_back(getWorstCaseFrameBits(frame.size) * bit_time);
+    }
+
+    vector<FrameResponseTime> result;
+    for (size_t m = 0; m < frames.size(); ++m) {
+        ScheduledFrame const& frame = frames[m];
+        double c_m = transmission_times[m];
+        double j_m = frame.jitter.toSeconds();
+        double deadline = getDeadline(frame);
+
+        double blocking = 0;
+        for (size_t k = 0; k < frames.size(); ++k) {
+            if (frames[k].cob_id > frame.cob_id) {
+                blocking = std::max(blocking, transmission_times[k]);
+            }
+        }
+
+        double w = std::max(blocking, c_m);
+        bool schedulable = true;
+        while (true) {
+            double next = std::max(blocking, c_m);
+            for (size_t k = 0; k < frames.size(); ++k) {
+                if (frames[k].cob_id >= frame.cob_id) {
+                    continue;
+                }
+                double t_k = frames[k].period.toSeconds();
+                double j_k = frames[k].jitter.toSeconds();
+                next += ceil((w + j_k + bit_time) / t_k) * transmission_times[k];
+            }
+
+            if (j_m + next + c_m > deadline) {
+                w = next;
+                schedulable = false;
+                break;
+            }
+            else if (next == w) {
+                break;
+            }
+            w = next;
+        }
+
+        FrameResponseTime response;
+        response.frame = frame;
+        response.transmission_time = base::Time::fromSeconds(c_m);
+        response.blocking_time = base::Time::fromSeconds(blocking);
+        response.response_time = base::Time::fromSeconds(j_m + w + c_m);
+        response.schedulable = schedulable;
+        result.push_back(response);
+    }
+    return result;
+}
+
+vector<ScheduledFrame> motors_roboteq_canopen::proposeCOBIDs(
+    vector<ScheduledFrame> const& frames
+) {
+    vector<size_t> pdos;
+    vector<int> cob_ids;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (frames[i].pdo_index >= 0) {
+            pdos.push_back(i);
+            cob_ids.push_back(frames[i].cob_id);
+        }
+    }
+    sort(cob_ids.begin(), cob_ids.end());
+
+    stable_sort(pdos.begin(), pdos.end(), [&frames](size_t a, size_t b) {
+        ScheduledFrame const& fa = frames[a];
+        ScheduledFrame const& fb = frames[b];
+        if (fa.priority_class != fb.priority_class) {
+            return fa.priority_class < fb.priority_class;
+        }
+        return getDeadline(fa) < getDeadline(fb);
+    });
+
+    vector<ScheduledFrame> result(frames);
+    for (size_t i = 0; i < pdos.size(); ++i) {
+        result[pdos[i]].cob_id = cob_ids[i];
+    }
+    return result;
+}
@@ -0,0 +1,116 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_RESPONSETIMEANALYSIS_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_RESPONSETIMEANALYSIS_HPP
+
+#include <vector>
+
+#include <base/Time.hpp>
+
+namespace motors_roboteq_canopen {
+    /** Traffic class of a PDO, in decreasing order of priority
+     *
+     * @see proposeCOBIDs
+     */
+    enum PDOPriorityClass {
+        /** Joint command RPDOs */
+        PDO_PRIORITY_COMMAND,
+        /** Joint state TPDOs */
+        PDO_PRIORITY_JOINT_STATE,
+        /** Encoder TPDOs */
+        PDO_PRIORITY_ENCODER,
+        /** Controller status TPDOs */
+        PDO_PRIORITY_STATUS,
+        /** Analog input TPDOs */
+        PDO_PRIORITY_ANALOG,
+        /** Voltage and temperature TPDOs */
+        PDO_PRIORITY_HOUSEKEEPING
+    };
+
+    /** A periodic frame on the bus */
+    struct ScheduledFrame {
+        /** The node that owns the frame, zero for frames of the master
+         * such as the SYNC
+         */
+        int node_id = 0;
+
+        /** True if the frame is a TPDO, false if it is a RPDO. Meaningless
+         * if pdo_index is -1
+         */
+        bool transmit = true;
+
+        /** The PDO index on the node, or -1 if the frame is not a PDO */
+        int pdo_index = -1;
+
+        PDOPriorityClass priority_class = PDO_PRIORITY_COMMAND;
+
+        int cob_id = 0;
+        /** Payload size in bytes */
+        int size = 0;
+
+        /** Minimum interval between two transmissions */
+        base::Time period;
+        /** Queuing jitter */
+        base::Time jitter;
+        /** Deadline, relative to the frame's queuing. Null means the period */
+        base::Time deadline;
+    };
+
+    /** Result of the response time analysis of a frame */
+    struct FrameResponseTime {
+        ScheduledFrame frame;
+
+        /** Worst-case transmission time of the frame itself */
+        base::Time transmission_time;
+
+        /** Worst-case time during which a lower-priority frame already on
+         * the bus blocks this frame
+         */
+        base::Time blocking_time;
+
+        /** Worst-case time between the frame's queuing and the end of its
+         * transmission
+         */
+        base::Time response_time;
+
+        /** Whether the response time is within the frame's deadline. If
+         * not, response_time is only a lower bound
+         */
+        bool schedulable = false;
+    };
+
+    /**
+     * Compute the worst-case response time of a set of periodic CAN frames
+     *
+     * This is the classic analysis for CAN (Tindell, as revised by Davis et
+     * al. in 2007), using its sufficient form in which the blocking term
+     * is max(B_m, C_m):
+     *
+     *   w_m = max(B_m, C_m) + sum_{k in hp(m)} ceil((w_m + J_k + t_bit) / T_k) C_k
+     *   R_m = J_m + w_m + C_m
+     *
+     * Frames are prioritized by COB-ID. Transmission times use the
+     * worst-case bit stuffing, see getWorstCaseFrameBits.
+     *
+     * @param bitrate the bus bitrate in bit/s
+     * @return the response times, in the order of \c frames
+     * @throw std::invalid_argument if two frames share a COB-ID or a frame has
+     *   no period
+     */
+    std::vector<FrameResponseTime> computeWorstCaseResponseTimes(
+        std::vector<ScheduledFrame> const& frames, int bitrate
+    );
+
+    /** Propose a COB-ID assignment for the PDOs among a set of frames
+     *
+     * The COB-IDs the PDOs already use are redistributed among them, so
+     * that the assignment does not conflict with the other COB-IDs of the
+     * bus. Lower COB-IDs (higher priorities) go to the PDOs with the higher
+     * priority class, and within a class to the ones with the shorter
+     * deadline (deadline-monotonic order). Frames that are not PDOs keep
+     * their COB-ID.
+     *
+     * @return the frames with their new COB-IDs, in the order of \c frames
+     */
+    std::vector<ScheduledFrame> proposeCOBIDs(std::vector<ScheduledFrame> const& frames);
+}
+
+#endif
@@ -0,0 +1,512 @@
+#include <motors_roboteq_canopen/SDOBlockTransfer.hpp>
+
+#include <algorithm>
+#include <canopen_master/Functions.hpp>
+#include <stdexcept>
+
+using namespace std;
+using namespace motors_roboteq_canopen;
+
+const int SDOBlockTransfer::SEGMENT_SIZE;
+const int SDOBlockTransfer::MAX_BLOCK_SIZE;
+
+/* Command bytes. The client block download and the server block upload share
+ * the same command specifier (6), as do the client block upload and server
+ * block download (5)
+ */
+static const uint8_t SDO_ABORT = 0x80;
+static const uint8_t SDO_BLOCK_DOWNLOAD_CLIENT = 0xC0;
+static const uint8_t SDO_BLOCK_DOWNLOAD_SERVER = 0xA0;
+static const uint8_t SDO_BLOCK_UPLOAD_CLIENT = 0xA0;
+static const uint8_t SDO_BLOCK_UPLOAD_SERVER = 0xC0;
+static const uint8_t SDO_BLOCK_INITIATE = 0;
+static const uint8_t SDO_BLOCK_END = 1;
+static const uint8_t SDO_BLOCK_ACK = 2;
+static const uint8_t SDO_BLOCK_START = 3;
+static const uint8_t SDO_BLOCK_CRC = 0x04;
+static const uint8_t SDO_BLOCK_SIZE_INDICATED = 0x02;
+static const uint8_t SDO_BLOCK_LAST_SEGMENT = 0x80;
+
+static const uint8_t SDO_DOWNLOAD_SEGMENT = 0x00;
+static const uint8_t SDO_INITIATE_DOWNLOAD = 0x20;
+static const uint8_t SDO_INITIATE_UPLOAD = 0x40;
+static const uint8_t SDO_UPLOAD_SEGMENT = 0x60;
+static const uint8_t SDO_SEGMENT_REPLY = 0x20;
+static const uint8_t SDO_INITIATE_DOWNLOAD_REPLY = 0x60;
+static const uint8_t SDO_UPLOAD_SEGMENT_REPLY = 0x00;
+static const uint8_t SDO_COMMAND_MASK = 0xE0;
+static const uint8_t SDO_TOGGLE = 0x10;
+static const uint8_t SDO_EXPEDITED = 0x02;
+static const uint8_t SDO_SIZE_INDICATED = 0x01;
+static const uint8_t SDO_LAST_SEGMENT = 0x01;
+
+static void writeUInt32(uint8_t* data, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        data[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+static uint32_t readUInt32(uint8_t const* data) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+uint16_t motors_roboteq_canopen::computeSDOBlockCRC(
+    uint8_t const* data, size_t size, uint16_t crc
+) {
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+SDOBlockTransfer::SDOBlockTransfer(int node_id, int object_id, int sub_id, bool crc)
+    : m_node_id(node_id)
+    , m_object_id(object_id)
+    , m_sub_id(sub_id)
+    , m_crc(crc) {
+}
+
+canbus::Message SDOBlockTransfer::makeMessage(uint8_t command) const {
+    canbus::Message message = makeSegment(command);
+    message.data[1] = m_object_id & 0xFF;
+    message.data[2] = (m_object_id >> 8) & 0xFF;
+    message.data[3] = m_sub_id;
+    return message;
+}
+
+canbus::Message SDOBlockTransfer::makeSegment(uint8_t command) const {
+    canbus::Message message;
+    message.can_id = canopen_master::FUNCTION_SDO_RECEIVE | m_node_id;
+    message.size = 8;
+    std::fill(message.data, message.data + 8, 0);
+    message.data[0] = command;
+    return message;
+}
+
+bool SDOBlockTransfer::isFromNode(canbus::Message const& message) const {
+    return message.can_id == static_cast<uint32_t>(
+        canopen_master::FUNCTION_SDO_TRANSMIT | m_node_id
+    );
+}
+
+bool SDOBlockTransfer::isAbort(canbus::Message const& message) const {
+    return message.data[0] == SDO_ABORT &&
+           (message.data[1] | (message.data[2] << 8)) == m_object_id &&
+           message.data[3] == m_sub_id;
+}
+
+void SDOBlockTransfer::complete() {
+    m_status = SDO_TRANSFER_COMPLETED;
+}
+
+void SDOBlockTransfer::abortWithCode(uint32_t code, vector<canbus::Message>& messages) {
+    canbus::Message message = makeMessage(SDO_ABORT);
+    writeUInt32(message.data + 4, code);
+    messages.push_back(message);
+    m_status = SDO_TRANSFER_ABORTED;
+    m_abort_code = code;
+}
+
+void SDOBlockTransfer::abort(uint32_t code, vector<canbus::Message>& messages) {
+    if (!isFinished()) {
+        abortWithCode(code, messages);
+    }
+}
+
+SDOTransferStatus SDOBlockTransfer::getStatus() const {
+    return m_status;
+}
+
+bool SDOBlockTransfer::isFinished() const {
+    return m_status != SDO_TRANSFER_RUNNING;
+}
+
+SDOTransferProtocols SDOBlockTransfer::getProtocol() const {
+    return m_protocol;
+}
+
+uint32_t SDOBlockTransfer::getAbortCode() const {
+    return m_abort_code;
+}
+
+SDOBlockDownload::SDOBlockDownload(
+    int node_id, int object_id, int sub_id,
+    vector<uint8_t> const& data, bool crc
+)
+    : SDOBlockTransfer(node_id, object_id, sub_id, crc)
+    , m_data(data)
+    , m_segment_count(
+        std::max<size_t>(1, (data.size() + SEGMENT_SIZE - 1) / SEGMENT_SIZE)
+    ) {
+}
+
+void SDOBlockDownload::start(vector<canbus::Message>& messages) {
+    canbus::Message message = makeMessage(
+        SDO_BLOCK_DOWNLOAD_CLIENT | SDO_BLOCK_INITIATE | SDO_BLOCK_SIZE_INDICATED |
+        (m_crc ? SDO_BLOCK_CRC : 0)
+    );
+    writeUInt32(message.data + 4, m_data.size());
+    messages.push_back(message);
+    m_state = INITIATING_BLOCK;
+}
+
+bool SDOBlockDownload::process(
+    canbus::Message const& message, vector<canbus::Message>& messages
+) {
+    if (isFinished() || !isFromNode(message)) {
+        return false;
+    }
+    else if (isAbort(message)) {
+        if (m_state == INITIATING_BLOCK) {
+            fallback(messages);
+        }
+        else {
+            m_status = SDO_TRANSFER_ABORTED;
+            m_abort_code = readUInt32(message.data + 4);
+        }
+        return true;
+    }
+
+    uint8_t command = message.data[0];
+    switch (m_state) {
+        case INITIATING_BLOCK:
+            if ((command & 0xE3) != (SDO_BLOCK_DOWNLOAD_SERVER | SDO_BLOCK_INITIATE)) {
+                return false;
+            }
+            m_server_crc = command & SDO_BLOCK_CRC;
+            m_next_segment = 0;
+            sendBlock(message.data[4], messages);
+            return true;
+
+        case SENDING_BLOCK: {
+            if (command != (SDO_BLOCK_DOWNLOAD_SERVER | SDO_BLOCK_ACK)) {
+                return false;
+            }
+            size_t ack = message.data[1];
+            if (ack > m_block_segments) {
+                abortWithCode(SDO_ABORT_INVALID_SEQUENCE, messages);
+                return true;
+            }
+            m_next_segment = m_block_start + ack;
+            if (m_next_segment == m_segment_count) {
+                sendEnd(messages);
+            }
+            else {
+                sendBlock(message.data[2], messages);
+            }
+            return true;
+        }
+
+        case ENDING_BLOCK:
+            if (command != (SDO_BLOCK_DOWNLOAD_SERVER | SDO_BLOCK_END)) {
+                return false;
+            }
+            complete();
+            return true;
+
+        case INITIATING_SEGMENTED:
+            if ((command & SDO_COMMAND_MASK) != SDO_INITIATE_DOWNLOAD_REPLY) {
+                return false;
+            }
+            if (m_protocol == SDO_PROTOCOL_EXPEDITED) {
+                complete();
+            }
+            else {
+                m_next_segment = 0;
+                m_toggle = false;
+                m_state = SENDING_SEGMENT;
+                sendSegment(messages);
+            }
+            return true;
+
+        case SENDING_SEGMENT:
+            if ((command & SDO_COMMAND_MASK) != SDO_SEGMENT_REPLY) {
+                return false;
+            }
+            if (static_cast<bool>(command & SDO_TOGGLE) != m_toggle) {
+                abortWithCode(SDO_ABORT_TOGGLE_BIT, messages);
+                return true;
+            }
+            ++m_next_segment;
+            m_toggle = !m_toggle;
+            if (m_next_segment == m_segment_count) {
+                complete();
+            }
+            else {
+                sendSegment(messages);
+            }
+            return true;
+    }
+    return false;
+}
+
+void SDOBlockDownload::sendBlock(int block_size, vector<canbus::Message>& messages) {
+    if (block_size < 1 || block_size > MAX_BLOCK_SIZE) {
+        abortWithCode(SDO_ABORT_INVALID_BLOCK_SIZE, messages);
+        return;
+    }
+
+    m_block_start = m_next_segment;
+    m_block_segments = std::min<size_t>(block_size, m_segment_count - m_block_start);
+    for (size_t i = 0; i < m_block_segments; ++i) {
+        size_t segment = m_block_start + i;
+        uint8_t command = i + 1;
+        if (segment == m_segment_count - 1) {
+            command |= SDO_BLOCK_LAST_SEGMENT;
+        }
+
+        canbus::Message message = makeSegment(command);
+        size_t offset = segment * SEGMENT_SIZE;
+        size_t end = std::min(offset + SEGMENT_SIZE, m_data.size());
+        std::copy(m_data.begin() + offset, m_data.begin() + end, message.data + 1);
+        messages.push_back(message);
+    }
+    m_state = SENDING_BLOCK;
+}
+
+void SDOBlockDownload::sendEnd(vector<canbus::Message>& messages) {
+    size_t last_size = m_data.size() - (m_segment_count - 1) * SEGMENT_SIZE;
+    canbus::Message message = makeSegment(
+        SDO_BLOCK_DOWNLOAD_CLIENT | SDO_BLOCK_END | ((SEGMENT_SIZE - last_size) << 2)
+    );
+    if (m_crc && m_server_crc) {
+        uint16_t crc = computeSDOBlockCRC(m_data.data(), m_data.size());
+        message.data[1] = crc & 0xFF;
+        message.data[2] = crc >> 8;
+    }
+    messages.push_back(message);
+    m_state = ENDING_BLOCK;
+}
+
+void SDOBlockDownload::fallback(vector<canbus::Message>& messages) {
+    m_state = INITIATING_SEGMENTED;
+    if (!m_data.empty() && m_data.size() <= 4) {
+        m_protocol = SDO_PROTOCOL_EXPEDITED;
+        canbus::Message message = makeMessage(
+            SDO_INITIATE_DOWNLOAD | ((4 - m_data.size()) << 2) |
+            SDO_EXPEDITED | SDO_SIZE_INDICATED
+        );
+        std::copy(m_data.begin(), m_data.end(), message.data + 4);
+        messages.push_back(message);
+    }
+    else {
+        m_protocol = SDO_PROTOCOL_SEGMENTED;
+        canbus::Message message = makeMessage(SDO_INITIATE_DOWNLOAD | SDO_SIZE_INDICATED);
+        writeUInt32(message.data + 4, m_data.size());
+        messages.push_back(message);
+    }
+}
+
+void SDOBlockDownload::sendSegment(vector<canbus::Message>& messages) {
+    size_t offset = m_next_segment * SEGMENT_SIZE;
+    size_t end = std::min(offset + SEGMENT_SIZE, m_data.size());
+    uint8_t command = SDO_DOWNLOAD_SEGMENT | ((SEGMENT_SIZE - (end - offset)) << 1);
+    if (m_toggle) {
+        command |= SDO_TOGGLE;
+    }
+    if (m_next_segment == m_segment_count - 1) {
+        command |= SDO_LAST_SEGMENT;
+    }
+
+    canbus::Message message = makeSegment(command);
+    std::copy(m_data.begin() + offset, m_data.begin() + end, message.data + 1);
+    messages.push_back(message);
+}
+
+SDOBlockUpload::SDOBlockUpload(
+    int node_id, int object_id, int sub_id, int block_size, bool crc
+)
+    : SDOBlockTransfer(node_id, object_id, sub_id, crc)
+    , m_block_size(block_size) {
+    if (block_size < 1 || block_size > MAX_BLOCK_SIZE) {
+        throw invalid_argument("SDO block size must be between 1 and 127");
+    }
+}
+
+void SDOBlockUpload::start(vector<canbus::Message>& messages) {
+    canbus::Message message = makeMessage(
+        SDO_BLOCK_UPLOAD_CLIENT | SDO_BLOCK_INITIATE | (m_crc ? SDO_BLOCK_CRC : 0)
+    );
+    // data[5] is the protocol switch threshold, 0 disables it
+    message.data[4] = m_block_size;
+    messages.push_back(message);
+    m_state = INITIATING_BLOCK;
+}
+
+bool SDOBlockUpload::process(
+    canbus::Message const& message, vector<canbus::Message>& messages
+) {
+    if (isFinished() || !isFromNode(message)) {
+        return false;
+    }
+    else if (isAbort(message)) {
+        if (m_state == INITIATING_BLOCK) {
+            m_protocol = SDO_PROTOCOL_SEGMENTED;
+            m_state = INITIATING_SEGMENTED;
+            messages.push_back(makeMessage(SDO_INITIATE_UPLOAD));
+        }
+        else {
+            m_status = SDO_TRANSFER_ABORTED;
+            m_abort_code = readUInt32(message.data + 4);
+        }
+        return true;
+    }
+
+    uint8_t command = message.data[0];
+    switch (m_state) {
+        case INITIATING_BLOCK:
+            if ((command & 0xE1) != (SDO_BLOCK_UPLOAD_SERVER | SDO_BLOCK_INITIATE)) {
+                return false;
+            }
+            m_server_crc = command & SDO_BLOCK_CRC;
+            m_size_indicated = command & SDO_BLOCK_SIZE_INDICATED;
+            m_size = readUInt32(message.data + 4);
+            m_data.clear();
+            m_expected_sequence = 1;
+            m_last_received = false;
+            messages.push_back(makeSegment(SDO_BLOCK_UPLOAD_CLIENT | SDO_BLOCK_START));
+            m_state = RECEIVING_BLOCK;
+            return true;
+
+        case RECEIVING_BLOCK:
+            processBlockSegment(message, messages);
+            return true;
+
+        case ENDING_BLOCK:
+            if ((command & 0xE3) != (SDO_BLOCK_UPLOAD_SERVER | SDO_BLOCK_END)) {
+                return false;
+            }
+            processBlockEnd(message, messages);
+            return true;
+
+        case INITIATING_SEGMENTED:
+            if ((command & SDO_COMMAND_MASK) != SDO_INITIATE_UPLOAD) {
+                return false;
+            }
+            processSegmentedInitiate(message, messages);
+            return true;
+
+        case RECEIVING_SEGMENT:
+            if ((command & SDO_COMMAND_MASK) != SDO_UPLOAD_SEGMENT_REPLY) {
+                return false;
+            }
+            processSegment(message, messages);
+            return true;
+    }
+    return false;
+}
+
+void SDOBlockUpload::processBlockSegment(
+    canbus::Message const& message, vector<canbus::Message>& messages
+) {
+    int sequence = message.data[0] & ~SDO_BLOCK_LAST_SEGMENT;
+    bool last = message.data[0] & SDO_BLOCK_LAST_SEGMENT;
+    if (sequence < 1 || sequence > m_block_size) {
+        abortWithCode(SDO_ABORT_INVALID_SEQUENCE, messages);
+        return;
+    }
+
+    // Out-of-order segments are dropped. The acknowledgment tells the node
+    // to resend them
+    if (sequence == m_expected_sequence) {
+        m_data.insert(m_data.end(), message.data + 1, message.data + 8);
+        ++m_expected_sequence;
+        m_last_received = last;
+    }
+
+    if (last || sequence == m_block_size) {
+        sendBlockAck(messages);
+    }
+}
+
+void SDOBlockUpload::sendBlockAck(vector<canbus::Message>& messages) {
+    canbus::Message message = makeSegment(SDO_BLOCK_UPLOAD_CLIENT | SDO_BLOCK_ACK);
+    message.data[1] = m_expected_sequence - 1;
+    message.data[2] = m_block_size;
+    messages.push_back(message);
+
+    m_expected_sequence = 1;
+    if (m_last_received) {
+        m_state = ENDING_BLOCK;
+    }
+}
+
+void SDOBlockUpload::processBlockEnd(
+    canbus::Message const& message, vector<canbus::Message>& messages
+) {
+    size_t unused = (message.data[0] >> 2) & 0x7;
+    m_data.resize(m_data.size() - std::min(unused, m_data.size()));
+    if (m_size_indicated && m_data.size() != m_size) {
+        abortWithCode(SDO_ABORT_DATA_LENGTH_MISMATCH, messages);
+        return;
+    }
+
+    if (m_crc && m_server_crc) {
+        uint16_t crc = message.data[1] | (message.data[2] << 8);
+        if (crc != computeSDOBlockCRC(m_data.data(), m_data.size())) {
+            abortWithCode(SDO_ABORT_CRC_ERROR, messages);
+            return;
+        }
+    }
+
+    messages.push_back(makeSegment(SDO_BLOCK_UPLOAD_CLIENT | SDO_BLOCK_END));
+    complete();
+}
+
+void SDOBlockUpload::processSegmentedInitiate(
+    canbus::Message const& message, vector<canbus::Message>& messages
+) {
+    uint8_t command = message.data[0];
+    m_size_indicated = command & SDO_SIZE_INDICATED;
+    m_data.clear();
+    if (command & SDO_EXPEDITED) {
+        size_t unused = m_size_indicated ? ((command >> 2) & 0x3) : 0;
+        m_data.assign(message.data + 4, message.data + 8 - unused);
+        m_protocol = SDO_PROTOCOL_EXPEDITED;
+        complete();
+        return;
+    }
+
+    m_size = readUInt32(message.data + 4);
+    m_toggle = false;
+    m_state = RECEIVING_SEGMENT;
+    requestSegment(messages);
+}
+
+void SDOBlockUpload::processSegment(
+    canbus::Message const& message, vector<canbus::Message>& messages
+) {
+    uint8_t command = message.data[0];
+    if (static_cast<bool>(command & SDO_TOGGLE) != m_toggle) {
+        abortWithCode(SDO_ABORT_TOGGLE_BIT, messages);
+        return;
+    }
+
+    size_t unused = (command >> 1) & 0x7;
+    m_data.insert(m_data.end(), message.data + 1, message.data + 8 - unused);
+    if (!(command & SDO_LAST_SEGMENT)) {
+        m_toggle = !m_toggle;
+        requestSegment(messages);
+    }
+    else if (m_size_indicated && m_data.size() != m_size) {
+        abortWithCode(SDO_ABORT_DATA_LENGTH_MISMATCH, messages);
+    }
+    else {
+        complete();
+    }
+}
+
+void SDOBlockUpload::requestSegment(vector<canbus::Message>& messages) {
+    messages.push_back(makeSegment(SDO_UPLOAD_SEGMENT | (m_toggle ? SDO_TOGGLE : 0)));
+}
+
+vector<uint8_t> const& SDOBlockUpload::getData() const {
+    return m_data;
+}
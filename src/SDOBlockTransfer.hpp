@@ -0,0 +1,217 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_SDOBLOCKTRANSFER_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_SDOBLOCKTRANSFER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <canbus/Message.hpp>
+
+namespace motors_roboteq_canopen {
+    /** SDO abort codes used by the SDO transfers (CiA 301) */
+    enum SDOAbortCodes {
+        SDO_ABORT_TOGGLE_BIT = 0x05030000,
+        SDO_ABORT_TIMEOUT = 0x05040000,
+        SDO_ABORT_INVALID_COMMAND = 0x05040001,
+        SDO_ABORT_INVALID_BLOCK_SIZE = 0x05040002,
+        SDO_ABORT_INVALID_SEQUENCE = 0x05040003,
+        SDO_ABORT_CRC_ERROR = 0x05040004,
+        SDO_ABORT_DATA_LENGTH_MISMATCH = 0x06070010
+    };
+
+    /** The SDO protocol a transfer ended up using */
+    enum SDOTransferProtocols {
+        SDO_PROTOCOL_BLOCK,
+        SDO_PROTOCOL_SEGMENTED,
+        SDO_PROTOCOL_EXPEDITED
+    };
+
+    enum SDOTransferStatus {
+        SDO_TRANSFER_RUNNING,
+        SDO_TRANSFER_COMPLETED,
+        SDO_TRANSFER_ABORTED
+    };
+
+    /** CRC of the block transfers
+     *
+     * CRC-16 with polynomial x^16 + x^12 + x^5 + 1 and zero initial value
+     */
+    uint16_t computeSDOBlockCRC(uint8_t const* data, size_t size, uint16_t crc = 0);
+
+    /**
+     * Common part of SDOBlockDownload and SDOBlockUpload
+     *
+     * A transfer is started with start(), and then driven by passing the
+     * messages received from the node to process(). Both append the messages
+     * that should be sent to the vector they are given.
+     *
+     * The transfer starts as a block transfer. If the node aborts the block
+     * initiation, it falls back to a segmented transfer, or expedited for
+     * downloads of 4 bytes or less.
+     *
+     * Timeouts are left to the caller, which should call abort() with
+     * SDO_ABORT_TIMEOUT when the node stops answering.
+     *
+     * The Roboteq objects are at most 4 bytes long and are always read and
+     * written with expedited transfers, so the drivers do not use block
+     * transfers. They are meant for the other CiA 301 nodes of the bus that
+     * expose larger objects, whose transfers they shorten from one round
+     * trip per 7 bytes to one per block of up to 127 segments.
+     */
+    class SDOBlockTransfer {
+    public:
+        /** Number of data bytes in a block or segmented transfer segment */
+        static const int SEGMENT_SIZE = 7;
+        /** Maximum number of segments in a block */
+        static const int MAX_BLOCK_SIZE = 127;
+
+    protected:
+        int m_node_id;
+        int m_object_id;
+        int m_sub_id;
+        bool m_crc;
+
+        SDOTransferStatus m_status = SDO_TRANSFER_RUNNING;
+        SDOTransferProtocols m_protocol = SDO_PROTOCOL_BLOCK;
+        uint32_t m_abort_code = 0;
+        bool m_toggle = false;
+
+        SDOBlockTransfer(int node_id, int object_id, int sub_id, bool crc);
+
+        canbus::Message makeMessage(uint8_t command) const;
+        canbus::Message makeSegment(uint8_t command) const;
+        bool isFromNode(canbus::Message const& message) const;
+        bool isAbort(canbus::Message const& message) const;
+        void complete();
+        void abortWithCode(uint32_t code, std::vector<canbus::Message>& messages);
+
+    public:
+        SDOTransferStatus getStatus() const;
+        bool isFinished() const;
+
+        /** The protocol being used, which changes if the node refuses the
+         * block transfer
+         */
+        SDOTransferProtocols getProtocol() const;
+
+        /** The abort code, sent or received, if the transfer was aborted */
+        uint32_t getAbortCode() const;
+
+        /** Abort the transfer, e.g. on timeout
+         *
+         * Does nothing if the transfer is already finished
+         */
+        void abort(uint32_t code, std::vector<canbus::Message>& messages);
+    };
+
+    /** Client side of a SDO block download, i.e. a write to a node
+     *
+     * @see SDOBlockTransfer
+     */
+    class SDOBlockDownload : public SDOBlockTransfer {
+        enum States {
+            INITIATING_BLOCK,
+            SENDING_BLOCK,
+            ENDING_BLOCK,
+            INITIATING_SEGMENTED,
+            SENDING_SEGMENT
+        };
+        States m_state = INITIATING_BLOCK;
+
+        std::vector<uint8_t> m_data;
+        size_t m_segment_count;
+        bool m_server_crc = false;
+        size_t m_block_start = 0;
+        size_t m_block_segments = 0;
+        size_t m_next_segment = 0;
+
+        void sendBlock(int block_size, std::vector<canbus::Message>& messages);
+        void sendEnd(std::vector<canbus::Message>& messages);
+        void sendSegment(std::vector<canbus::Message>& messages);
+        void fallback(std::vector<canbus::Message>& messages);
+
+    public:
+        /**
+         * @param crc whether the CRC should be used, if the node supports it
+         */
+        SDOBlockDownload(
+            int node_id, int object_id, int sub_id,
+            std::vector<uint8_t> const& data, bool crc = true
+        );
+
+        /** Start the transfer */
+        void start(std::vector<canbus::Message>& messages);
+
+        /** Process a message received from the node
+         *
+         * @return true if the message was part of this transfer
+         */
+        bool process(canbus::Message const& message, std::vector<canbus::Message>& messages);
+    };
+
+    /** Client side of a SDO block upload, i.e. a read from a node
+     *
+     * @see SDOBlockTransfer
+     */
+    class SDOBlockUpload : public SDOBlockTransfer {
+        enum States {
+            INITIATING_BLOCK,
+            RECEIVING_BLOCK,
+            ENDING_BLOCK,
+            INITIATING_SEGMENTED,
+            RECEIVING_SEGMENT
+        };
+        States m_state = INITIATING_BLOCK;
+
+        int m_block_size;
+        bool m_server_crc = false;
+        bool m_size_indicated = false;
+        uint32_t m_size = 0;
+        int m_expected_sequence = 1;
+        bool m_last_received = false;
+        std::vector<uint8_t> m_data;
+
+        void sendBlockAck(std::vector<canbus::Message>& messages);
+        void processBlockSegment(
+            canbus::Message const& message, std::vector<canbus::Message>& messages
+        );
+        void processBlockEnd(
+            canbus::Message const& message, std::vector<canbus::Message>& messages
+        );
+        void processSegmentedInitiate(
+            canbus::Message const& message, std::vector<canbus::Message>& messages
+        );
+        void processSegment(
+            canbus::Message const& message, std::vector<canbus::Message>& messages
+        );
+        void requestSegment(std::vector<canbus::Message>& messages);
+
+    public:
+        /**
+         * @param block_size the number of segments the node may send before
+         *   waiting for an acknowledgment, between 1 and MAX_BLOCK_SIZE
+         * @param crc whether the CRC should be used, if the node supports it
+         * @throw std::invalid_argument if the block size is out of range
+         */
+        SDOBlockUpload(
+            int node_id, int object_id, int sub_id,
+            int block_size = MAX_BLOCK_SIZE, bool crc = true
+        );
+
+        /** Start the transfer */
+        void start(std::vector<canbus::Message>& messages);
+
+        /** Process a message received from the node
+         *
+         * @return true if the message was part of this transfer
+         */
+        bool process(canbus::Message const& message, std::vector<canbus::Message>& messages);
+
+        /** The received data
+         *
+         * It is complete only once the status is SDO_TRANSFER_COMPLETED
+         */
+        std::vector<uint8_t> const& getData() const;
+    };
+}
+
+#endif
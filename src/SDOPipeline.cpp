@@ -0,0 +1,187 @@
+#include <motors_roboteq_canopen/SDOPipeline.hpp>
+
+#include <canopen_master/Functions.hpp>
+#include <canopen_master/SDO.hpp>
+#include <stdexcept>
+
+using namespace std;
+using namespace motors_roboteq_canopen;
+
+const int SDOPipeline::DEFAULT_MAX_RESULTS;
+
+SDOPipeline::SDOPipeline(int node_id, base::Time const& timeout, int max_retries)
+    : m_node_id(node_id)
+    , m_timeout(timeout)
+    , m_max_retries(max_retries) {
+    if (timeout <= base::Time()) {
+        throw invalid_argument("the SDO timeout must be strictly positive");
+    }
+    else if (max_retries < 0) {
+        throw invalid_argument("the number of retries cannot be negative");
+    }
+}
+
+void SDOPipeline::push(canbus::Message const& query) {
+    if (query.can_id != static_cast<uint32_t>(
+            canopen_master::FUNCTION_SDO_RECEIVE | m_node_id)) {
+        throw invalid_argument("message is not a SDO query to this node");
+    }
+    m_queue.push_back(query);
+}
+
+void SDOPipeline::push(vector<canbus::Message> const& queries) {
+    for (auto const& query : queries) {
+        push(query);
+    }
+}
+
+bool SDOPipeline::isReply(canbus::Message const& message) const {
+    if (message.can_id != static_cast<uint32_t>(
+            canopen_master::FUNCTION_SDO_TRANSMIT | m_node_id)) {
+        return false;
+    }
+
+    canbus::Message const& query = m_current.query;
+    return canopen_master::getSDOObjectID(message) ==
+               canopen_master::getSDOObjectID(query) &&
+           canopen_master::getSDOObjectSubID(message) ==
+               canopen_master::getSDOObjectSubID(query);
+}
+
+bool SDOPipeline::process(
+    canbus::Message const& message, base::Time const& time,
+    vector<canbus::Message>& messages
+) {
+    if (!m_in_flight || !isReply(message)) {
+        return false;
+    }
+
+    auto command = canopen_master::getSDOCommand(message).command;
+    auto query_command = canopen_master::getSDOCommand(m_current.query).command;
+    if (command == canopen_master::SDO_ABORT_DOMAIN_TRANSFER) {
+        m_current.reply = message;
+        finish(SDO_TRANSACTION_ABORTED, time);
+    }
+    else if ((query_command == canopen_master::SDO_INITIATE_DOMAIN_DOWNLOAD &&
+              command == canopen_master::SDO_INITIATE_DOMAIN_DOWNLOAD_REPLY) ||
+             (query_command == canopen_master::SDO_INITIATE_DOMAIN_UPLOAD &&
+              command == canopen_master::SDO_INITIATE_DOMAIN_UPLOAD)) {
+        m_current.reply = message;
+        finish(SDO_TRANSACTION_COMPLETED, time);
+    }
+    else {
+        return false;
+    }
+
+    update(time, messages);
+    return true;
+}
+
+void SDOPipeline::update(base::Time const& time, vector<canbus::Message>& messages) {
+    if (m_in_flight && time - m_last_sent >= m_timeout) {
+        if (m_current.attempts <= m_max_retries) {
+            ++m_retry_count;
+            send(time, messages);
+        }
+        else {
+            finish(SDO_TRANSACTION_TIMED_OUT, time);
+        }
+    }
+
+    if (!m_in_flight && !m_queue.empty()) {
+        m_current = SDOTransactionResult();
+        m_current.query = m_queue.front();
+        m_queue.pop_front();
+        m_first_sent = time;
+        m_in_flight = true;
+        send(time, messages);
+    }
+}
+
+void SDOPipeline::send(base::Time const& time, vector<canbus::Message>& messages) {
+    m_last_sent = time;
+    ++m_current.attempts;
+    messages.push_back(m_current.query);
+}
+
+void SDOPipeline::finish(SDOTransactionStatus status, base::Time const& time) {
+    m_current.status = status;
+    m_current.duration = time - m_first_sent;
+    if (status == SDO_TRANSACTION_COMPLETED) {
+        m_current.latency = time - m_last_sent;
+        if (m_current.latency > m_max_latency) {
+            m_max_latency = m_current.latency;
+        }
+        ++m_completed_count;
+    }
+    else {
+        if (status == SDO_TRANSACTION_ABORTED) {
+            m_current.latency = time - m_last_sent;
+        }
+        ++m_failed_count;
+    }
+
+    if (m_max_results != 0) {
+        if (m_results.size() == m_max_results) {
+            m_results.pop_front();
+        }
+        m_results.push_back(m_current);
+    }
+    m_in_flight = false;
+}
+
+base::Time SDOPipeline::getDeadline() const {
+    if (!m_in_flight) {
+        return base::Time();
+    }
+    return m_last_sent + m_timeout;
+}
+
+void SDOPipeline::clear() {
+    m_queue.clear();
+    m_in_flight = false;
+}
+
+bool SDOPipeline::isIdle() const {
+    return !m_in_flight && m_queue.empty();
+}
+
+size_t SDOPipeline::getQueuedCount() const {
+    return m_queue.size();
+}
+
+bool SDOPipeline::readResult(SDOTransactionResult& result) {
+    if (m_results.empty()) {
+        return false;
+    }
+    result = m_results.front();
+    m_results.pop_front();
+    return true;
+}
+
+void SDOPipeline::setMaxResults(size_t count) {
+    m_max_results = count;
+    while (m_results.size() > m_max_results) {
+        m_results.pop_front();
+    }
+}
+
+size_t SDOPipeline::getMaxResults() const {
+    return m_max_results;
+}
+
+uint64_t SDOPipeline::getCompletedCount() const {
+    return m_completed_count;
+}
+
+uint64_t SDOPipeline::getFailedCount() const {
+    return m_failed_count;
+}
+
+uint64_t SDOPipeline::getRetryCount() const {
+    return m_retry_count;
+}
+
+base::Time SDOPipeline::getMaxLatency() const {
+    return m_max_latency;
+}
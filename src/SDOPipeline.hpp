@@ -0,0 +1,161 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_SDOPIPELINE_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_SDOPIPELINE_HPP
+
+#include <deque>
+#include <vector>
+
+#include <base/Time.hpp>
+#include <canbus/Message.hpp>
+
+namespace motors_roboteq_canopen {
+    /** Outcome of a SDO transaction */
+    enum SDOTransactionStatus {
+        /** The server replied with the expected reply */
+        SDO_TRANSACTION_COMPLETED,
+        /** The server replied with an abort */
+        SDO_TRANSACTION_ABORTED,
+        /** No reply was received, even after the retries */
+        SDO_TRANSACTION_TIMED_OUT
+    };
+
+    /** A finished SDO transaction
+     *
+     * @see SDOPipeline::readResult
+     */
+    struct SDOTransactionResult {
+        SDOTransactionStatus status = SDO_TRANSACTION_TIMED_OUT;
+        canbus::Message query;
+        /** The reply, valid unless the transaction timed out */
+        canbus::Message reply;
+        /** How many times the query has been sent */
+        int attempts = 0;
+        /** Time between the last emission of the query and its reply */
+        base::Time latency;
+        /** Time between the first emission of the query and the end of the
+         * transaction
+         */
+        base::Time duration;
+    };
+
+    /**
+     * Sequences the SDO transactions with a single node
+     *
+     * A SDO server handles one transaction at a time. The pipeline queues the
+     * SDO queries generated by the drivers' query* and setup methods, and
+     * sends the next one as soon as the reply to the previous one has been
+     * received. Transactions that are not answered within the timeout are
+     * retried, and then reported as timed out.
+     *
+     * The pipeline only deals with the sequencing. Received messages must
+     * still be processed by the driver to update its object dictionary.
+     * Only expedited transfers are supported.
+     */
+    class SDOPipeline {
+    public:
+        /** Default maximum number of results kept for readResult */
+        static const int DEFAULT_MAX_RESULTS = 1024;
+
+    private:
+        int m_node_id;
+        base::Time m_timeout;
+        int m_max_retries;
+        size_t m_max_results = DEFAULT_MAX_RESULTS;
+
+        std::deque<canbus::Message> m_queue;
+
+        bool m_in_flight = false;
+        SDOTransactionResult m_current;
+        base::Time m_first_sent;
+        base::Time m_last_sent;
+
+        std::deque<SDOTransactionResult> m_results;
+        uint64_t m_completed_count = 0;
+        uint64_t m_failed_count = 0;
+        uint64_t m_retry_count = 0;
+        base::Time m_max_latency;
+
+        bool isReply(canbus::Message const& message) const;
+        void send(base::Time const& time, std::vector<canbus::Message>& messages);
+        void finish(SDOTransactionStatus status, base::Time const& time);
+
+    public:
+        /**
+         * @param node_id the ID of the node whose SDO server is addressed
+         * @param timeout how long to wait for a reply before resending
+         * @param max_retries how many times a query is resent before the
+         *   transaction is reported as timed out
+         */
+        SDOPipeline(int node_id, base::Time const& timeout, int max_retries = 2);
+
+        /** Queue a SDO query
+         *
+         * @throw std::invalid_argument if the message is not a SDO query to
+         *   this pipeline's node
+         */
+        void push(canbus::Message const& query);
+
+        /** Queue SDO queries */
+        void push(std::vector<canbus::Message> const& queries);
+
+        /** Process a received message
+         *
+         * If it is the reply to the transaction in flight, the transaction is
+         * finished and the next query is appended to \c messages
+         *
+         * @return true if the message was the reply to the transaction in
+         *   flight
+         */
+        bool process(
+            canbus::Message const& message, base::Time const& time,
+            std::vector<canbus::Message>& messages
+        );
+
+        /** Start the next transaction if none is in flight, and handle
+         * timeouts
+         *
+         * @param messages the vector to which the query to send, if any, is
+         *   appended
+         */
+        void update(base::Time const& time, std::vector<canbus::Message>& messages);
+
+        /** Time at which update() should be called next to detect a timeout,
+         * or null if no transaction is in flight
+         */
+        base::Time getDeadline() const;
+
+        /** Drop the queued transactions, and forget the one in flight */
+        void clear();
+
+        /** Whether there are no transactions in flight nor queued */
+        bool isIdle() const;
+
+        /** Number of queued transactions, not counting the one in flight */
+        size_t getQueuedCount() const;
+
+        /** Read the oldest finished transaction
+         *
+         * At most getMaxResults() results are kept, the oldest being dropped
+         *
+         * @return false if there are no results to read
+         */
+        bool readResult(SDOTransactionResult& result);
+
+        /** Change the maximum number of results kept for readResult */
+        void setMaxResults(size_t count);
+        size_t getMaxResults() const;
+
+        /** Number of transactions that completed successfully */
+        uint64_t getCompletedCount() const;
+
+        /** Number of transactions that were aborted or timed out */
+        uint64_t getFailedCount() const;
+
+        /** Number of times a query has been resent after a timeout */
+        uint64_t getRetryCount() const;
+
+        /** Largest latency of a completed transaction */
+        base::Time getMaxLatency() const;
+    };
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_SPSCQUEUE_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_SPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace motors_roboteq_canopen {
+    /** Bounded lock-free single-producer/single-consumer queue
+     *
+     * push() may only be called from one thread, and pop() from one (other)
+     * thread. Both are wait-free. The storage is allocated once in the
+     * constructor.
+     */
+    template<typename T>
+    class SPSCQueue {
+        static const size_t CACHE_LINE_SIZE = 64;
+
+        std::vector<T> m_storage;
+        size_t m_mask;
+
+        // The padding keeps the producer and consumer indexes in separate
+        // cache lines
+        char m_padding0[CACHE_LINE_SIZE];
+        std::atomic<size_t> m_head;
+        char m_padding1[CACHE_LINE_SIZE];
+        std::atomic<size_t> m_tail;
+
+        static size_t roundUpToPowerOfTwo(size_t value) {
+            size_t result = 1;
+            while (result < value) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+    public:
+        /** Create a queue that can hold at least the given number of elements
+         *
+         * The actual capacity is rounded up to the next power of two
+         */
+        explicit SPSCQueue(size_t capacity)
+            : m_storage(roundUpToPowerOfTwo(capacity))
+            , m_mask(m_storage.size() - 1)
+            , m_head(0)
+            , m_tail(0) {}
+
+        SPSCQueue(SPSCQueue const&) = delete;
+        SPSCQueue& operator=(SPSCQueue const&) = delete;
+
+        /** How many elements the queue can hold */
+        size_t capacity() const {
+            return m_storage.size();
+        }
+
+        /** Push a new element at the back of the queue (producer side)
+         *
+         * @return false if the queue is full, in which case the element is
+         *   dropped
+         */
+        bool push(T const& value) {
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+            size_t head = m_head.load(std::memory_order_acquire);
+            if (tail - head == m_storage.size()) {
+                return false;
+            }
+
+            m_storage[tail & m_mask] = value;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Pop the element at the front of the queue (consumer side)
+         *
+         * @return false if the queue is empty
+         */
+        bool pop(T& value) {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            size_t tail = m_tail.load(std::memory_order_acquire);
+            if (head == tail) {
+                return false;
+            }
+
+            value = m_storage[head & m_mask];
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Approximate number of elements in the queue
+         *
+         * The value is exact only if neither push nor pop run concurrently
+         */
+        size_t size() const {
+            return m_tail.load(std::memory_order_acquire) -
+                   m_head.load(std::memory_order_acquire);
+        }
+    };
+}
+
+#endif
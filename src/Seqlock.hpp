@@ -0,0 +1,66 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_SEQLOCK_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_SEQLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace motors_roboteq_canopen {
+    /** Sequence lock protecting a trivially copyable value
+     *
+     * A single writer publishes new values with write() without ever
+     * blocking. Any number of readers copy the value with read(). Readers
+     * retry when they raced with the writer, and never block it.
+     */
+    template<typename T>
+    class Seqlock {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Seqlock requires a trivially copyable type");
+
+        std::atomic<uint32_t> m_sequence;
+        T m_value;
+
+    public:
+        Seqlock()
+            : m_sequence(0)
+            , m_value() {}
+
+        Seqlock(Seqlock const&) = delete;
+        Seqlock& operator=(Seqlock const&) = delete;
+
+        /** Publish a new value
+         *
+         * Only one thread may call this method
+         */
+        void write(T const& value) {
+            uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+            m_sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_value = value;
+            m_sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        /** Copy the last published value
+         *
+         * @return the version of the copied value. It is incremented by two on
+         *   each write, and is zero if nothing has been written yet
+         */
+        uint32_t read(T& value) const {
+            while (true) {
+                uint32_t before = m_sequence.load(std::memory_order_acquire);
+                if (before & 1) {
+                    continue;
+                }
+
+                value = m_value;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                uint32_t after = m_sequence.load(std::memory_order_relaxed);
+                if (before == after) {
+                    return before;
+                }
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,156 @@
+#include <motors_roboteq_canopen/SyncScheduler.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace motors_roboteq_canopen;
+
+const int SyncScheduler::SYNC_COBID;
+
+SyncScheduler::SyncScheduler(
+    Bus& bus, base::Time const& period,
+    base::Time const& collection_deadline, base::Time const& rpdo_phase
+)
+    : m_bus(bus)
+    , m_period(period)
+    , m_collection_deadline(collection_deadline)
+    , m_rpdo_phase(rpdo_phase) {
+    if (collection_deadline <= base::Time() ||
+        rpdo_phase < collection_deadline || period <= rpdo_phase) {
+        throw invalid_argument(
+            "SyncScheduler expects 0 < collection_deadline <= rpdo_phase < period"
+        );
+    }
+}
+
+void SyncScheduler::process(canbus::Message const& message, base::Time const& time) {
+    m_bus.process(message);
+    if (m_collecting && m_bus.areAllChannelsReady()) {
+        deliverSnapshot(time);
+    }
+}
+
+void SyncScheduler::update(base::Time const& time, vector<canbus::Message>& messages) {
+    if (!m_started || time >= m_next_sync) {
+        startCycle(time, messages);
+    }
+
+    base::Time sync_time = m_cycle.sync_time;
+    if (m_collecting && time >= sync_time + m_collection_deadline) {
+        deliverSnapshot(time);
+    }
+
+    if (m_rpdo_pending && time >= sync_time + m_rpdo_phase) {
+        m_bus.getRPDOMessages(messages);
+        m_rpdo_pending = false;
+    }
+}
+
+void SyncScheduler::startCycle(base::Time const& time, vector<canbus::Message>& messages) {
+    if (m_collecting) {
+        // update() has not been called at the deadline of the previous cycle
+        deliverSnapshot(time);
+    }
+    if (m_rpdo_pending) {
+        // Same for the RPDO emission. Synchronous RPDOs are applied at the
+        // next SYNC, send them before it so that the command is not lost
+        m_bus.getRPDOMessages(messages);
+        m_rpdo_pending = false;
+        ++m_late_rpdos;
+    }
+
+    if (!m_started) {
+        m_started = true;
+        m_next_sync = time;
+    }
+    else {
+        ++m_cycle.index;
+    }
+
+    m_next_sync = m_next_sync + m_period;
+    while (m_next_sync <= time) {
+        m_next_sync = m_next_sync + m_period;
+        ++m_skipped_cycles;
+    }
+    if (m_next_sync - time <= m_rpdo_phase) {
+        // Too late to fit the RPDO emission before the next SYNC on the
+        // original schedule, restart it from this SYNC
+        m_next_sync = time + m_period;
+    }
+
+    canbus::Message sync;
+    sync.time = time;
+    sync.can_id = SYNC_COBID;
+    sync.size = 0;
+    messages.push_back(sync);
+
+    m_bus.resetJointStateTracking();
+    m_cycle.sync_time = time;
+    m_collecting = true;
+    m_rpdo_pending = true;
+}
+
+void SyncScheduler::deliverSnapshot(base::Time const& time) {
+    // Drivers may have been added to the bus since the last cycle. This does
+    // not allocate once the size is stable
+    m_cycle.joints.elements.resize(m_bus.getChannelCount());
+
+    uint64_t ready = m_bus.getReadyChannels();
+    m_bus.readJointStates(m_cycle.joints.elements.data(), ready);
+    int channel_index = m_bus.getChannelCount();
+
+    uint64_t all = (channel_index == Bus::MAX_CHANNELS) ?
+        ~0ULL : ((1ULL << channel_index) - 1);
+    m_cycle.stale_channels = all & ~ready;
+    if (m_cycle.stale_channels) {
+        ++m_missed_deadlines;
+    }
+
+    m_cycle.snapshot_time = time;
+    m_cycle.slack = m_cycle.sync_time + m_rpdo_phase - time;
+    m_cycle.joints.time = base::Time();
+    for (size_t i = 0; i < m_bus.getDriverCount(); ++i) {
+        DriverBase& driver = m_bus.getDriver(i);
+        for (size_t j = 0; j < driver.getChannelCount(); ++j) {
+            base::Time newest = driver.getChannel(j).getJointStateTimestamps().newest;
+            if (newest > m_cycle.joints.time) {
+                m_cycle.joints.time = newest;
+            }
+        }
+    }
+    m_collecting = false;
+    m_has_new_cycle = true;
+}
+
+base::Time SyncScheduler::getNextEventTime() const {
+    base::Time next = m_next_sync;
+    if (m_collecting) {
+        next = std::min(next, m_cycle.sync_time + m_collection_deadline);
+    }
+    if (m_rpdo_pending) {
+        next = std::min(next, m_cycle.sync_time + m_rpdo_phase);
+    }
+    return next;
+}
+
+bool SyncScheduler::readCycle(SyncCycle& cycle) {
+    if (!m_has_new_cycle) {
+        return false;
+    }
+    cycle = m_cycle;
+    m_has_new_cycle = false;
+    return true;
+}
+
+uint64_t SyncScheduler::getMissedDeadlineCount() const {
+    return m_missed_deadlines;
+}
+
+uint64_t SyncScheduler::getSkippedCycleCount() const {
+    return m_skipped_cycles;
+}
+
+uint64_t SyncScheduler::getLateRPDOCount() const {
+    return m_late_rpdos;
+}
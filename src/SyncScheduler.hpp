@@ -0,0 +1,150 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_SYNCSCHEDULER_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_SYNCSCHEDULER_HPP
+
+#include <vector>
+
+#include <base/Time.hpp>
+#include <base/samples/Joints.hpp>
+#include <canbus/Message.hpp>
+#include <motors_roboteq_canopen/Bus.hpp>
+
+namespace motors_roboteq_canopen {
+    /** Result of one cycle of SyncScheduler */
+    struct SyncCycle {
+        /** Index of the cycle, starting at zero */
+        uint64_t index = 0;
+
+        /** Time at which the SYNC message has been generated */
+        base::Time sync_time;
+
+        /** Time at which the snapshot has been delivered, i.e. either when
+         * the last joint state has been received or the collection deadline
+         */
+        base::Time snapshot_time;
+
+        /** Bitmask of the bus channels whose joint state has not been
+         * received before the collection deadline
+         *
+         * The joint states of these channels are the ones of the last cycle
+         * in which they were received. Bit N is the channel whose bus-wide
+         * index is N (see Bus::getChannelIndex)
+         */
+        uint64_t stale_channels = 0;
+
+        /** Time left between the snapshot and the scheduled RPDO emission
+         *
+         * It is the time the caller has to compute the next command. It is
+         * negative if the snapshot got delivered after the RPDO emission
+         * point, which can only happen if update() is not called often enough
+         */
+        base::Time slack;
+
+        /** Joint states of all the bus channels, in bus-wide index order
+         *
+         * Its time is the reception time of the newest joint state field
+         * (see ChannelBase::getJointStateTimestamps), not the time of the
+         * snapshot
+         */
+        base::samples::Joints joints;
+    };
+
+    /**
+     * Drives the SYNC-based communication cycle of a Bus
+     *
+     * Each cycle is made of:
+     * - a SYNC message, generated every \c period
+     * - the collection of the synchronous TPDOs, until either all channels
+     *   reported a complete joint state or the collection deadline has
+     *   passed. The resulting snapshot is made available through readCycle,
+     *   with the channels that did not report marked as stale
+     * - the emission of the RPDOs, at a fixed phase offset from the SYNC.
+     *   If update() is called too late to emit them before the next SYNC,
+     *   they are emitted right before it, so that the controllers still
+     *   apply them at that SYNC
+     *
+     * The scheduler does not own a thread nor a clock. The caller passes
+     * received messages to process() and calls update() at least at the
+     * times returned by getNextEventTime(). The messages to send are appended
+     * to the vector given to update().
+     */
+    class SyncScheduler {
+        Bus& m_bus;
+        base::Time m_period;
+        base::Time m_collection_deadline;
+        base::Time m_rpdo_phase;
+
+        bool m_started = false;
+        base::Time m_next_sync;
+        bool m_collecting = false;
+        bool m_rpdo_pending = false;
+        bool m_has_new_cycle = false;
+
+        uint64_t m_missed_deadlines = 0;
+        uint64_t m_skipped_cycles = 0;
+        uint64_t m_late_rpdos = 0;
+
+        SyncCycle m_cycle;
+
+        void startCycle(base::Time const& time, std::vector<canbus::Message>& messages);
+        void deliverSnapshot(base::Time const& time);
+
+    public:
+        /** COB-ID of the SYNC message */
+        static const int SYNC_COBID = 0x80;
+
+        /**
+         * @param bus the bus whose cycle is driven. Its TPDOs are expected to
+         *   be configured as synchronous
+         * @param period the SYNC period
+         * @param collection_deadline the time after the SYNC after which the
+         *   snapshot is delivered even if some channels did not report
+         * @param rpdo_phase the time after the SYNC at which the RPDOs are
+         *   emitted
+         * @throw std::invalid_argument unless
+         *   0 < collection_deadline <= rpdo_phase < period
+         */
+        SyncScheduler(
+            Bus& bus, base::Time const& period,
+            base::Time const& collection_deadline, base::Time const& rpdo_phase
+        );
+
+        /** Process a message received on the bus
+         *
+         * It is passed to Bus::process. If it completes the collection, the
+         * cycle's snapshot is delivered
+         */
+        void process(canbus::Message const& message, base::Time const& time);
+
+        /** Advance the cycle to the given time
+         *
+         * @param messages the vector to which the SYNC and RPDO messages that
+         *   should be sent are appended
+         */
+        void update(base::Time const& time, std::vector<canbus::Message>& messages);
+
+        /** Time at which update() should be called next */
+        base::Time getNextEventTime() const;
+
+        /** Read the snapshot of the last cycle
+         *
+         * @return true if a new snapshot has been delivered since the last
+         *   call, false otherwise (in which case \c cycle is left unchanged)
+         */
+        bool readCycle(SyncCycle& cycle);
+
+        /** How many cycles had at least one stale channel */
+        uint64_t getMissedDeadlineCount() const;
+
+        /** How many SYNC periods were skipped because update() was called
+         * too late
+         */
+        uint64_t getSkippedCycleCount() const;
+
+        /** How many cycles had their RPDOs emitted only right before the next
+         * SYNC because update() was not called at the RPDO phase
+         */
+        uint64_t getLateRPDOCount() const;
+    };
+}
+
+#endif
@@ -0,0 +1,79 @@
+#include <motors_roboteq_canopen/TPDOPlanner.hpp>
+#include <motors_roboteq_canopen/Exceptions.hpp>
+
+#include <algorithm>
+#include <string>
+
+using namespace std;
+using namespace canopen_master;
+using namespace motors_roboteq_canopen;
+
+const int TPDOPlanner::PDO_SIZE;
+
+TPDOPlanner::TPDOPlanner(int max_pdo_count)
+    : m_max_pdo_count(max_pdo_count) {
+}
+
+void TPDOPlanner::add(int object_id, int sub_id, int size) {
+    if (size != 1 && size != 2 && size != 4) {
+        throw invalid_argument("PDO-mapped objects must be 1, 2 or 4 bytes");
+    }
+
+    for (auto const& object : m_objects) {
+        if (object.objectId == object_id && object.subId == sub_id) {
+            return;
+        }
+    }
+    m_objects.push_back(PDOMapping::MappedObject{object_id, sub_id, size});
+}
+
+void TPDOPlanner::add(PDOMapping const& mapping) {
+    for (auto const& object : mapping.mappings) {
+        add(object.objectId, object.subId, object.size);
+    }
+}
+
+size_t TPDOPlanner::getObjectCount() const {
+    return m_objects.size();
+}
+
+int TPDOPlanner::getFrameCount() const {
+    int total = 0;
+    for (auto const& object : m_objects) {
+        total += object.size;
+    }
+    return (total + PDO_SIZE - 1) / PDO_SIZE;
+}
+
+vector<PDOMapping> TPDOPlanner::plan() const {
+    auto objects = m_objects;
+    stable_sort(
+        objects.begin(), objects.end(),
+        [](PDOMapping::MappedObject const& a, PDOMapping::MappedObject const& b) {
+            return a.size > b.size;
+        }
+    );
+
+    vector<PDOMapping> mappings;
+    vector<int> free_bytes;
+    for (auto const& object : objects) {
+        size_t i = 0;
+        while (i < mappings.size() && free_bytes[i] < object.size) {
+            ++i;
+        }
+
+        if (i == mappings.size()) {
+            if (static_cast<int>(i) == m_max_pdo_count) {
+                throw TooManyPDOs(
+                    "the requested objects need more than " +
+                    to_string(m_max_pdo_count) + " PDOs"
+                );
+            }
+            mappings.push_back(PDOMapping());
+            free_bytes.push_back(PDO_SIZE);
+        }
+        mappings[i].add(object.objectId, object.subId, object.size);
+        free_bytes[i] -= object.size;
+    }
+    return mappings;
+}
@@ -0,0 +1,69 @@
+#ifndef MOTORS_ROBOTEQ_CANOPEN_TPDOPLANNER_HPP
+#define MOTORS_ROBOTEQ_CANOPEN_TPDOPLANNER_HPP
+
+#include <vector>
+
+#include <canopen_master/PDOMapping.hpp>
+
+namespace motors_roboteq_canopen {
+    /**
+     * Packs a set of objects into the minimum number of TPDOs
+     *
+     * Objects are collected with add(), regardless of which channel or which
+     * feature (joint state, status, encoders, analog inputs) requested them,
+     * and plan() assigns them to PDOs. Objects added more than once are
+     * mapped only once.
+     *
+     * The packing is first-fit decreasing. Since the size of all objects is
+     * a power of two that divides the PDO size, this reaches the lower bound
+     * of ceil(total_size / PDO_SIZE) PDOs.
+     */
+    class TPDOPlanner {
+    public:
+        /** Maximum payload of a PDO, in bytes */
+        static const int PDO_SIZE = 8;
+
+    private:
+        int m_max_pdo_count;
+        std::vector<canopen_master::PDOMapping::MappedObject> m_objects;
+
+    public:
+        /**
+         * @param max_pdo_count the number of PDOs the plan may use
+         */
+        explicit TPDOPlanner(int max_pdo_count);
+
+        /** Add an object to the plan
+         *
+         * @throw std::invalid_argument if the object's size is not 1, 2 or 4
+         */
+        void add(int object_id, int sub_id, int size);
+
+        /** Add all the objects of a mapping to the plan */
+        void add(canopen_master::PDOMapping const& mapping);
+
+        template<typename T>
+        void add(int objectOffset = 0, int subOffset = 0) {
+            add(T::OBJECT_ID + objectOffset, T::OBJECT_SUB_ID + subOffset,
+                sizeof(typename T::OBJECT_TYPE));
+        }
+
+        /** Return the number of distinct objects added so far */
+        size_t getObjectCount() const;
+
+        /** Return the number of PDOs plan() would generate */
+        int getFrameCount() const;
+
+        /** Compute the PDO mappings
+         *
+         * Within a PDO, objects are ordered by decreasing size, and then in
+         * the order they were added
+         *
+         * @throw TooManyPDOs if the objects do not fit in the maximum number
+         *   of PDOs given to the constructor
+         */
+        std::vector<canopen_master::PDOMapping> plan() const;
+    };
+}
+
+#endif
@@ -0,0 +1,265 @@
+#include <gtest/gtest.h>
+#include <motors_roboteq_canopen/Bus.hpp>
+#include <motors_roboteq_canopen/Driver.hpp>
+
+using namespace motors_roboteq_canopen;
+
+struct BusTest : public ::testing::Test {
+    Bus bus;
+    Driver& driver1;
+    Driver& driver3;
+
+    BusTest()
+        : driver1(bus.addDriver<Driver>(1, 1))
+        , driver3(bus.addDriver<Driver>(3, 1)) {}
+
+    void setupJointState(Driver& driver) {
+        driver.getChannel(0).setControlMode(CONTROL_POSITION);
+        std::vector<canbus::Message> messages;
+        driver.setupJointStateTPDOs(
+            messages, 0, canopen_master::PDOCommunicationParameters::Async()
+        );
+    }
+
+    void sendJointState(int node_id) {
+        canbus::Message pdo;
+        pdo.can_id = 0x180 + node_id;
+        pdo.size = 6;
+        for (int i = 0; i < 6; ++i) {
+            pdo.data[i] = 0;
+        }
+        bus.process(pdo);
+
+        pdo.can_id = 0x280 + node_id;
+        pdo.size = 4;
+        bus.process(pdo);
+    }
+};
+
+TEST_F(BusTest, it_numbers_the_channels_in_the_order_drivers_were_added)
+{
+    ASSERT_EQ(2, bus.getChannelCount());
+    ASSERT_EQ(0, bus.getChannelIndex(1, 0));
+    ASSERT_EQ(1, bus.getChannelIndex(3, 0));
+    ASSERT_EQ(&driver3, &bus.getDriverByNodeID(3));
+}
+
+TEST_F(BusTest, it_rejects_a_node_ID_that_is_already_in_use)
+{
+    ASSERT_THROW(bus.addDriver<Driver>(3, 1), std::invalid_argument);
+}
+
+TEST_F(BusTest, it_routes_messages_to_the_driver_of_the_sending_node)
+{
+    canbus::Message msg;
+    msg.can_id = 0x583;
+    msg.size = 8;
+    for (int i = 0; i < 8; ++i) {
+        msg.data[i] = 0;
+    }
+    ASSERT_EQ(&driver3, bus.process(msg));
+
+    msg.can_id = 0x581;
+    ASSERT_EQ(&driver1, bus.process(msg));
+
+    msg.can_id = 0x582;
+    ASSERT_EQ(nullptr, bus.process(msg));
+}
+
+TEST_F(BusTest, it_routes_COB_IDs_registered_explicitly)
+{
+    canbus::Message msg;
+    msg.can_id = 0x1F0;
+    msg.size = 0;
+    ASSERT_EQ(nullptr, bus.process(msg));
+    bus.setCOBIDNode(0x1F0, 3);
+    ASSERT_EQ(&driver3, bus.process(msg));
+}
+
+TEST_F(BusTest, it_routes_the_TPDOs_declared_by_the_setup_methods)
+{
+    driver3.setEncoderCounterEnableInTPDO(0, true);
+    std::vector<canbus::Message> messages;
+    driver3.setupEncoderTPDOs(
+        messages, 5, canopen_master::PDOCommunicationParameters::Async()
+    );
+
+    canbus::Message pdo;
+    pdo.can_id = 0x180 + 0x100 * 5 + 3;
+    pdo.size = 4;
+    pdo.data[0] = 0x2a;
+    pdo.data[1] = 0;
+    pdo.data[2] = 0;
+    pdo.data[3] = 0;
+    ASSERT_EQ(&driver3, bus.process(pdo));
+    ASSERT_EQ(42, driver3.getEncoderCounter(0));
+
+    pdo.can_id = 0x180 + 0x100 * 6 + 3;
+    ASSERT_EQ(nullptr, bus.process(pdo));
+}
+
+TEST_F(BusTest, it_routes_a_TPDO_declared_after_its_COB_ID_was_unroutable)
+{
+    canbus::Message pdo;
+    pdo.can_id = 0x180 + 0x100 * 5 + 3;
+    pdo.size = 4;
+    for (int i = 0; i < 4; ++i) {
+        pdo.data[i] = 0;
+    }
+    pdo.data[0] = 0x2a;
+    ASSERT_EQ(nullptr, bus.process(pdo));
+    ASSERT_EQ(nullptr, bus.process(pdo));
+
+    driver3.setEncoderCounterEnableInTPDO(0, true);
+    std::vector<canbus::Message> messages;
+    driver3.setupEncoderTPDOs(
+        messages, 5, canopen_master::PDOCommunicationParameters::Async()
+    );
+    ASSERT_EQ(&driver3, bus.process(pdo));
+    ASSERT_EQ(42, driver3.getEncoderCounter(0));
+}
+
+TEST_F(BusTest, it_reports_the_channels_whose_joint_state_is_complete)
+{
+    setupJointState(driver1);
+    setupJointState(driver3);
+
+    sendJointState(3);
+    ASSERT_EQ(0x2, bus.getReadyChannels());
+    ASSERT_FALSE(bus.areAllChannelsReady());
+
+    sendJointState(1);
+    ASSERT_EQ(0x3, bus.getReadyChannels());
+    ASSERT_TRUE(bus.areAllChannelsReady());
+
+    bus.resetJointStateTracking();
+    ASSERT_EQ(0, bus.getReadyChannels());
+    ASSERT_FALSE(driver1.getChannel(0).hasJointStateUpdate());
+}
+
+TEST_F(BusTest, it_reports_readiness_of_drivers_that_publish_in_a_queue)
+{
+    setupJointState(driver1);
+    setupJointState(driver3);
+    driver1.enableJointStateQueue(4);
+
+    sendJointState(1);
+    sendJointState(3);
+    ASSERT_TRUE(bus.areAllChannelsReady());
+
+    bus.resetJointStateTracking();
+    sendJointState(1);
+    sendJointState(3);
+    ASSERT_TRUE(bus.areAllChannelsReady());
+
+    JointStateSnapshot snapshot;
+    ASSERT_TRUE(driver1.popJointState(snapshot));
+    ASSERT_TRUE(driver1.popJointState(snapshot));
+    ASSERT_FALSE(driver1.popJointState(snapshot));
+}
+
+TEST_F(BusTest, it_keeps_channels_that_expect_no_updates_ready_after_a_reset)
+{
+    driver1.getChannel(0).setControlMode(CONTROL_IGNORED);
+    setupJointState(driver3);
+
+    sendJointState(3);
+    bus.resetJointStateTracking();
+    ASSERT_EQ(0x1, bus.getReadyChannels());
+
+    sendJointState(3);
+    ASSERT_TRUE(bus.areAllChannelsReady());
+}
+
+TEST_F(BusTest, it_gathers_the_RPDOs_of_all_drivers)
+{
+    std::vector<canbus::Message> messages;
+    for (auto driver : { &driver1, &driver3 }) {
+        driver->getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+        driver->setupJointCommandRPDOs(
+            messages, 0, canopen_master::PDOCommunicationParameters::Async()
+        );
+        base::samples::Joints command;
+        command.elements.resize(1);
+        command.elements[0].raw = 0;
+        driver->setJointCommand(command);
+    }
+
+    auto rpdos = bus.getRPDOMessages();
+    ASSERT_EQ(2, rpdos.size());
+    ASSERT_EQ(0x201, rpdos[0].can_id);
+    ASSERT_EQ(0x203, rpdos[1].can_id);
+}
+
+TEST_F(BusTest, it_converts_the_joint_states_of_the_selected_channels)
+{
+    Factors factors;
+    factors.speed_min = -2;
+    factors.speed_max = 3;
+    factors.torque_constant = 0.5;
+    driver1.getChannel(0).setFactors(factors);
+    driver1.getChannel(0).setControlMode(CONTROL_SPEED);
+    driver3.getChannel(0).setControlMode(CONTROL_POSITION);
+    for (Driver* driver : { &driver1, &driver3 }) {
+        driver->set<MotorAmps>(10, 0, 0);
+        driver->set<AppliedPowerLevel>(-200, 0, 0);
+        driver->set<Feedback>(500, 0, 0);
+    }
+
+    base::JointState states[2];
+    states[1].position = 42;
+    bus.readJointStates(states, 0x1);
+
+    auto expected = driver1.getChannel(0).getJointState();
+    ASSERT_FLOAT_EQ(expected.speed, states[0].speed);
+    ASSERT_FLOAT_EQ(expected.effort, states[0].effort);
+    ASSERT_FLOAT_EQ(expected.raw, states[0].raw);
+    ASSERT_EQ(42, states[1].position);
+
+    bus.readJointStates(states, 0x3);
+    expected = driver3.getChannel(0).getJointState();
+    ASSERT_FLOAT_EQ(expected.position, states[1].position);
+}
+
+TEST_F(BusTest, it_converts_the_joint_commands_of_all_drivers)
+{
+    Factors factors;
+    factors.speed_min = -2;
+    factors.speed_max = 3;
+    driver1.getChannel(0).setFactors(factors);
+    driver1.getChannel(0).setControlMode(CONTROL_SPEED);
+    driver3.getChannel(0).setControlMode(CONTROL_POSITION);
+
+    std::vector<base::samples::Joints> commands(2);
+    commands[0].elements.push_back(base::JointState::Speed(1.5));
+    commands[1].elements.push_back(base::JointState::Position(-0.25));
+    bus.setJointCommands(commands);
+    int32_t speed_command = driver1.get<SetCommand>(0, 0);
+    int32_t position_command = driver3.get<SetCommand>(0, 0);
+
+    driver1.setJointCommand(commands[0]);
+    driver3.setJointCommand(commands[1]);
+    ASSERT_EQ(driver1.get<SetCommand>(0, 0), speed_command);
+    ASSERT_EQ(driver3.get<SetCommand>(0, 0), position_command);
+    ASSERT_EQ(1.5, driver1.getChannel(0).getJointCommand().speed);
+}
+
+TEST_F(BusTest, it_rejects_joint_commands_that_do_not_match_the_drivers)
+{
+    driver1.getChannel(0).setControlMode(CONTROL_SPEED);
+    driver3.getChannel(0).setControlMode(CONTROL_SPEED);
+
+    std::vector<base::samples::Joints> commands(1);
+    ASSERT_THROW(bus.setJointCommands(commands), std::invalid_argument);
+
+    commands.resize(2);
+    commands[0].elements.push_back(base::JointState::Speed(0.5));
+    ASSERT_THROW(bus.setJointCommands(commands), std::invalid_argument);
+
+    commands[1].elements.resize(2, base::JointState::Speed(0.5));
+    ASSERT_THROW(bus.setJointCommands(commands), std::invalid_argument);
+
+    commands[1].elements.resize(1);
+    commands[1].elements[0] = base::JointState::Position(0.5);
+    ASSERT_THROW(bus.setJointCommands(commands), InvalidJointCommand);
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <motors_roboteq_canopen/BusExecutor.hpp>
+#include <motors_roboteq_canopen/Driver.hpp>
+
+using namespace motors_roboteq_canopen;
+
+struct QueueBusIO : public BusIO {
+    std::mutex mutex;
+    std::deque<canbus::Message> received;
+    std::vector<canbus::Message> sent;
+    std::atomic<bool> fail_reads;
+    std::atomic<bool> fail_writes;
+
+    QueueBusIO()
+        : fail_reads(false)
+        , fail_writes(false) {}
+
+    bool read(canbus::Message& message) {
+        if (fail_reads) {
+            throw std::runtime_error("read failed");
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!received.empty()) {
+                message = received.front();
+                received.pop_front();
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        return false;
+    }
+
+    void write(canbus::Message const& message) {
+        if (fail_writes) {
+            throw std::runtime_error("write failed");
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        sent.push_back(message);
+    }
+
+    void receive(canbus::Message const& message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(message);
+    }
+
+    size_t sentCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sent.size();
+    }
+};
+
+struct BusExecutorTest : public ::testing::Test {
+    BusExecutor executor;
+    QueueBusIO io;
+    Driver* driver;
+
+    BusExecutorTest() {
+        Bus& bus = executor.addBus(io, 0);
+        driver = &bus.addDriver<Driver>(1, 1);
+        driver->getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+
+        std::vector<canbus::Message> messages;
+        auto parameters = canopen_master::PDOCommunicationParameters::Async();
+        driver->setupJointStateTPDOs(messages, 0, parameters);
+        driver->setupJointCommandRPDOs(messages, 0, parameters);
+    }
+
+    ~BusExecutorTest() {
+        executor.stop();
+    }
+
+    template<typename Predicate>
+    bool waitFor(Predicate predicate) {
+        for (int i = 0; i < 1000; ++i) {
+            if (predicate()) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+};
+
+TEST_F(BusExecutorTest, it_publishes_the_joint_states_once_all_channels_are_complete)
+{
+    executor.start();
+
+    canbus::Message pdo;
+    pdo.can_id = 0x181;
+    pdo.size = 6;
+    for (int i = 0; i < 6; ++i) {
+        pdo.data[i] = 0;
+    }
+    pdo.data[2] = 100;
+    pdo.time = base::Time::fromMicroseconds(1234);
+    io.receive(pdo);
+
+    BusSnapshot snapshot;
+    ASSERT_TRUE(waitFor([&]() { return executor.readBusSnapshot(0, snapshot) != 0; }));
+    ASSERT_EQ(1, snapshot.channel_count);
+    ASSERT_FLOAT_EQ(0.1, snapshot.joint_states[0].raw);
+    ASSERT_EQ(base::Time::fromMicroseconds(1234), snapshot.time);
+
+    auto joints = executor.readJointStates();
+    ASSERT_EQ(1, joints.elements.size());
+    ASSERT_EQ(snapshot.time, joints.time);
+}
+
+TEST_F(BusExecutorTest, it_sends_the_RPDOs_of_submitted_commands)
+{
+    executor.start();
+
+    base::samples::Joints command;
+    command.elements.resize(1);
+    command.elements[0].raw = 0.5;
+    executor.submitJointCommands(0, { command });
+
+    ASSERT_TRUE(waitFor([&]() { return io.sentCount() == 1; }));
+    executor.stop();
+    ASSERT_EQ(0x201, io.sent[0].can_id);
+}
+
+TEST_F(BusExecutorTest, it_rejects_commands_that_do_not_match_the_drivers)
+{
+    executor.start();
+
+    base::samples::Joints command;
+    command.elements.resize(2);
+    ASSERT_THROW(executor.submitJointCommands(0, {}), std::invalid_argument);
+    ASSERT_THROW(executor.submitJointCommands(0, { command }),
+                 std::invalid_argument);
+    ASSERT_TRUE(executor.isRunning());
+}
+
+TEST_F(BusExecutorTest, it_keeps_running_when_a_command_cannot_be_sent)
+{
+    executor.start();
+
+    base::samples::Joints command;
+    command.elements.resize(1);
+    command.elements[0].raw = 0.5;
+    io.fail_writes = true;
+    executor.submitJointCommands(0, { command });
+    ASSERT_TRUE(waitFor([&]() {
+        return executor.getRejectedCommandCount(0) == 1;
+    }));
+    ASSERT_EQ("write failed", executor.getLastCommandError(0));
+    ASSERT_TRUE(executor.isRunning());
+
+    io.fail_writes = false;
+    command.elements[0].raw = 0.25;
+    executor.submitJointCommands(0, { command });
+    ASSERT_TRUE(waitFor([&]() { return io.sentCount() == 1; }));
+}
+
+TEST_F(BusExecutorTest, it_rethrows_errors_of_the_bus_threads_on_stop)
+{
+    executor.start();
+    ASSERT_TRUE(executor.isRunning());
+    io.fail_reads = true;
+    ASSERT_TRUE(waitFor([&]() { return !executor.isRunning(); }));
+    ASSERT_FALSE(executor.isBusRunning(0));
+    ASSERT_THROW(executor.stop(), std::runtime_error);
+}
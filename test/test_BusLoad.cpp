@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <motors_roboteq_canopen/Bus.hpp>
+#include <motors_roboteq_canopen/BusLoad.hpp>
+#include <motors_roboteq_canopen/Driver.hpp>
+
+using namespace motors_roboteq_canopen;
+using canopen_master::PDOCommunicationParameters;
+
+struct BusLoadTest : public ::testing::Test {
+    BusLoadModel model;
+
+    BusLoadTest() {
+        model.bitrate = 500000;
+        model.sync_period = base::Time::fromMilliseconds(10);
+    }
+};
+
+TEST_F(BusLoadTest, it_computes_the_worst_case_frame_length)
+{
+    ASSERT_EQ(55, getWorstCaseFrameBits(0));
+    ASSERT_EQ(135, getWorstCaseFrameBits(8));
+}
+
+TEST_F(BusLoadTest, it_computes_the_rate_of_synchronous_and_asynchronous_TPDOs)
+{
+    ASSERT_DOUBLE_EQ(50, model.getTPDOFrequency(PDOCommunicationParameters::Sync(2)));
+    ASSERT_DOUBLE_EQ(100, model.getTPDOFrequency(PDOCommunicationParameters::Sync(0)));
+    ASSERT_DOUBLE_EQ(
+        200, model.getTPDOFrequency(
+            PDOCommunicationParameters::Async(base::Time::fromMilliseconds(5))
+        )
+    );
+    ASSERT_THROW(
+        model.getTPDOFrequency(PDOCommunicationParameters::Async()),
+        std::invalid_argument
+    );
+}
+
+TEST_F(BusLoadTest, it_reports_the_utilization_per_node_and_in_total)
+{
+    BusLoad load(model);
+    load.addSYNC();
+    load.addTPDO(1, 8, PDOCommunicationParameters::Sync(1));
+    load.addRPDO(2, 4);
+
+    ASSERT_DOUBLE_EQ(5500, load.getNodeBitRate(0));
+    ASSERT_DOUBLE_EQ(13500, load.getNodeBitRate(1));
+    ASSERT_DOUBLE_EQ(9500, load.getNodeBitRate(2));
+    ASSERT_DOUBLE_EQ(0.027, load.getNodeUtilization(1));
+    ASSERT_DOUBLE_EQ(0.057, load.getUtilization());
+    ASSERT_NO_THROW(load.checkBudget(0.06));
+    ASSERT_THROW(load.checkBudget(0.05), BusOverload);
+}
+
+TEST_F(BusLoadTest, it_computes_the_load_of_the_PDOs_configured_on_a_bus)
+{
+    Bus bus;
+    Driver& driver = bus.addDriver<Driver>(1, 1);
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    std::vector<canbus::Message> messages;
+    driver.setupJointStateTPDOs(messages, 0, PDOCommunicationParameters::Sync(1));
+    driver.setupJointCommandRPDOs(messages, 0, PDOCommunicationParameters::Sync(1));
+
+    BusLoad load = bus.computeBusLoad(model);
+    ASSERT_DOUBLE_EQ(
+        100 * (getWorstCaseFrameBits(6) + getWorstCaseFrameBits(4)),
+        load.getNodeBitRate(1)
+    );
+    ASSERT_DOUBLE_EQ(
+        100 * getWorstCaseFrameBits(0) + load.getNodeBitRate(1),
+        load.getBitRate()
+    );
+}
+
+TEST_F(BusLoadTest, it_refuses_a_PDO_setup_that_exceeds_the_node_budget)
+{
+    Bus bus;
+    Driver& driver = bus.addDriver<Driver>(1, 1);
+    driver.getChannel(0).setControlMode(CONTROL_POSITION);
+    driver.setBusLoadBudget(model, 0.03);
+
+    std::vector<canbus::Message> messages;
+    ASSERT_THROW(
+        driver.setupJointStateTPDOs(messages, 0, PDOCommunicationParameters::Sync(1)),
+        BusOverload
+    );
+    ASSERT_EQ(1, driver.getConfiguredPDOs().size());
+
+    driver.clearBusLoadBudget();
+    messages.clear();
+    driver.setupJointStateTPDOs(messages, 0, PDOCommunicationParameters::Sync(1));
+    ASSERT_EQ(2, driver.getConfiguredPDOs().size());
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <motors_roboteq_canopen/Driver.hpp>
 #include <motors_roboteq_canopen/Channel.hpp>
+#include <motors_roboteq_canopen/FactorsTable.hpp>
 
 using namespace motors_roboteq_canopen;
 using canopen_master::PDOMapping;
@@ -260,4 +261,86 @@ TEST_F(ChannelTest, it_does_not_report_a_full_joint_state_after_reset) {
 
     channel.resetJointStateTracking();
     ASSERT_FALSE(channel.hasJointStateUpdate());
-}
\ No newline at end of file
+}
+
+TEST_F(ChannelTest, it_converts_the_command_field_matching_the_current_control_mode) {
+    channel.setControlMode(CONTROL_OPEN_LOOP);
+    base::JointState cmd;
+    cmd.raw = 0.5;
+    cmd.speed = -1;
+    channel.setJointCommand(cmd);
+    ASSERT_EQ(500, driver.get<SetCommand>(0, 1));
+
+    channel.setControlMode(CONTROL_SPEED);
+    channel.setJointCommand(cmd);
+    ASSERT_EQ(-1000, driver.get<SetCommand>(0, 1));
+
+    channel.setControlMode(CONTROL_POSITION);
+    ASSERT_THROW(channel.setJointCommand(cmd), InvalidJointCommand);
+}
+
+TEST_F(ChannelTest, it_fills_the_speed_from_the_feedback_in_speed_control_mode) {
+    channel.setControlMode(CONTROL_SPEED);
+    driver.set<MotorAmps>(10, 0, 1);
+    driver.set<AppliedPowerLevel>(20, 0, 1);
+    driver.set<Feedback>(500, 0, 1);
+
+    auto joint = channel.getJointState();
+    ASSERT_FLOAT_EQ(0.5, joint.speed);
+    ASSERT_TRUE(base::isUnknown(joint.position));
+
+    channel.setJointStatePositionSource(JOINT_STATE_POSITION_SOURCE_ENCODER);
+    driver.set<EncoderCounter>(10, 0, 1);
+    joint = channel.getJointState();
+    ASSERT_FLOAT_EQ(0.5, joint.speed);
+    ASSERT_FLOAT_EQ(10, joint.position);
+}
+
+TEST_F(ChannelTest, it_reports_the_raw_objects_its_joint_state_is_computed_from) {
+    channel.setControlMode(CONTROL_SPEED);
+    channel.setJointStatePositionSource(JOINT_STATE_POSITION_SOURCE_ENCODER);
+    Factors factors;
+    factors.encoder_position_factor = 0.25;
+    channel.setFactors(factors);
+    driver.set<MotorAmps>(10, 0, 1);
+    driver.set<AppliedPowerLevel>(20, 0, 1);
+    driver.set<Feedback>(500, 0, 1);
+    driver.set<EncoderCounter>(10, 0, 1);
+
+    auto raw = channel.getRawJointState();
+    ASSERT_TRUE(raw.valid);
+    ASSERT_EQ(10, raw.current);
+    ASSERT_EQ(20, raw.power_level);
+    ASSERT_EQ(RawJointState::UNIT_ENCODER, raw.position_unit);
+    ASSERT_EQ(10, raw.position);
+    ASSERT_EQ(RawJointState::UNIT_RELATIVE, raw.speed_unit);
+    ASSERT_EQ(500, raw.speed);
+
+    FactorsTable table(std::vector<Factors> { factors });
+    base::JointState joint;
+    table.toJointStates(&raw, &joint);
+    auto expected = channel.getJointState();
+    ASSERT_EQ(expected.position, joint.position);
+    ASSERT_EQ(expected.speed, joint.speed);
+    ASSERT_EQ(expected.effort, joint.effort);
+    ASSERT_EQ(expected.raw, joint.raw);
+
+    channel.setControlMode(CONTROL_IGNORED);
+    ASSERT_FALSE(channel.getRawJointState().valid);
+}
+
+TEST_F(ChannelTest, it_sets_a_command_converted_beforehand) {
+    channel.setControlMode(CONTROL_NONE);
+    ASSERT_EQ(JOINT_COMMAND_CONVERSION_NONE, channel.getJointCommandConversion());
+    ASSERT_THROW(channel.setConvertedJointCommand(base::JointState::Speed(1), 10),
+                 std::logic_error);
+
+    channel.setControlMode(CONTROL_SPEED);
+    ASSERT_EQ(JOINT_COMMAND_CONVERSION_RELATIVE_SPEED,
+              channel.getJointCommandConversion());
+    channel.setConvertedJointCommand(base::JointState::Speed(1), 10);
+    ASSERT_EQ(10, driver.get<SetCommand>(0, 1));
+    ASSERT_EQ(1, channel.getJointCommand().speed);
+    ASSERT_THROW(channel.setConvertedJointCommand(base::JointState::Position(1), 20),
+                 InvalidJointCommand);
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <motors_roboteq_canopen/CommandCoalescer.hpp>
+#include <motors_roboteq_canopen/Driver.hpp>
+
+using namespace motors_roboteq_canopen;
+
+static base::samples::Joints makeCommand(double raw0, double raw1) {
+    base::samples::Joints command;
+    command.elements.resize(2);
+    command.elements[0].raw = raw0;
+    command.elements[1].raw = raw1;
+    return command;
+}
+
+TEST(CommandCoalescerTest, it_returns_false_if_no_sample_has_been_pushed)
+{
+    CommandCoalescer coalescer;
+    base::samples::Joints command;
+    ASSERT_FALSE(coalescer.take(command));
+}
+
+TEST(CommandCoalescerTest, it_keeps_the_latest_sample_by_default)
+{
+    CommandCoalescer coalescer;
+    coalescer.push(makeCommand(0.1, 0.2));
+    coalescer.push(makeCommand(0.3, -0.4));
+    ASSERT_EQ(2, coalescer.getPendingSampleCount());
+
+    base::samples::Joints command;
+    ASSERT_TRUE(coalescer.take(command));
+    ASSERT_DOUBLE_EQ(0.3, command.elements[0].raw);
+    ASSERT_DOUBLE_EQ(-0.4, command.elements[1].raw);
+    ASSERT_EQ(0, coalescer.getPendingSampleCount());
+    ASSERT_FALSE(coalescer.take(command));
+}
+
+TEST(CommandCoalescerTest, it_averages_the_fields_that_are_set)
+{
+    CommandCoalescer coalescer(COALESCE_MEAN);
+    coalescer.push(makeCommand(0.1, 0.2));
+    coalescer.push(makeCommand(0.3, base::unknown<double>()));
+    coalescer.push(makeCommand(0.5, 0.4));
+
+    base::samples::Joints command;
+    ASSERT_TRUE(coalescer.take(command));
+    ASSERT_DOUBLE_EQ(0.3, command.elements[0].raw);
+    ASSERT_DOUBLE_EQ(0.3, command.elements[1].raw);
+    ASSERT_TRUE(base::isUnknown(command.elements[0].position));
+}
+
+TEST(CommandCoalescerTest, it_keeps_the_values_of_largest_magnitude)
+{
+    CommandCoalescer coalescer(COALESCE_MAX_MAGNITUDE);
+    coalescer.push(makeCommand(0.1, 0.2));
+    coalescer.push(makeCommand(-0.5, 0.1));
+    coalescer.push(makeCommand(0.3, -0.1));
+
+    base::samples::Joints command;
+    ASSERT_TRUE(coalescer.take(command));
+    ASSERT_DOUBLE_EQ(-0.5, command.elements[0].raw);
+    ASSERT_DOUBLE_EQ(0.2, command.elements[1].raw);
+}
+
+TEST(CommandCoalescerTest, it_rejects_samples_of_different_sizes_within_a_cycle)
+{
+    CommandCoalescer coalescer;
+    coalescer.push(makeCommand(0.1, 0.2));
+    base::samples::Joints command;
+    command.elements.resize(1);
+    ASSERT_THROW(coalescer.push(command), std::invalid_argument);
+}
+
+TEST(CommandCoalescerTest, it_applies_the_pending_command_to_a_driver)
+{
+    canopen_master::StateMachine canopen(1);
+    Driver driver(canopen, 2);
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+
+    CommandCoalescer coalescer;
+    ASSERT_FALSE(coalescer.apply(driver));
+    coalescer.push(makeCommand(0.1, 0.2));
+    coalescer.push(makeCommand(0.3, 0.4));
+    ASSERT_TRUE(coalescer.apply(driver));
+
+    ASSERT_EQ(300, driver.get<SetCommand>(0, 0));
+    ASSERT_EQ(400, driver.get<SetCommand>(0, 1));
+}
@@ -2,6 +2,7 @@
 #include "Helpers.hpp"
 #include <motors_roboteq_canopen/DS402Driver.hpp>
 #include <motors_roboteq_canopen/DS402Channel.hpp>
+#include <motors_roboteq_canopen/FactorsTable.hpp>
 
 using namespace std;
 using namespace base;
@@ -89,6 +90,44 @@ TEST_F(ChannelTestBase, it_returns_a_unknown_joint_state) {
     ASSERT_TRUE(base::isUnknown(state.raw));
 }
 
+TEST_F(ChannelTestBase, it_reports_the_raw_objects_its_joint_state_is_computed_from) {
+    can_open.set<int16_t>(0x2100, 2, 12);
+    can_open.set<int16_t>(0x2102, 2, 400);
+    can_open.set<int16_t>(0x6844, 0, 5);
+    can_open.set<int32_t>(0x686C, 0, -70);
+    can_open.set<int32_t>(0x6864, 0, 300);
+    FactorsTable table(std::vector<Factors> { channel.getFactors() });
+
+    DS402OperationModes modes[] = {
+        DS402_OPERATION_MODE_VELOCITY_PROFILE,
+        DS402_OPERATION_MODE_VELOCITY,
+        DS402_OPERATION_MODE_ANALOG_VELOCITY,
+        DS402_OPERATION_MODE_ANALOG_POSITION,
+        DS402_OPERATION_MODE_RELATIVE_POSITION,
+        DS402_OPERATION_MODE_TORQUE_PROFILE
+    };
+    for (auto mode : modes) {
+        channel.setOperationMode(mode);
+        auto raw = channel.getRawJointState();
+        ASSERT_TRUE(raw.valid);
+
+        JointState joint;
+        table.toJointStates(&raw, &joint);
+        auto expected = channel.getJointState();
+        ASSERT_EQ(expected.effort, joint.effort);
+        ASSERT_EQ(expected.raw, joint.raw);
+        ASSERT_EQ(base::isUnknown(expected.speed), base::isUnknown(joint.speed));
+        if (!base::isUnknown(expected.speed)) {
+            ASSERT_FLOAT_EQ(expected.speed, joint.speed);
+        }
+        ASSERT_EQ(base::isUnknown(expected.position), base::isUnknown(joint.position));
+        if (!base::isUnknown(expected.position)) {
+            ASSERT_FLOAT_EQ(expected.position, joint.position);
+        }
+    }
+    ASSERT_EQ(JOINT_COMMAND_CONVERSION_NONE, channel.getJointCommandConversion());
+}
+
 struct DirectVelocityModes : public ChannelTestBase,
                              public testing::WithParamInterface<DS402OperationModes> {
     DirectVelocityModes() {
@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <cstring>
+#include <canopen_master/SDO.hpp>
 #include <motors_roboteq_canopen/Driver.hpp>
 
 using namespace motors_roboteq_canopen;
@@ -30,3 +32,769 @@ TEST_F(DriverTest, it_sets_digital_output_reading_time)
         ASSERT_GE(r.time, now);
     }
 }
+
+struct DriverProcessTest : public ::testing::Test {
+    static const int NODE_ID = 2;
+
+    canopen_master::StateMachine canopen;
+    Driver driver;
+
+    DriverProcessTest()
+        : canopen(NODE_ID)
+        , driver(canopen, 2) {}
+
+    canbus::Message make_sdo_ack(int object_id, int sub_id) {
+        canbus::Message msg;
+        msg.can_id = NODE_ID | canopen_master::FUNCTION_SDO_TRANSMIT;
+        msg.size = 8;
+        msg.data[0] = (canopen_master::SDO_INITIATE_DOMAIN_DOWNLOAD_REPLY << 5) | 2;
+        msg.data[1] = object_id & 0xFF;
+        msg.data[2] = (object_id >> 8) & 0xFF;
+        msg.data[3] = sub_id;
+        return msg;
+    }
+};
+
+TEST_F(DriverProcessTest, it_dispatches_updates_to_the_channel_owning_the_object)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+
+    driver.process(make_sdo_ack(0x2100, 2));
+    driver.process(make_sdo_ack(0x2102, 2));
+    ASSERT_FALSE(driver.getChannel(0).hasJointStateUpdate());
+    ASSERT_TRUE(driver.getChannel(1).hasJointStateUpdate());
+}
+
+TEST_F(DriverProcessTest, it_tracks_encoder_updates_both_at_channel_and_driver_level)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(0).setJointStatePositionSource(
+        JOINT_STATE_POSITION_SOURCE_ENCODER
+    );
+    driver.setEncoderCounterEnableInTPDO(0, true);
+
+    driver.process(make_sdo_ack(0x2100, 1));
+    driver.process(make_sdo_ack(0x2102, 1));
+    ASSERT_FALSE(driver.getChannel(0).hasJointStateUpdate());
+    ASSERT_FALSE(driver.hasEncoderCounterUpdate());
+
+    driver.process(make_sdo_ack(0x2104, 1));
+    ASSERT_TRUE(driver.getChannel(0).hasJointStateUpdate());
+    ASSERT_TRUE(driver.hasEncoderCounterUpdate());
+}
+
+TEST_F(DriverProcessTest, it_tracks_analog_input_updates)
+{
+    driver.setAnalogInputEnableInTPDO(0, true);
+    driver.setConvertedAnalogInputEnableInTPDO(2, true);
+
+    driver.process(make_sdo_ack(0x2146, 1));
+    ASSERT_TRUE(driver.hasAnalogInputUpdate());
+    ASSERT_FALSE(driver.hasConvertedAnalogInputUpdate());
+
+    driver.process(make_sdo_ack(0x2147, 3));
+    ASSERT_TRUE(driver.hasConvertedAnalogInputUpdate());
+}
+
+TEST_F(DriverProcessTest, it_reports_the_groups_completed_by_a_batch)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+    driver.setEncoderCounterEnableInTPDO(1, true);
+
+    std::vector<canbus::Message> messages {
+        make_sdo_ack(0x2100, 1),
+        make_sdo_ack(0x2100, 2),
+        make_sdo_ack(0x2102, 2),
+        make_sdo_ack(0x2104, 2)
+    };
+    auto result = driver.processMessages(messages);
+    ASSERT_EQ(4, result.message_count);
+    ASSERT_EQ(0x2, result.joint_states);
+    ASSERT_TRUE(result.encoder_counters);
+    ASSERT_FALSE(result.analog_inputs);
+}
+
+TEST_F(DriverProcessTest, it_does_not_report_groups_that_were_already_complete)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+    driver.process(make_sdo_ack(0x2100, 2));
+    driver.process(make_sdo_ack(0x2102, 2));
+
+    std::vector<canbus::Message> messages {
+        make_sdo_ack(0x2100, 1),
+        make_sdo_ack(0x2102, 1),
+        make_sdo_ack(0x2102, 2)
+    };
+    auto result = driver.processMessages(messages);
+    ASSERT_EQ(0x1, result.joint_states);
+}
+
+TEST_F(DriverProcessTest, it_decodes_the_joint_state_TPDOs_it_declared)
+{
+    driver.getChannel(0).setControlMode(CONTROL_IGNORED);
+    driver.getChannel(1).setControlMode(CONTROL_POSITION);
+
+    std::vector<canbus::Message> messages;
+    driver.setupJointStateTPDOs(
+        messages, 0, canopen_master::PDOCommunicationParameters::Async()
+    );
+
+    canbus::Message pdo;
+    pdo.can_id = 0x180 + NODE_ID;
+    pdo.size = 6;
+    pdo.data[0] = 0x10;
+    pdo.data[2] = 0x20;
+    pdo.data[4] = 0x01;
+    pdo.data[5] = 0x02;
+    driver.process(pdo);
+    ASSERT_FALSE(driver.getChannel(1).hasJointStateUpdate());
+
+    pdo.can_id = 0x280 + NODE_ID;
+    pdo.size = 4;
+    pdo.data[0] = 0x2a;
+    pdo.data[1] = 0;
+    pdo.data[2] = 0;
+    pdo.data[3] = 0;
+    driver.process(pdo);
+    ASSERT_TRUE(driver.getChannel(1).hasJointStateUpdate());
+
+    ASSERT_EQ(0x10, driver.get<MotorAmps>(0, 1));
+    ASSERT_EQ(0x20, driver.get<AppliedPowerLevel>(0, 1));
+    ASSERT_EQ(0x201, driver.get<ChannelStatusFlagsRaw>(0, 1));
+    ASSERT_EQ(42, driver.get<Feedback>(0, 1));
+}
+
+struct RecordingListener : public DriverListener, public JointStateListener {
+    std::vector<int> channels;
+    std::vector<base::JointState> states;
+    int encoder_completions = 0;
+    int channel_completions = 0;
+
+    void jointStateCompleted(
+        DriverBase&, int channel, base::JointState const& state
+    ) override {
+        channels.push_back(channel);
+        states.push_back(state);
+    }
+
+    void jointStateCompleted(ChannelBase&, base::JointState const&) override {
+        channel_completions++;
+    }
+
+    void encoderCountersCompleted(DriverBase&) override {
+        encoder_completions++;
+    }
+};
+
+TEST_F(DriverProcessTest, it_notifies_listeners_when_a_joint_state_is_completed)
+{
+    RecordingListener listener;
+    driver.setListener(&listener);
+    driver.getChannel(1).setJointStateListener(&listener);
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+    driver.set<MotorAmps>(10, 0, 1);
+    driver.set<AppliedPowerLevel>(20, 0, 1);
+
+    driver.process(make_sdo_ack(0x2100, 2));
+    ASSERT_TRUE(listener.channels.empty());
+    driver.process(make_sdo_ack(0x2102, 2));
+    driver.process(make_sdo_ack(0x2102, 2));
+
+    ASSERT_EQ(std::vector<int>{1}, listener.channels);
+    ASSERT_FLOAT_EQ(0.02, listener.states[0].raw);
+    ASSERT_EQ(1, listener.channel_completions);
+}
+
+TEST_F(DriverProcessTest, it_notifies_listeners_when_the_encoders_are_completed)
+{
+    RecordingListener listener;
+    driver.setListener(&listener);
+    driver.setEncoderCounterEnableInTPDO(0, true);
+    driver.setEncoderCounterEnableInTPDO(1, true);
+
+    driver.process(make_sdo_ack(0x2104, 1));
+    ASSERT_EQ(0, listener.encoder_completions);
+    driver.process(make_sdo_ack(0x2104, 2));
+    ASSERT_EQ(1, listener.encoder_completions);
+
+    driver.resetEncoderCounterTracking();
+    driver.process(make_sdo_ack(0x2104, 1));
+    driver.process(make_sdo_ack(0x2104, 2));
+    ASSERT_EQ(2, listener.encoder_completions);
+}
+
+TEST_F(DriverProcessTest, it_publishes_completed_joint_states_in_the_queue)
+{
+    driver.enableJointStateQueue(4);
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+    driver.set<MotorAmps>(10, 0, 0);
+    driver.set<AppliedPowerLevel>(20, 0, 0);
+
+    auto msg = make_sdo_ack(0x2100, 1);
+    msg.time = base::Time::fromMicroseconds(10);
+    driver.process(msg);
+    msg = make_sdo_ack(0x2102, 1);
+    msg.time = base::Time::fromMicroseconds(20);
+    driver.process(msg);
+
+    JointStateSnapshot snapshot;
+    ASSERT_TRUE(driver.popJointState(snapshot));
+    ASSERT_EQ(0, snapshot.channel);
+    ASSERT_EQ(base::Time::fromMicroseconds(20), snapshot.time);
+    ASSERT_FLOAT_EQ(0.02, snapshot.state.raw);
+    ASSERT_FALSE(driver.popJointState(snapshot));
+}
+
+TEST_F(DriverProcessTest, it_publishes_each_completion_of_the_same_channel)
+{
+    driver.enableJointStateQueue(4);
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+    driver.set<MotorAmps>(10, 0, 0);
+    driver.set<AppliedPowerLevel>(20, 0, 0);
+
+    for (int i = 0; i < 2; ++i) {
+        auto msg = make_sdo_ack(0x2100, 1);
+        msg.time = base::Time::fromMicroseconds(10 + 20 * i);
+        driver.process(msg);
+        msg = make_sdo_ack(0x2102, 1);
+        msg.time = base::Time::fromMicroseconds(20 + 20 * i);
+        driver.process(msg);
+    }
+
+    JointStateSnapshot snapshot;
+    ASSERT_TRUE(driver.popJointState(snapshot));
+    ASSERT_EQ(base::Time::fromMicroseconds(20), snapshot.time);
+    ASSERT_TRUE(driver.popJointState(snapshot));
+    ASSERT_EQ(0, snapshot.channel);
+    ASSERT_EQ(base::Time::fromMicroseconds(40), snapshot.time);
+    ASSERT_FALSE(driver.popJointState(snapshot));
+}
+
+TEST_F(DriverProcessTest, it_keeps_the_joint_state_tracking_when_the_queue_is_enabled)
+{
+    driver.enableJointStateQueue(4);
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+    driver.set<MotorAmps>(10, 0, 0);
+    driver.set<AppliedPowerLevel>(20, 0, 0);
+
+    std::vector<canbus::Message> messages {
+        make_sdo_ack(0x2100, 1),
+        make_sdo_ack(0x2102, 1)
+    };
+    auto result = driver.processMessages(messages);
+    ASSERT_EQ(0x1, result.joint_states);
+    ASSERT_TRUE(driver.getChannel(0).hasJointStateUpdate());
+
+    JointStateSnapshot snapshot;
+    ASSERT_TRUE(driver.popJointState(snapshot));
+    ASSERT_EQ(0, snapshot.channel);
+    ASSERT_FALSE(driver.popJointState(snapshot));
+}
+
+TEST_F(DriverProcessTest, it_publishes_a_state_snapshot)
+{
+    driver.enableStateSnapshot();
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+    driver.set<MotorAmps>(10, 0, 1);
+    driver.set<AppliedPowerLevel>(20, 0, 1);
+    driver.set<VoltageBattery>(245);
+    driver.set<ChannelStatusFlagsRaw>(0x4, 0, 1);
+
+    DriverStateSnapshot snapshot;
+    ASSERT_EQ(0, driver.readStateSnapshot(snapshot));
+
+    driver.process(make_sdo_ack(0x2100, 2));
+    driver.process(make_sdo_ack(0x2102, 2));
+    driver.process(make_sdo_ack(0x210D, 2));
+    driver.process(make_sdo_ack(0x2122, 2));
+
+    ASSERT_LT(0, driver.readStateSnapshot(snapshot));
+    ASSERT_EQ(2, snapshot.channel_count);
+    ASSERT_FLOAT_EQ(0.02, snapshot.joint_states[1].raw);
+    ASSERT_TRUE(base::isUnknown(snapshot.joint_states[0].raw));
+    ASSERT_FLOAT_EQ(24.5, snapshot.voltage_battery);
+    ASSERT_EQ(0x4, snapshot.channel_status_flags[1]);
+}
+
+TEST_F(DriverProcessTest, it_reports_the_reception_time_of_the_joint_state_fields)
+{
+    driver.getChannel(1).setControlMode(CONTROL_POSITION);
+
+    driver.process(make_sdo_ack(0x2102, 2), base::Time::fromMicroseconds(20));
+    driver.process(make_sdo_ack(0x2100, 2), base::Time::fromMicroseconds(10));
+    driver.process(make_sdo_ack(0x2104, 2), base::Time::fromMicroseconds(40));
+    driver.process(make_sdo_ack(0x2110, 2), base::Time::fromMicroseconds(30));
+
+    auto timestamps = driver.getChannel(1).getJointStateTimestamps();
+    ASSERT_EQ(base::Time::fromMicroseconds(10), timestamps.oldest);
+    ASSERT_EQ(base::Time::fromMicroseconds(30), timestamps.newest);
+}
+
+TEST_F(DriverProcessTest, it_patches_the_pre_encoded_RPDOs_when_the_command_is_set)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+
+    std::vector<canbus::Message> messages;
+    driver.setupJointCommandRPDOs(
+        messages, 0, canopen_master::PDOCommunicationParameters::Async()
+    );
+    ASSERT_EQ(2, driver.getRPDOCount());
+
+    base::samples::Joints command;
+    command.elements.resize(2);
+    command.elements[0].raw = 0.5;
+    command.elements[1].raw = -0.2;
+    driver.setJointCommand(command);
+
+    canbus::Message buffer[2];
+    ASSERT_EQ(2, driver.getRPDOMessages(buffer, 2));
+    for (int i = 0; i < 2; ++i) {
+        canbus::Message expected = canopen.getRPDOMessage(i);
+        ASSERT_EQ(expected.can_id, buffer[i].can_id);
+        ASSERT_EQ(expected.size, buffer[i].size);
+        for (int j = 0; j < expected.size; ++j) {
+            ASSERT_EQ(expected.data[j], buffer[i].data[j]);
+        }
+    }
+    ASSERT_EQ(0x200 + NODE_ID, buffer[0].can_id);
+    ASSERT_EQ(500, buffer[0].data[0] | buffer[0].data[1] << 8);
+}
+
+TEST_F(DriverProcessTest, it_initializes_the_RPDOs_with_the_command_already_set)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_IGNORED);
+
+    base::samples::Joints command;
+    command.elements.resize(1);
+    command.elements[0].raw = 0.1;
+    driver.setJointCommand(command);
+
+    std::vector<canbus::Message> messages;
+    driver.setupJointCommandRPDOs(
+        messages, 0, canopen_master::PDOCommunicationParameters::Async()
+    );
+
+    canbus::Message buffer[1];
+    ASSERT_EQ(1, driver.getRPDOMessages(buffer, 1));
+    ASSERT_EQ(100, buffer[0].data[0] | buffer[0].data[1] << 8);
+}
+
+TEST_F(DriverProcessTest, it_refuses_to_write_the_RPDOs_in_a_buffer_too_small)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+
+    std::vector<canbus::Message> messages;
+    driver.setupJointCommandRPDOs(
+        messages, 0, canopen_master::PDOCommunicationParameters::Async()
+    );
+
+    canbus::Message buffer[1];
+    ASSERT_THROW(driver.getRPDOMessages(buffer, 1), std::invalid_argument);
+}
+
+TEST_F(DriverProcessTest, it_keeps_the_RPDO_keepalive_periods_across_setups)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+    driver.setRPDOKeepalivePeriod(base::Time::fromMilliseconds(100));
+
+    std::vector<canbus::Message> messages;
+    auto parameters = canopen_master::PDOCommunicationParameters::Async();
+    driver.setupJointCommandRPDOs(messages, 0, parameters);
+    driver.setRPDOKeepalivePeriod(1, base::Time::fromMilliseconds(20));
+    driver.setupJointCommandRPDOs(messages, 0, parameters);
+
+    base::Time start = base::Time::fromSeconds(10);
+    canbus::Message buffer[2];
+    ASSERT_EQ(2, driver.getChangedRPDOMessages(buffer, 2, start));
+    ASSERT_EQ(0, driver.getChangedRPDOMessages(
+        buffer, 2, start + base::Time::fromMilliseconds(10)
+    ));
+    ASSERT_EQ(1, driver.getChangedRPDOMessages(
+        buffer, 2, start + base::Time::fromMilliseconds(20)
+    ));
+    ASSERT_EQ(buffer[0].can_id, driver.getRPDOMessages()[1].can_id);
+}
+
+TEST_F(DriverProcessTest, it_emits_only_the_RPDOs_that_changed_or_whose_keepalive_expired)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+
+    std::vector<canbus::Message> messages;
+    driver.setupJointCommandRPDOs(
+        messages, 0, canopen_master::PDOCommunicationParameters::Async()
+    );
+    driver.setRPDOKeepalivePeriod(base::Time::fromMilliseconds(100));
+
+    base::samples::Joints command;
+    command.elements.resize(2);
+    command.elements[0].raw = 0.5;
+    command.elements[1].raw = -0.2;
+    driver.setJointCommand(command);
+
+    base::Time start = base::Time::fromSeconds(10);
+    canbus::Message buffer[2];
+    ASSERT_EQ(2, driver.getChangedRPDOMessages(buffer, 2, start));
+
+    driver.setJointCommand(command);
+    ASSERT_EQ(0, driver.getChangedRPDOMessages(
+        buffer, 2, start + base::Time::fromMilliseconds(10)
+    ));
+    ASSERT_EQ(2, driver.getSuppressedRPDOCount());
+
+    command.elements[1].raw = 0.2;
+    driver.setJointCommand(command);
+    ASSERT_EQ(1, driver.getChangedRPDOMessages(
+        buffer, 2, start + base::Time::fromMilliseconds(20)
+    ));
+    ASSERT_EQ(0x300 + NODE_ID, buffer[0].can_id);
+    ASSERT_EQ(3, driver.getSuppressedRPDOCount());
+
+    ASSERT_EQ(1, driver.getChangedRPDOMessages(
+        buffer, 2, start + base::Time::fromMilliseconds(100)
+    ));
+    ASSERT_EQ(0x200 + NODE_ID, buffer[0].can_id);
+}
+
+TEST_F(DriverProcessTest, it_rejects_joint_names_that_do_not_match_the_channels)
+{
+    driver.getChannel(0).setControlMode(CONTROL_IGNORED);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+    ASSERT_THROW(
+        driver.setJointNames(std::vector<std::string>{"a", "b"}),
+        std::invalid_argument
+    );
+
+    driver.setJointNames(std::vector<std::string>{"a"});
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    base::samples::Joints joints;
+    ASSERT_THROW(driver.readJointState(joints), std::invalid_argument);
+}
+
+TEST_F(DriverProcessTest, it_reads_the_joint_state_into_a_reused_sample)
+{
+    driver.getChannel(0).setControlMode(CONTROL_IGNORED);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+    driver.set<MotorAmps>(10, 0, 1);
+    driver.set<AppliedPowerLevel>(20, 0, 1);
+    driver.setJointNames(std::vector<std::string>{"joint"});
+
+    driver.process(make_sdo_ack(0x2100, 2), base::Time::fromMicroseconds(10));
+    driver.process(make_sdo_ack(0x2102, 2), base::Time::fromMicroseconds(30));
+
+    base::samples::Joints joints;
+    driver.readJointState(joints);
+    ASSERT_EQ(1, joints.elements.size());
+    ASSERT_EQ("joint", joints.names.at(0));
+    ASSERT_EQ(base::Time::fromMicroseconds(30), joints.time);
+    ASSERT_FLOAT_EQ(0.02, joints.elements[0].raw);
+
+    base::JointState const* elements = joints.elements.data();
+    driver.process(make_sdo_ack(0x2100, 2), base::Time::fromMicroseconds(40));
+    driver.readJointState(joints);
+    ASSERT_EQ(elements, joints.elements.data());
+    ASSERT_EQ(base::Time::fromMicroseconds(40), joints.time);
+}
+
+TEST_F(DriverProcessTest, it_packs_the_TPDOs_of_all_channels_and_features)
+{
+    driver.getChannel(0).setControlMode(CONTROL_POSITION);
+    driver.getChannel(1).setControlMode(CONTROL_POSITION);
+
+    // The unpacked setup uses two PDOs per channel and two status PDOs
+    auto planner = driver.planTPDOs(
+        DriverBase::TPDO_JOINT_STATE | DriverBase::TPDO_STATUS
+    );
+    ASSERT_EQ(5, planner.getFrameCount());
+
+    std::vector<canbus::Message> messages;
+    int next = driver.setupPackedTPDOs(
+        messages, 1, canopen_master::PDOCommunicationParameters::Async(),
+        DriverBase::TPDO_JOINT_STATE | DriverBase::TPDO_STATUS
+    );
+    ASSERT_EQ(6, next);
+}
+
+TEST_F(DriverProcessTest, it_sets_up_each_TPDO_group_at_the_rate_of_its_tier)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+
+    std::vector<canbus::Message> messages;
+    ASSERT_EQ(5, driver.setupTieredTPDOs(messages, 0, TPDORateTiers()));
+
+    auto const& pdos = driver.getConfiguredPDOs();
+    ASSERT_EQ(5, pdos.size());
+    ASSERT_EQ(1, pdos[0].parameters.sync_period);
+    ASSERT_EQ(1, pdos[1].parameters.sync_period);
+    ASSERT_EQ(10, pdos[2].parameters.sync_period);
+    ASSERT_EQ(canopen_master::PDO_ASYNCHRONOUS, pdos[3].parameters.transmission_mode);
+    ASSERT_EQ(base::Time::fromSeconds(1), pdos[4].parameters.timer_period);
+}
+
+TEST_F(DriverProcessTest, it_reports_the_age_of_the_controller_status_fields)
+{
+    driver.set<VoltageBattery>(245);
+    driver.set<StatusFlagsRaw>(0);
+    driver.set<FaultFlagsRaw>(0);
+    driver.set<VoltageInternal>(0);
+    driver.set<Voltage5V>(0);
+    driver.set<TemperatureMCU>(0);
+    for (int i = 0; i < 2; ++i) {
+        driver.set<TemperatureSensor0>(0, 0, i);
+        driver.set<ChannelStatusFlagsRaw>(0, 0, i);
+    }
+
+    driver.process(make_sdo_ack(0x210D, 2), base::Time::fromMilliseconds(10));
+    driver.process(make_sdo_ack(0x2122, 2), base::Time::fromMilliseconds(30));
+
+    auto status = driver.getControllerStatus(base::Time::fromMilliseconds(100));
+    ASSERT_EQ(base::Time::fromMilliseconds(90), status.voltage_battery_age);
+    ASSERT_EQ(base::Time::fromMilliseconds(70), status.channel_status_flags_ages[1]);
+    ASSERT_EQ(base::Time::max(), status.channel_status_flags_ages[0]);
+    ASSERT_EQ(base::Time::max(), status.voltage_internal_age);
+    ASSERT_EQ(2, status.temperature_sensor_ages.size());
+}
+
+TEST_F(DriverProcessTest, it_packs_four_analog_inputs_per_TPDO)
+{
+    for (int i = 0; i < 8; ++i) {
+        driver.setAnalogInputEnableInTPDO(i, true);
+    }
+    for (int i = 0; i < 3; ++i) {
+        driver.setConvertedAnalogInputEnableInTPDO(i, true);
+    }
+
+    std::vector<canbus::Message> messages;
+    ASSERT_EQ(3, driver.setupAnalogTPDOs(
+        messages, 0, canopen_master::PDOCommunicationParameters::Async()
+    ));
+    ASSERT_EQ(8, driver.getConfiguredPDOs()[0].size);
+    ASSERT_EQ(6, driver.getConfiguredPDOs()[2].size);
+
+    canbus::Message pdo;
+    pdo.size = 8;
+    for (int i = 0; i < 8; ++i) {
+        pdo.data[i] = i;
+    }
+    pdo.can_id = 0x180 + NODE_ID;
+    driver.process(pdo);
+    ASSERT_FALSE(driver.hasAnalogInputUpdate());
+    ASSERT_EQ(0x0302, driver.getAnalogInput(1));
+    pdo.can_id = 0x280 + NODE_ID;
+    driver.process(pdo);
+    ASSERT_TRUE(driver.hasAnalogInputUpdate());
+
+    pdo.can_id = 0x380 + NODE_ID;
+    pdo.size = 6;
+    driver.process(pdo);
+    ASSERT_TRUE(driver.hasConvertedAnalogInputUpdate());
+}
+
+TEST_F(DriverProcessTest, it_emits_only_the_PDO_setups_that_changed)
+{
+    driver.setIncrementalPDOSetup(true);
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+
+    auto sync = canopen_master::PDOCommunicationParameters::Sync(1);
+    std::vector<canbus::Message> full;
+    driver.setupJointStateTPDOs(full, 0, sync);
+    driver.setupJointCommandRPDOs(full, 0, sync);
+
+    std::vector<canbus::Message> messages;
+    driver.setupJointStateTPDOs(messages, 0, sync);
+    driver.setupJointCommandRPDOs(messages, 0, sync);
+    ASSERT_TRUE(messages.empty());
+
+    // Only the transmission type SDO of each TPDO changes
+    driver.setupJointStateTPDOs(
+        messages, 0, canopen_master::PDOCommunicationParameters::Sync(2)
+    );
+    ASSERT_EQ(2, messages.size());
+    ASSERT_EQ(0x1800, canopen_master::getSDOObjectID(messages[0]));
+    ASSERT_EQ(2, canopen_master::getSDOObjectSubID(messages[0]));
+
+    // The inhibit time can only be changed while the PDO is disabled, so
+    // changing it needs the full sequence
+    messages.clear();
+    auto inhibited = canopen_master::PDOCommunicationParameters::Sync(2);
+    inhibited.inhibit_time = base::Time::fromMilliseconds(1);
+    driver.setupJointStateTPDOs(messages, 0, inhibited);
+    int cob_id_writes = 0;
+    for (auto const& msg : messages) {
+        if (canopen_master::getSDOObjectID(msg) == 0x1800 &&
+            canopen_master::getSDOObjectSubID(msg) == 1) {
+            ++cob_id_writes;
+        }
+    }
+    ASSERT_EQ(2, cob_id_writes);
+    ASSERT_EQ(0x80, messages.front().data[7] & 0x80);
+    driver.setupJointStateTPDOs(
+        messages, 0, canopen_master::PDOCommunicationParameters::Sync(2)
+    );
+
+    // Changing the mapping of the second channel needs its full sequence
+    messages.clear();
+    driver.getChannel(1).setControlMode(CONTROL_POSITION);
+    int next = driver.setupJointStateTPDOs(
+        messages, 0, canopen_master::PDOCommunicationParameters::Sync(2)
+    );
+    ASSERT_EQ(3, next);
+    ASSERT_LT(0, messages.size());
+    for (auto const& msg : messages) {
+        ASSERT_NE(0x1800, canopen_master::getSDOObjectID(msg));
+        ASSERT_NE(0x1A00, canopen_master::getSDOObjectID(msg));
+    }
+
+    messages.clear();
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+    next = driver.setupJointStateTPDOs(
+        messages, 0, canopen_master::PDOCommunicationParameters::Sync(2)
+    );
+    driver.disablePDOsFrom(messages, true, next);
+    ASSERT_EQ(0x1802, canopen_master::getSDOObjectID(messages.back()));
+    ASSERT_EQ(0x80, messages.back().data[7] & 0x80);
+    int tpdo_count = 0;
+    for (auto const& pdo : driver.getConfiguredPDOs()) {
+        tpdo_count += pdo.transmit ? 1 : 0;
+    }
+    ASSERT_EQ(2, tpdo_count);
+}
+
+TEST_F(DriverProcessTest, it_detects_that_the_controller_already_has_the_PDO_setup)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+
+    std::vector<canbus::Message> messages;
+    auto sync = canopen_master::PDOCommunicationParameters::Sync(1);
+    driver.setupJointStateTPDOs(messages, 0, sync);
+    driver.setupJointCommandRPDOs(messages, 0, sync);
+    uint32_t fingerprint = driver.getPDOSetupFingerprint();
+    ASSERT_FALSE(driver.isPDOSetupCurrent(4));
+
+    auto download = driver.queryPDOFingerprintDownload(4);
+    ASSERT_EQ(0x2005, canopen_master::getSDOObjectID(download));
+    ASSERT_EQ(4, canopen_master::getSDOObjectSubID(download));
+    auto upload = driver.queryPDOFingerprintUpload(4);
+    ASSERT_EQ(0x2106, canopen_master::getSDOObjectID(upload));
+    ASSERT_EQ(4, canopen_master::getSDOObjectSubID(upload));
+
+    canbus::Message reply;
+    reply.can_id = NODE_ID | canopen_master::FUNCTION_SDO_TRANSMIT;
+    reply.size = 8;
+    reply.data[0] = (canopen_master::SDO_INITIATE_DOMAIN_UPLOAD << 5) | 3;
+    reply.data[1] = 0x06;
+    reply.data[2] = 0x21;
+    reply.data[3] = 4;
+    for (int i = 0; i < 4; ++i) {
+        reply.data[4 + i] = (fingerprint >> (8 * i)) & 0xFF;
+    }
+    driver.process(reply);
+    ASSERT_TRUE(driver.isPDOSetupCurrent(4));
+
+    driver.getChannel(1).setControlMode(CONTROL_POSITION);
+    messages.clear();
+    driver.setupJointStateTPDOs(messages, 0, sync);
+    ASSERT_NE(fingerprint, driver.getPDOSetupFingerprint());
+    ASSERT_FALSE(driver.isPDOSetupCurrent(4));
+}
+
+TEST_F(DriverProcessTest, it_wraps_the_PDO_setup_between_fingerprint_updates)
+{
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    driver.getChannel(1).setControlMode(CONTROL_OPEN_LOOP);
+
+    std::vector<canbus::Message> setup;
+    auto sync = canopen_master::PDOCommunicationParameters::Sync(1);
+    driver.setupJointStateTPDOs(setup, 0, sync);
+    uint32_t fingerprint = driver.getPDOSetupFingerprint();
+
+    auto messages = driver.preparePDOSetup(setup, 4);
+    ASSERT_EQ(setup.size() + 2, messages.size());
+    ASSERT_EQ(0x2005, canopen_master::getSDOObjectID(messages.front()));
+    ASSERT_EQ(4, canopen_master::getSDOObjectSubID(messages.front()));
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(0, messages.front().data[4 + i]);
+    }
+    for (size_t i = 0; i < setup.size(); ++i) {
+        ASSERT_EQ(0, std::memcmp(setup[i].data, messages[i + 1].data, 8));
+    }
+    ASSERT_EQ(0x2005, canopen_master::getSDOObjectID(messages.back()));
+    uint32_t stored;
+    std::memcpy(&stored, messages.back().data + 4, 4);
+    ASSERT_EQ(fingerprint, stored);
+
+    canbus::Message reply;
+    reply.can_id = NODE_ID | canopen_master::FUNCTION_SDO_TRANSMIT;
+    reply.size = 8;
+    reply.data[0] = (canopen_master::SDO_INITIATE_DOMAIN_UPLOAD << 5) | 3;
+    reply.data[1] = 0x06;
+    reply.data[2] = 0x21;
+    reply.data[3] = 4;
+    std::memcpy(reply.data + 4, &fingerprint, 4);
+    driver.process(reply);
+    ASSERT_TRUE(driver.preparePDOSetup(setup, 4).empty());
+}
+
+TEST_F(DriverProcessTest, it_drops_the_decoder_of_a_TPDO_whose_COB_ID_changed)
+{
+    driver.setEncoderCounterEnableInTPDO(1, true);
+    std::vector<canbus::Message> messages;
+    driver.setupEncoderTPDOs(
+        messages, 5, canopen_master::PDOCommunicationParameters::Async()
+    );
+
+    driver.setPDOCOBId(true, 5, 0x1F0);
+    driver.setupEncoderTPDOs(
+        messages, 5, canopen_master::PDOCommunicationParameters::Async()
+    );
+
+    canbus::Message pdo;
+    pdo.can_id = 0x680 + NODE_ID;
+    pdo.size = 4;
+    pdo.data[0] = 0x10;
+    pdo.data[1] = 0;
+    pdo.data[2] = 0;
+    pdo.data[3] = 0;
+    driver.process(pdo);
+    ASSERT_THROW(driver.getEncoderCounter(1), std::exception);
+
+    pdo.can_id = 0x1F0;
+    driver.process(pdo);
+    ASSERT_EQ(0x10, driver.getEncoderCounter(1));
+}
+
+TEST_F(DriverTest, it_packs_the_status_TPDOs_of_a_three_channel_controller)
+{
+    canopen_master::StateMachine canopen(1);
+    Driver driver(canopen, 3);
+
+    std::vector<canbus::Message> messages;
+    int next = driver.setupStatusTPDOs(
+        messages, 0, canopen_master::PDOCommunicationParameters::Async()
+    );
+    ASSERT_EQ(3, next);
+
+    auto const& pdos = driver.getConfiguredPDOs();
+    ASSERT_EQ(3, pdos.size());
+    int total = 0;
+    for (auto const& pdo : pdos) {
+        ASSERT_LE(pdo.size, 8);
+        total += pdo.size;
+    }
+    ASSERT_EQ(18, total);
+}
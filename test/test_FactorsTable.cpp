@@ -0,0 +1,280 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+#include <motors_roboteq_canopen/FactorsTable.hpp>
+
+using namespace motors_roboteq_canopen;
+
+struct FactorsTableTest : public ::testing::TestWithParam<SIMDLevel> {
+    // Not a multiple of the vector sizes, to exercise the scalar tail
+    static const int SIZE = 19;
+
+    std::mt19937 rng;
+    std::vector<Factors> factors;
+    FactorsTable table;
+
+    FactorsTableTest()
+        : rng(42) {
+        std::uniform_real_distribution<double> bound(0.1, 50);
+        for (int i = 0; i < SIZE; ++i) {
+            Factors f;
+            f.position_min = -bound(rng);
+            f.position_max = bound(rng);
+            f.speed_min = -bound(rng);
+            f.speed_max = bound(rng);
+            f.torque_constant = bound(rng) / 10;
+            f.max_current = bound(rng) * 2;
+            f.encoder_position_factor = bound(rng) / 1000;
+            factors.push_back(f);
+        }
+        table = FactorsTable(factors);
+        table.setSIMDLevel(GetParam());
+    }
+
+    std::vector<int32_t> relativeInputs() {
+        std::uniform_int_distribution<int32_t> dist(-1100, 1100);
+        std::vector<int32_t> values(SIZE);
+        for (auto& v : values) {
+            v = dist(rng);
+        }
+        values[0] = -1000;
+        values[1] = 1000;
+        values[2] = 0;
+        return values;
+    }
+
+    std::vector<float> siInputs(float range) {
+        std::uniform_real_distribution<float> dist(-range, range);
+        std::vector<float> values(SIZE);
+        for (auto& v : values) {
+            v = dist(rng);
+        }
+        values[0] = 0;
+        values[1] = -0.0f;
+        values[2] = 1e6;
+        values[3] = -1e6;
+        return values;
+    }
+
+    static uint32_t bits(float value) {
+        uint32_t result;
+        std::memcpy(&result, &value, sizeof(result));
+        return result;
+    }
+};
+
+TEST_P(FactorsTableTest, it_converts_relative_positions_and_speeds_like_Factors)
+{
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        auto relative = relativeInputs();
+        std::vector<float> position(SIZE), speed(SIZE);
+        table.relativePositionToSI(relative.data(), position.data());
+        table.relativeSpeedToSI(relative.data(), speed.data());
+
+        for (int i = 0; i < SIZE; ++i) {
+            ASSERT_EQ(bits(factors[i].relativePositionToSI(relative[i])), bits(position[i]));
+            ASSERT_EQ(bits(factors[i].relativeSpeedToSI(relative[i])), bits(speed[i]));
+        }
+    }
+}
+
+TEST_P(FactorsTableTest, it_converts_currents_to_torques_like_Factors)
+{
+    std::uniform_int_distribution<int16_t> dist(-32768, 32767);
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        std::vector<int16_t> current(SIZE);
+        for (auto& v : current) {
+            v = dist(rng);
+        }
+
+        std::vector<float> torque(SIZE);
+        table.currentToTorqueSI(current.data(), torque.data());
+        for (int i = 0; i < SIZE; ++i) {
+            ASSERT_EQ(bits(factors[i].currentToTorqueSI(current[i])), bits(torque[i]));
+        }
+    }
+}
+
+TEST_P(FactorsTableTest, it_converts_SI_positions_and_speeds_like_Factors)
+{
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        auto si = siInputs(60);
+        std::vector<int32_t> position(SIZE), speed(SIZE);
+        table.relativePositionFromSI(si.data(), position.data());
+        table.relativeSpeedFromSI(si.data(), speed.data());
+
+        for (int i = 0; i < SIZE; ++i) {
+            ASSERT_EQ(factors[i].relativePositionFromSI(si[i]), position[i]);
+            ASSERT_EQ(factors[i].relativeSpeedFromSI(si[i]), speed[i]);
+        }
+    }
+}
+
+TEST_P(FactorsTableTest, it_rounds_half_away_from_zero_like_Factors)
+{
+    for (int i = 0; i < SIZE; ++i) {
+        factors[i].position_min = -1000;
+        factors[i].position_max = 1000;
+    }
+    table = FactorsTable(factors);
+    table.setSIMDLevel(GetParam());
+
+    std::vector<float> si(SIZE);
+    for (int i = 0; i < SIZE; ++i) {
+        si[i] = (i - SIZE / 2) + 0.5f;
+    }
+    std::vector<int32_t> position(SIZE);
+    table.relativePositionFromSI(si.data(), position.data());
+    for (int i = 0; i < SIZE; ++i) {
+        ASSERT_EQ(factors[i].relativePositionFromSI(si[i]), position[i]);
+    }
+}
+
+TEST_P(FactorsTableTest, it_converts_SI_torques_like_Factors)
+{
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        auto torque = siInputs(200);
+        torque[2] = 0.5;
+        torque[3] = -0.5;
+        std::vector<int32_t> relative(SIZE);
+        table.relativeTorqueFromSI(torque.data(), relative.data());
+
+        for (int i = 0; i < SIZE; ++i) {
+            ASSERT_EQ(factors[i].relativeTorqueFromSI(torque[i]), relative[i]);
+        }
+    }
+}
+
+TEST_P(FactorsTableTest, it_converts_encoder_counts_power_levels_and_RPM_like_Factors)
+{
+    std::uniform_int_distribution<int32_t> encoder_dist(-100000000, 100000000);
+    std::uniform_int_distribution<int16_t> pwm_dist(-1100, 1100);
+    std::uniform_real_distribution<float> rpm_dist(-6000, 6000);
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        std::vector<int32_t> encoder(SIZE);
+        std::vector<int16_t> pwm(SIZE);
+        std::vector<float> rpm(SIZE);
+        for (int i = 0; i < SIZE; ++i) {
+            encoder[i] = encoder_dist(rng);
+            pwm[i] = pwm_dist(rng);
+            rpm[i] = rpm_dist(rng);
+        }
+
+        std::vector<float> position(SIZE), raw(SIZE), speed(SIZE);
+        table.encoderToSI(encoder.data(), position.data());
+        table.pwmToFloat(pwm.data(), raw.data());
+        table.rpmToSI(rpm.data(), speed.data());
+        for (int i = 0; i < SIZE; ++i) {
+            ASSERT_EQ(bits(factors[i].encoderToSI(encoder[i])), bits(position[i]));
+            ASSERT_EQ(bits(factors[i].pwmToFloat(pwm[i])), bits(raw[i]));
+            ASSERT_EQ(bits(factors[i].rpmToSI(rpm[i])), bits(speed[i]));
+        }
+    }
+}
+
+TEST_P(FactorsTableTest, it_converts_open_loop_commands_like_the_channels)
+{
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        auto raw = siInputs(1.2);
+        raw[2] = 0.0005;
+        raw[3] = -0.0015;
+        std::vector<int32_t> power_level(SIZE);
+        table.powerLevelFromFloat(raw.data(), power_level.data());
+
+        for (int i = 0; i < SIZE; ++i) {
+            ASSERT_EQ(Factors::clamp1000(raw[i] * 1000), power_level[i]);
+        }
+    }
+}
+
+TEST_P(FactorsTableTest, it_converts_raw_joint_states_according_to_their_units)
+{
+    std::vector<RawJointState> raw(SIZE);
+    for (int i = 0; i < SIZE; ++i) {
+        raw[i].valid = (i != 0);
+        raw[i].current = 10 * i - 50;
+        raw[i].power_level = 100 * i - 900;
+        raw[i].position = 37 * i;
+        raw[i].speed = -41 * i;
+        raw[i].position_unit = static_cast<RawJointState::Unit>(i % 3);
+        raw[i].speed_unit = (i % 2) ? RawJointState::UNIT_RPM :
+                                      RawJointState::UNIT_RELATIVE;
+    }
+    raw[5].speed_unit = RawJointState::UNIT_NONE;
+
+    std::vector<base::JointState> states(SIZE);
+    table.toJointStates(raw.data(), states.data());
+
+    ASSERT_TRUE(base::isUnknown(states[0].effort));
+    ASSERT_TRUE(base::isUnknown(states[5].speed));
+    for (int i = 1; i < SIZE; ++i) {
+        Factors const& f = factors[i];
+        ASSERT_EQ(f.currentToTorqueSI(raw[i].current), states[i].effort);
+        ASSERT_EQ(f.pwmToFloat(raw[i].power_level), states[i].raw);
+        switch (raw[i].position_unit) {
+            case RawJointState::UNIT_RELATIVE:
+                ASSERT_EQ(f.relativePositionToSI(raw[i].position), states[i].position);
+                break;
+            case RawJointState::UNIT_ENCODER:
+                ASSERT_EQ(f.encoderToSI(raw[i].position), states[i].position);
+                break;
+            default:
+                ASSERT_TRUE(base::isUnknown(states[i].position));
+        }
+        if (i == 5) {
+            continue;
+        }
+        else if (raw[i].speed_unit == RawJointState::UNIT_RPM) {
+            ASSERT_EQ(f.rpmToSI(raw[i].speed), states[i].speed);
+        }
+        else {
+            ASSERT_EQ(f.relativeSpeedToSI(raw[i].speed), states[i].speed);
+        }
+    }
+}
+
+TEST_P(FactorsTableTest, it_converts_each_command_with_its_own_conversion)
+{
+    auto values = siInputs(1.5);
+    std::vector<JointCommandConversions> conversions(SIZE);
+    std::vector<int32_t> raw(SIZE, 4242);
+    for (int i = 0; i < SIZE; ++i) {
+        conversions[i] = static_cast<JointCommandConversions>(i % 5);
+    }
+    table.fromJointCommands(conversions.data(), values.data(), raw.data());
+
+    for (int i = 0; i < SIZE; ++i) {
+        Factors const& f = factors[i];
+        switch (conversions[i]) {
+            case JOINT_COMMAND_CONVERSION_NONE:
+                ASSERT_EQ(4242, raw[i]);
+                break;
+            case JOINT_COMMAND_CONVERSION_POWER_LEVEL:
+                ASSERT_EQ(Factors::clamp1000(values[i] * 1000), raw[i]);
+                break;
+            case JOINT_COMMAND_CONVERSION_RELATIVE_SPEED:
+                ASSERT_EQ(f.relativeSpeedFromSI(values[i]), raw[i]);
+                break;
+            case JOINT_COMMAND_CONVERSION_RELATIVE_POSITION:
+                ASSERT_EQ(f.relativePositionFromSI(values[i]), raw[i]);
+                break;
+            case JOINT_COMMAND_CONVERSION_RELATIVE_TORQUE:
+                ASSERT_EQ(f.relativeTorqueFromSI(values[i]), raw[i]);
+                break;
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(
+    AllSIMDLevels, FactorsTableTest,
+    ::testing::Values(SIMD_SCALAR, SIMD_SSE41, SIMD_AVX2)
+);
+
+TEST(FactorsTableSIMDTest, it_caps_the_SIMD_level_to_what_the_CPU_supports)
+{
+    FactorsTable table;
+    table.setSIMDLevel(SIMD_AVX2);
+    ASSERT_EQ(FactorsTable::detectSIMDLevel(), table.getSIMDLevel());
+    table.setSIMDLevel(SIMD_SCALAR);
+    ASSERT_EQ(SIMD_SCALAR, table.getSIMDLevel());
+}
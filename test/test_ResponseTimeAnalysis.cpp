@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <canopen_master/SDO.hpp>
+#include <motors_roboteq_canopen/Bus.hpp>
+#include <motors_roboteq_canopen/Driver.hpp>
+#include <motors_roboteq_canopen/ResponseTimeAnalysis.hpp>
+
+using namespace motors_roboteq_canopen;
+using canopen_master::PDOCommunicationParameters;
+
+struct ResponseTimeAnalysisTest : public ::testing::Test {
+    static ScheduledFrame makeFrame(int cob_id, int size, int period_us) {
+        ScheduledFrame frame;
+        frame.cob_id = cob_id;
+        frame.size = size;
+        frame.period = base::Time::fromMicroseconds(period_us);
+        return frame;
+    }
+};
+
+TEST_F(ResponseTimeAnalysisTest, it_computes_the_worst_case_response_times)
+{
+    std::vector<ScheduledFrame> frames = {
+        makeFrame(3, 8, 10000), makeFrame(1, 8, 1000), makeFrame(2, 0, 1000)
+    };
+    auto result = computeWorstCaseResponseTimes(frames, 1000000);
+
+    // Frame 1 is only blocked by frame 3, frame 2 is blocked by frame 3 and
+    // interfered with by frame 1, frame 3 is interfered with by both
+    ASSERT_NEAR(460e-6, result[0].response_time.toSeconds(), 1e-9);
+    ASSERT_NEAR(270e-6, result[1].response_time.toSeconds(), 1e-9);
+    ASSERT_NEAR(135e-6, result[1].blocking_time.toSeconds(), 1e-9);
+    ASSERT_NEAR(325e-6, result[2].response_time.toSeconds(), 1e-9);
+    for (auto const& r : result) {
+        ASSERT_TRUE(r.schedulable);
+    }
+}
+
+TEST_F(ResponseTimeAnalysisTest, it_reports_frames_that_miss_their_deadline)
+{
+    std::vector<ScheduledFrame> frames = {
+        makeFrame(1, 8, 300), makeFrame(2, 8, 1000)
+    };
+    frames[1].deadline = base::Time::fromMicroseconds(300);
+    auto result = computeWorstCaseResponseTimes(frames, 1000000);
+    ASSERT_TRUE(result[0].schedulable);
+    ASSERT_FALSE(result[1].schedulable);
+}
+
+TEST_F(ResponseTimeAnalysisTest, it_rejects_frames_sharing_a_COB_ID)
+{
+    std::vector<ScheduledFrame> frames = {
+        makeFrame(1, 8, 1000), makeFrame(1, 2, 1000)
+    };
+    ASSERT_THROW(computeWorstCaseResponseTimes(frames, 1000000), std::invalid_argument);
+}
+
+TEST_F(ResponseTimeAnalysisTest, it_gives_the_lowest_PDO_COB_IDs_to_the_control_frames)
+{
+    Bus bus;
+    Driver& driver = bus.addDriver<Driver>(1, 1);
+    driver.getChannel(0).setControlMode(CONTROL_OPEN_LOOP);
+    std::vector<canbus::Message> messages;
+    int next = driver.setupStatusTPDOs(messages, 0, PDOCommunicationParameters::Sync(1));
+    driver.setupJointStateTPDOs(messages, next, PDOCommunicationParameters::Sync(1));
+    driver.setupJointCommandRPDOs(messages, 0, PDOCommunicationParameters::Sync(1));
+
+    BusLoadModel model;
+    model.sync_period = base::Time::fromMilliseconds(10);
+    auto frames = proposeCOBIDs(bus.getScheduledFrames(model));
+    ASSERT_EQ(5, frames.size());
+    ASSERT_EQ(0x80, frames[0].cob_id);
+    // TPDO0 and TPDO1 are status, TPDO2 joint state, RPDO0 command
+    ASSERT_EQ(0x281, frames[1].cob_id);
+    ASSERT_EQ(0x381, frames[2].cob_id);
+    ASSERT_EQ(0x201, frames[3].cob_id);
+    ASSERT_EQ(0x181, frames[4].cob_id);
+
+    messages.clear();
+    bus.applyCOBIDs(frames, messages);
+    // All four PDOs change COB-ID, they must all be disabled with their
+    // current COB-ID before any is enabled again
+    ASSERT_EQ(4, messages.size());
+    std::set<std::pair<int, int>> disabled;
+    for (auto const& msg : messages) {
+        ASSERT_EQ(1, canopen_master::getSDOObjectSubID(msg));
+        ASSERT_TRUE(msg.data[7] & 0x80);
+        disabled.insert(std::make_pair(
+            canopen_master::getSDOObjectID(msg),
+            (msg.data[5] << 8 | msg.data[4]) & 0x7FF
+        ));
+    }
+    ASSERT_EQ(1, disabled.count(std::make_pair(0x1800, 0x181)));
+    ASSERT_EQ(1, disabled.count(std::make_pair(0x1400, 0x201)));
+
+    messages.clear();
+    next = driver.setupStatusTPDOs(messages, 0, PDOCommunicationParameters::Sync(1));
+    driver.setupJointStateTPDOs(messages, next, PDOCommunicationParameters::Sync(1));
+    driver.setupJointCommandRPDOs(messages, 0, PDOCommunicationParameters::Sync(1));
+
+    bool found = false;
+    for (auto const& msg : messages) {
+        if (canopen_master::getSDOObjectID(msg) == 0x1802 &&
+            canopen_master::getSDOObjectSubID(msg) == 1) {
+            ASSERT_EQ(0x201, (msg.data[5] << 8 | msg.data[4]) & 0x7FF);
+            found = true;
+        }
+    }
+    ASSERT_TRUE(found);
+    ASSERT_EQ(0x181, driver.getRPDOMessages().at(0).can_id);
+
+    canbus::Message pdo;
+    pdo.can_id = 0x201;
+    pdo.size = 6;
+    for (int i = 0; i < 8; ++i) {
+        pdo.data[i] = 0;
+    }
+    ASSERT_EQ(&driver, bus.process(pdo));
+    ASSERT_TRUE(bus.areAllChannelsReady());
+}
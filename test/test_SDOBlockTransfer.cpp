@@ -0,0 +1,304 @@
+#include <gtest/gtest.h>
+#include <canopen_master/Functions.hpp>
+#include <motors_roboteq_canopen/SDOBlockTransfer.hpp>
+
+using namespace std;
+using namespace motors_roboteq_canopen;
+
+struct SDOBlockTransferTest : public ::testing::Test {
+    static const int NODE_ID = 2;
+    vector<canbus::Message> messages;
+
+    static vector<uint8_t> makeData(size_t size) {
+        vector<uint8_t> data;
+        for (size_t i = 0; i < size; ++i) {
+            data.push_back(i + 1);
+        }
+        return data;
+    }
+
+    static canbus::Message make_reply(vector<uint8_t> const& bytes) {
+        canbus::Message msg;
+        msg.can_id = NODE_ID | canopen_master::FUNCTION_SDO_TRANSMIT;
+        msg.size = 8;
+        std::fill(msg.data, msg.data + 8, 0);
+        std::copy(bytes.begin(), bytes.end(), msg.data);
+        return msg;
+    }
+
+    static canbus::Message make_abort(uint32_t code) {
+        return make_reply({
+            0x80, 0x00, 0x21, 0x01,
+            static_cast<uint8_t>(code), static_cast<uint8_t>(code >> 8),
+            static_cast<uint8_t>(code >> 16), static_cast<uint8_t>(code >> 24)
+        });
+    }
+
+    static canbus::Message make_segment(
+        uint8_t command, vector<uint8_t> const& data, size_t offset
+    ) {
+        vector<uint8_t> bytes = { command };
+        for (size_t i = offset; i < offset + 7; ++i) {
+            bytes.push_back(i < data.size() ? data[i] : 0);
+        }
+        return make_reply(bytes);
+    }
+
+    static uint32_t readAbortCode(canbus::Message const& msg) {
+        return msg.data[4] | (msg.data[5] << 8) | (msg.data[6] << 16) |
+               (static_cast<uint32_t>(msg.data[7]) << 24);
+    }
+};
+
+TEST_F(SDOBlockTransferTest, it_computes_the_block_transfer_crc) {
+    string data = "123456789";
+    ASSERT_EQ(0x31C3, computeSDOBlockCRC(
+        reinterpret_cast<uint8_t const*>(data.data()), data.size()
+    ));
+}
+
+TEST_F(SDOBlockTransferTest, it_downloads_an_object_in_a_single_block) {
+    auto data = makeData(20);
+    SDOBlockDownload download(NODE_ID, 0x2100, 1, data);
+    download.start(messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(NODE_ID | canopen_master::FUNCTION_SDO_RECEIVE, messages[0].can_id);
+    ASSERT_EQ(0xC6, messages[0].data[0]);
+    ASSERT_EQ(0x00, messages[0].data[1]);
+    ASSERT_EQ(0x21, messages[0].data[2]);
+    ASSERT_EQ(1, messages[0].data[3]);
+    ASSERT_EQ(20, messages[0].data[4]);
+
+    messages.clear();
+    ASSERT_TRUE(download.process(make_reply({ 0xA4, 0x00, 0x21, 0x01, 127 }), messages));
+    ASSERT_EQ(3, messages.size());
+    ASSERT_EQ(0x01, messages[0].data[0]);
+    ASSERT_EQ(0x02, messages[1].data[0]);
+    ASSERT_EQ(0x83, messages[2].data[0]);
+    ASSERT_EQ(8, messages[1].data[1]);
+    ASSERT_EQ(20, messages[2].data[6]);
+
+    messages.clear();
+    ASSERT_TRUE(download.process(make_reply({ 0xA2, 3, 127 }), messages));
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0xC5, messages[0].data[0]);
+    uint16_t crc = computeSDOBlockCRC(data.data(), data.size());
+    ASSERT_EQ(crc & 0xFF, messages[0].data[1]);
+    ASSERT_EQ(crc >> 8, messages[0].data[2]);
+    ASSERT_FALSE(download.isFinished());
+
+    messages.clear();
+    ASSERT_TRUE(download.process(make_reply({ 0xA1 }), messages));
+    ASSERT_TRUE(messages.empty());
+    ASSERT_EQ(SDO_TRANSFER_COMPLETED, download.getStatus());
+    ASSERT_EQ(SDO_PROTOCOL_BLOCK, download.getProtocol());
+}
+
+TEST_F(SDOBlockTransferTest, it_resends_the_segments_the_node_did_not_acknowledge) {
+    auto data = makeData(20);
+    SDOBlockDownload download(NODE_ID, 0x2100, 1, data);
+    download.start(messages);
+    download.process(make_reply({ 0xA4, 0x00, 0x21, 0x01, 2 }), messages);
+    messages.clear();
+
+    download.process(make_reply({ 0xA2, 1, 2 }), messages);
+    ASSERT_EQ(2, messages.size());
+    ASSERT_EQ(0x01, messages[0].data[0]);
+    ASSERT_EQ(8, messages[0].data[1]);
+    ASSERT_EQ(0x82, messages[1].data[0]);
+    ASSERT_EQ(15, messages[1].data[1]);
+}
+
+TEST_F(SDOBlockTransferTest, it_falls_back_to_a_segmented_download) {
+    auto data = makeData(10);
+    SDOBlockDownload download(NODE_ID, 0x2100, 1, data);
+    download.start(messages);
+    messages.clear();
+
+    download.process(make_abort(SDO_ABORT_INVALID_COMMAND), messages);
+    ASSERT_EQ(SDO_PROTOCOL_SEGMENTED, download.getProtocol());
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0x21, messages[0].data[0]);
+    ASSERT_EQ(10, messages[0].data[4]);
+
+    messages.clear();
+    download.process(make_reply({ 0x60, 0x00, 0x21, 0x01 }), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0x00, messages[0].data[0]);
+    ASSERT_EQ(1, messages[0].data[1]);
+
+    messages.clear();
+    download.process(make_reply({ 0x20 }), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0x10 | (4 << 1) | 1, messages[0].data[0]);
+    ASSERT_EQ(8, messages[0].data[1]);
+
+    messages.clear();
+    download.process(make_reply({ 0x30 }), messages);
+    ASSERT_TRUE(messages.empty());
+    ASSERT_EQ(SDO_TRANSFER_COMPLETED, download.getStatus());
+}
+
+TEST_F(SDOBlockTransferTest, it_falls_back_to_an_expedited_download_for_small_objects) {
+    SDOBlockDownload download(NODE_ID, 0x2100, 1, { 0x12, 0x34 });
+    download.start(messages);
+    messages.clear();
+
+    download.process(make_abort(SDO_ABORT_INVALID_COMMAND), messages);
+    ASSERT_EQ(SDO_PROTOCOL_EXPEDITED, download.getProtocol());
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0x2B, messages[0].data[0]);
+    ASSERT_EQ(0x12, messages[0].data[4]);
+    ASSERT_EQ(0x34, messages[0].data[5]);
+
+    download.process(make_reply({ 0x60, 0x00, 0x21, 0x01 }), messages);
+    ASSERT_EQ(SDO_TRANSFER_COMPLETED, download.getStatus());
+}
+
+TEST_F(SDOBlockTransferTest, it_uploads_an_object_in_blocks) {
+    auto data = makeData(10);
+    SDOBlockUpload upload(NODE_ID, 0x2100, 1, 5);
+    upload.start(messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0xA4, messages[0].data[0]);
+    ASSERT_EQ(5, messages[0].data[4]);
+
+    messages.clear();
+    ASSERT_TRUE(upload.process(
+        make_reply({ 0xC6, 0x00, 0x21, 0x01, 10 }), messages
+    ));
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0xA3, messages[0].data[0]);
+
+    messages.clear();
+    ASSERT_TRUE(upload.process(make_segment(0x01, data, 0), messages));
+    ASSERT_TRUE(messages.empty());
+    ASSERT_TRUE(upload.process(make_segment(0x82, data, 7), messages));
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0xA2, messages[0].data[0]);
+    ASSERT_EQ(2, messages[0].data[1]);
+    ASSERT_EQ(5, messages[0].data[2]);
+
+    messages.clear();
+    uint16_t crc = computeSDOBlockCRC(data.data(), data.size());
+    ASSERT_TRUE(upload.process(
+        make_reply({ 0xC1 | (4 << 2), static_cast<uint8_t>(crc),
+                     static_cast<uint8_t>(crc >> 8) }),
+        messages
+    ));
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0xA1, messages[0].data[0]);
+    ASSERT_EQ(SDO_TRANSFER_COMPLETED, upload.getStatus());
+    ASSERT_EQ(data, upload.getData());
+}
+
+TEST_F(SDOBlockTransferTest, it_acknowledges_up_to_the_last_in_order_segment) {
+    auto data = makeData(21);
+    SDOBlockUpload upload(NODE_ID, 0x2100, 1, 3);
+    upload.start(messages);
+    upload.process(make_reply({ 0xC6, 0x00, 0x21, 0x01, 21 }), messages);
+    messages.clear();
+
+    upload.process(make_segment(0x01, data, 0), messages);
+    upload.process(make_segment(0x03, data, 14), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(1, messages[0].data[1]);
+
+    messages.clear();
+    upload.process(make_segment(0x01, data, 7), messages);
+    upload.process(make_segment(0x82, data, 14), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(2, messages[0].data[1]);
+
+    uint16_t crc = computeSDOBlockCRC(data.data(), data.size());
+    upload.process(
+        make_reply({ 0xC1, static_cast<uint8_t>(crc), static_cast<uint8_t>(crc >> 8) }),
+        messages
+    );
+    ASSERT_EQ(SDO_TRANSFER_COMPLETED, upload.getStatus());
+    ASSERT_EQ(data, upload.getData());
+}
+
+TEST_F(SDOBlockTransferTest, it_aborts_an_upload_whose_crc_does_not_match) {
+    auto data = makeData(5);
+    SDOBlockUpload upload(NODE_ID, 0x2100, 1);
+    upload.start(messages);
+    upload.process(make_reply({ 0xC6, 0x00, 0x21, 0x01, 5 }), messages);
+    upload.process(make_segment(0x81, data, 0), messages);
+    messages.clear();
+
+    upload.process(make_reply({ 0xC1 | (2 << 2), 0x12, 0x34 }), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0x80, messages[0].data[0]);
+    ASSERT_EQ(SDO_ABORT_CRC_ERROR, readAbortCode(messages[0]));
+    ASSERT_EQ(SDO_TRANSFER_ABORTED, upload.getStatus());
+    ASSERT_EQ(SDO_ABORT_CRC_ERROR, upload.getAbortCode());
+}
+
+TEST_F(SDOBlockTransferTest, it_falls_back_to_a_segmented_upload) {
+    auto data = makeData(10);
+    SDOBlockUpload upload(NODE_ID, 0x2100, 1);
+    upload.start(messages);
+    messages.clear();
+
+    upload.process(make_abort(SDO_ABORT_INVALID_COMMAND), messages);
+    ASSERT_EQ(SDO_PROTOCOL_SEGMENTED, upload.getProtocol());
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0x40, messages[0].data[0]);
+
+    messages.clear();
+    upload.process(make_reply({ 0x41, 0x00, 0x21, 0x01, 10 }), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0x60, messages[0].data[0]);
+
+    messages.clear();
+    upload.process(make_segment(0x00, data, 0), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0x70, messages[0].data[0]);
+
+    messages.clear();
+    upload.process(make_segment(0x10 | (4 << 1) | 1, data, 7), messages);
+    ASSERT_TRUE(messages.empty());
+    ASSERT_EQ(SDO_TRANSFER_COMPLETED, upload.getStatus());
+    ASSERT_EQ(data, upload.getData());
+}
+
+TEST_F(SDOBlockTransferTest, it_handles_an_expedited_reply_to_the_fallback_upload) {
+    SDOBlockUpload upload(NODE_ID, 0x2100, 1);
+    upload.start(messages);
+    upload.process(make_abort(SDO_ABORT_INVALID_COMMAND), messages);
+    upload.process(make_reply({ 0x4B, 0x00, 0x21, 0x01, 0x12, 0x34 }), messages);
+    ASSERT_EQ(SDO_TRANSFER_COMPLETED, upload.getStatus());
+    ASSERT_EQ(SDO_PROTOCOL_EXPEDITED, upload.getProtocol());
+    ASSERT_EQ(vector<uint8_t>({ 0x12, 0x34 }), upload.getData());
+}
+
+TEST_F(SDOBlockTransferTest, it_reports_an_abort_received_during_the_transfer) {
+    auto data = makeData(20);
+    SDOBlockDownload download(NODE_ID, 0x2100, 1, data);
+    download.start(messages);
+    download.process(make_reply({ 0xA4, 0x00, 0x21, 0x01, 127 }), messages);
+    ASSERT_TRUE(download.process(make_abort(0x06010000), messages));
+    ASSERT_EQ(SDO_TRANSFER_ABORTED, download.getStatus());
+    ASSERT_EQ(0x06010000, download.getAbortCode());
+    ASSERT_FALSE(download.process(make_reply({ 0xA2, 3, 127 }), messages));
+}
+
+TEST_F(SDOBlockTransferTest, it_sends_an_abort_on_request) {
+    SDOBlockUpload upload(NODE_ID, 0x2100, 1);
+    upload.start(messages);
+    messages.clear();
+    upload.abort(SDO_ABORT_TIMEOUT, messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(SDO_ABORT_TIMEOUT, readAbortCode(messages[0]));
+    ASSERT_EQ(SDO_TRANSFER_ABORTED, upload.getStatus());
+
+    messages.clear();
+    upload.abort(SDO_ABORT_TIMEOUT, messages);
+    ASSERT_TRUE(messages.empty());
+}
+
+TEST_F(SDOBlockTransferTest, it_rejects_invalid_upload_block_sizes) {
+    ASSERT_THROW(SDOBlockUpload(NODE_ID, 0x2100, 1, 0), invalid_argument);
+    ASSERT_THROW(SDOBlockUpload(NODE_ID, 0x2100, 1, 128), invalid_argument);
+}
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include <canopen_master/SDO.hpp>
+#include <motors_roboteq_canopen/SDOPipeline.hpp>
+
+using namespace motors_roboteq_canopen;
+
+struct SDOPipelineTest : public ::testing::Test {
+    static const int NODE_ID = 2;
+    SDOPipeline pipeline;
+    std::vector<canbus::Message> messages;
+
+    SDOPipelineTest()
+        : pipeline(NODE_ID, ms(10), 1) {
+    }
+
+    static base::Time ms(int value) {
+        return base::Time::fromMilliseconds(value);
+    }
+
+    static canbus::Message make_sdo(int can_id, int command, int object_id, int sub_id) {
+        canbus::Message msg;
+        msg.can_id = can_id;
+        msg.size = 8;
+        msg.data[0] = (command << 5) | 2;
+        msg.data[1] = object_id & 0xFF;
+        msg.data[2] = (object_id >> 8) & 0xFF;
+        msg.data[3] = sub_id;
+        return msg;
+    }
+
+    static canbus::Message make_download(int object_id, int sub_id) {
+        return make_sdo(
+            NODE_ID | canopen_master::FUNCTION_SDO_RECEIVE,
+            canopen_master::SDO_INITIATE_DOMAIN_DOWNLOAD, object_id, sub_id
+        );
+    }
+
+    static canbus::Message make_upload(int object_id, int sub_id) {
+        return make_sdo(
+            NODE_ID | canopen_master::FUNCTION_SDO_RECEIVE,
+            canopen_master::SDO_INITIATE_DOMAIN_UPLOAD, object_id, sub_id
+        );
+    }
+
+    static canbus::Message make_reply(int command, int object_id, int sub_id) {
+        return make_sdo(
+            NODE_ID | canopen_master::FUNCTION_SDO_TRANSMIT,
+            command, object_id, sub_id
+        );
+    }
+
+    static canbus::Message make_download_ack(int object_id, int sub_id) {
+        return make_reply(
+            canopen_master::SDO_INITIATE_DOMAIN_DOWNLOAD_REPLY, object_id, sub_id
+        );
+    }
+};
+
+TEST_F(SDOPipelineTest, it_rejects_messages_that_are_not_queries_to_its_node) {
+    ASSERT_THROW(pipeline.push(make_download_ack(0x2000, 1)), std::invalid_argument);
+    auto other = make_download(0x2000, 1);
+    other.can_id = 3 | canopen_master::FUNCTION_SDO_RECEIVE;
+    ASSERT_THROW(pipeline.push(other), std::invalid_argument);
+}
+
+TEST_F(SDOPipelineTest, it_sends_one_query_at_a_time) {
+    pipeline.push({ make_download(0x2000, 1), make_download(0x2000, 2) });
+    pipeline.update(ms(0), messages);
+    pipeline.update(ms(1), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0x2000, canopen_master::getSDOObjectID(messages[0]));
+    ASSERT_EQ(1, canopen_master::getSDOObjectSubID(messages[0]));
+    ASSERT_EQ(1, pipeline.getQueuedCount());
+}
+
+TEST_F(SDOPipelineTest, it_sends_the_next_query_as_soon_as_the_reply_is_processed) {
+    pipeline.push({ make_download(0x2000, 1), make_upload(0x2100, 2) });
+    pipeline.update(ms(0), messages);
+    messages.clear();
+
+    ASSERT_TRUE(pipeline.process(make_download_ack(0x2000, 1), ms(2), messages));
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0x2100, canopen_master::getSDOObjectID(messages[0]));
+    ASSERT_EQ(0, pipeline.getQueuedCount());
+    ASSERT_FALSE(pipeline.isIdle());
+
+    messages.clear();
+    ASSERT_TRUE(pipeline.process(
+        make_reply(canopen_master::SDO_INITIATE_DOMAIN_UPLOAD, 0x2100, 2),
+        ms(5), messages
+    ));
+    ASSERT_TRUE(messages.empty());
+    ASSERT_TRUE(pipeline.isIdle());
+    ASSERT_EQ(2, pipeline.getCompletedCount());
+    ASSERT_EQ(ms(3), pipeline.getMaxLatency());
+}
+
+TEST_F(SDOPipelineTest, it_ignores_messages_that_do_not_answer_the_query_in_flight) {
+    pipeline.push(make_download(0x2000, 1));
+    pipeline.update(ms(0), messages);
+
+    ASSERT_FALSE(pipeline.process(make_download_ack(0x2000, 2), ms(1), messages));
+    ASSERT_FALSE(pipeline.process(
+        make_reply(canopen_master::SDO_INITIATE_DOMAIN_UPLOAD, 0x2000, 1),
+        ms(1), messages
+    ));
+    auto other_node = make_download_ack(0x2000, 1);
+    other_node.can_id = 3 | canopen_master::FUNCTION_SDO_TRANSMIT;
+    ASSERT_FALSE(pipeline.process(other_node, ms(1), messages));
+    ASSERT_FALSE(pipeline.isIdle());
+}
+
+TEST_F(SDOPipelineTest, it_reports_the_transaction_results) {
+    pipeline.push({ make_download(0x2000, 1), make_download(0x2000, 2) });
+    pipeline.update(ms(0), messages);
+    pipeline.process(make_download_ack(0x2000, 1), ms(3), messages);
+    pipeline.process(
+        make_reply(canopen_master::SDO_ABORT_DOMAIN_TRANSFER, 0x2000, 2),
+        ms(4), messages
+    );
+
+    SDOTransactionResult result;
+    ASSERT_TRUE(pipeline.readResult(result));
+    ASSERT_EQ(SDO_TRANSACTION_COMPLETED, result.status);
+    ASSERT_EQ(1, canopen_master::getSDOObjectSubID(result.query));
+    ASSERT_EQ(1, result.attempts);
+    ASSERT_EQ(ms(3), result.latency);
+
+    ASSERT_TRUE(pipeline.readResult(result));
+    ASSERT_EQ(SDO_TRANSACTION_ABORTED, result.status);
+    ASSERT_EQ(2, canopen_master::getSDOObjectSubID(result.query));
+    ASSERT_EQ(ms(1), result.latency);
+
+    ASSERT_FALSE(pipeline.readResult(result));
+    ASSERT_EQ(1, pipeline.getCompletedCount());
+    ASSERT_EQ(1, pipeline.getFailedCount());
+}
+
+TEST_F(SDOPipelineTest, it_resends_a_query_that_timed_out) {
+    pipeline.push(make_download(0x2000, 1));
+    pipeline.update(ms(0), messages);
+    ASSERT_EQ(ms(10), pipeline.getDeadline());
+
+    pipeline.update(ms(9), messages);
+    ASSERT_EQ(1, messages.size());
+    pipeline.update(ms(10), messages);
+    ASSERT_EQ(2, messages.size());
+    ASSERT_EQ(1, pipeline.getRetryCount());
+    ASSERT_EQ(ms(20), pipeline.getDeadline());
+
+    pipeline.process(make_download_ack(0x2000, 1), ms(12), messages);
+    SDOTransactionResult result;
+    ASSERT_TRUE(pipeline.readResult(result));
+    ASSERT_EQ(SDO_TRANSACTION_COMPLETED, result.status);
+    ASSERT_EQ(2, result.attempts);
+    ASSERT_EQ(ms(2), result.latency);
+    ASSERT_EQ(ms(12), result.duration);
+}
+
+TEST_F(SDOPipelineTest, it_moves_on_to_the_next_query_after_the_last_retry) {
+    pipeline.push({ make_download(0x2000, 1), make_download(0x2000, 2) });
+    pipeline.update(ms(0), messages);
+    pipeline.update(ms(10), messages);
+    messages.clear();
+
+    pipeline.update(ms(20), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(2, canopen_master::getSDOObjectSubID(messages[0]));
+
+    SDOTransactionResult result;
+    ASSERT_TRUE(pipeline.readResult(result));
+    ASSERT_EQ(SDO_TRANSACTION_TIMED_OUT, result.status);
+    ASSERT_EQ(2, result.attempts);
+    ASSERT_EQ(ms(20), result.duration);
+    ASSERT_EQ(1, pipeline.getFailedCount());
+}
+
+TEST_F(SDOPipelineTest, it_keeps_only_the_most_recent_results) {
+    pipeline.setMaxResults(1);
+    pipeline.push({ make_download(0x2000, 1), make_download(0x2000, 2) });
+    pipeline.update(ms(0), messages);
+    pipeline.process(make_download_ack(0x2000, 1), ms(1), messages);
+    pipeline.process(make_download_ack(0x2000, 2), ms(2), messages);
+
+    SDOTransactionResult result;
+    ASSERT_TRUE(pipeline.readResult(result));
+    ASSERT_EQ(2, canopen_master::getSDOObjectSubID(result.query));
+    ASSERT_FALSE(pipeline.readResult(result));
+}
+
+TEST_F(SDOPipelineTest, it_drops_the_pending_transactions_on_clear) {
+    pipeline.push({ make_download(0x2000, 1), make_download(0x2000, 2) });
+    pipeline.update(ms(0), messages);
+    pipeline.clear();
+    ASSERT_TRUE(pipeline.isIdle());
+    ASSERT_EQ(base::Time(), pipeline.getDeadline());
+    ASSERT_FALSE(pipeline.process(make_download_ack(0x2000, 1), ms(1), messages));
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <motors_roboteq_canopen/SPSCQueue.hpp>
+
+using namespace motors_roboteq_canopen;
+
+TEST(SPSCQueueTest, it_rounds_the_capacity_up_to_a_power_of_two) {
+    SPSCQueue<int> queue(5);
+    ASSERT_EQ(8, queue.capacity());
+}
+
+TEST(SPSCQueueTest, it_returns_the_elements_in_order) {
+    SPSCQueue<int> queue(4);
+    ASSERT_TRUE(queue.push(1));
+    ASSERT_TRUE(queue.push(2));
+
+    int value;
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(1, value);
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(2, value);
+    ASSERT_FALSE(queue.pop(value));
+}
+
+TEST(SPSCQueueTest, it_refuses_new_elements_when_full) {
+    SPSCQueue<int> queue(2);
+    ASSERT_TRUE(queue.push(1));
+    ASSERT_TRUE(queue.push(2));
+    ASSERT_FALSE(queue.push(3));
+
+    int value;
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_TRUE(queue.push(3));
+    ASSERT_EQ(2, queue.size());
+}
+
+TEST(SPSCQueueTest, it_transfers_elements_between_threads) {
+    SPSCQueue<int> queue(16);
+    int const count = 10000;
+
+    std::thread producer([&queue]() {
+        for (int i = 0; i < count; ++i) {
+            while (!queue.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int expected = 0;
+    while (expected < count) {
+        int value;
+        if (queue.pop(value)) {
+            ASSERT_EQ(expected, value);
+            ++expected;
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <motors_roboteq_canopen/Seqlock.hpp>
+
+using namespace motors_roboteq_canopen;
+
+struct SeqlockTestValue {
+    int64_t a = 0;
+    int64_t b = 0;
+    int64_t c = 0;
+};
+
+TEST(SeqlockTest, it_returns_a_zero_version_until_something_is_written) {
+    Seqlock<SeqlockTestValue> lock;
+    SeqlockTestValue value;
+    ASSERT_EQ(0, lock.read(value));
+}
+
+TEST(SeqlockTest, it_returns_the_last_written_value) {
+    Seqlock<SeqlockTestValue> lock;
+    SeqlockTestValue value;
+    value.a = 1;
+    lock.write(value);
+    value.a = 2;
+    lock.write(value);
+
+    SeqlockTestValue result;
+    ASSERT_EQ(4, lock.read(result));
+    ASSERT_EQ(2, result.a);
+}
+
+TEST(SeqlockTest, it_never_returns_a_torn_value_to_concurrent_readers) {
+    Seqlock<SeqlockTestValue> lock;
+    std::atomic<bool> done(false);
+
+    std::thread writer([&lock, &done]() {
+        for (int64_t i = 0; i < 20000; ++i) {
+            SeqlockTestValue value;
+            value.a = i;
+            value.b = i;
+            value.c = i;
+            lock.write(value);
+        }
+        done = true;
+    });
+
+    while (!done) {
+        SeqlockTestValue value;
+        lock.read(value);
+        ASSERT_EQ(value.a, value.b);
+        ASSERT_EQ(value.a, value.c);
+    }
+    writer.join();
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include <motors_roboteq_canopen/SyncScheduler.hpp>
+#include <motors_roboteq_canopen/Driver.hpp>
+
+using namespace motors_roboteq_canopen;
+
+struct SyncSchedulerTest : public ::testing::Test {
+    Bus bus;
+    Driver& driver1;
+    Driver& driver3;
+    SyncScheduler scheduler;
+    std::vector<canbus::Message> messages;
+
+    SyncSchedulerTest()
+        : driver1(bus.addDriver<Driver>(1, 1))
+        , driver3(bus.addDriver<Driver>(3, 1))
+        , scheduler(bus, ms(10), ms(4), ms(6)) {
+        setup(driver1);
+        setup(driver3);
+    }
+
+    static base::Time ms(int value) {
+        return base::Time::fromMilliseconds(value);
+    }
+
+    void setup(Driver& driver) {
+        auto& channel = driver.getChannel(0);
+        channel.setControlMode(CONTROL_SPEED);
+        std::vector<canbus::Message> setup;
+        driver.setupJointStateTPDOs(
+            setup, 0, canopen_master::PDOCommunicationParameters::Async()
+        );
+        driver.setupJointCommandRPDOs(
+            setup, 0, canopen_master::PDOCommunicationParameters::Async()
+        );
+    }
+
+    void sendJointState(int node_id, base::Time const& time) {
+        canbus::Message pdo;
+        pdo.time = time;
+        pdo.can_id = 0x180 + node_id;
+        pdo.size = 6;
+        for (int i = 0; i < 8; ++i) {
+            pdo.data[i] = 0;
+        }
+        scheduler.process(pdo, time);
+
+        pdo.can_id = 0x280 + node_id;
+        pdo.size = 4;
+        scheduler.process(pdo, time);
+    }
+};
+
+TEST_F(SyncSchedulerTest, it_rejects_a_deadline_after_the_RPDO_phase)
+{
+    ASSERT_THROW(SyncScheduler(bus, ms(10), ms(7), ms(6)), std::invalid_argument);
+    ASSERT_THROW(SyncScheduler(bus, ms(10), ms(4), ms(10)), std::invalid_argument);
+}
+
+TEST_F(SyncSchedulerTest, it_sends_a_SYNC_at_each_period)
+{
+    scheduler.update(ms(0), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(0x80, messages[0].can_id);
+    ASSERT_EQ(0, messages[0].size);
+
+    scheduler.update(ms(9), messages);
+    ASSERT_EQ(ms(10), scheduler.getNextEventTime());
+    messages.clear();
+    scheduler.update(ms(10), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(SyncScheduler::SYNC_COBID, messages[0].can_id);
+}
+
+TEST_F(SyncSchedulerTest, it_delivers_the_snapshot_as_soon_as_all_channels_reported)
+{
+    scheduler.update(ms(0), messages);
+    sendJointState(1, ms(1));
+    SyncCycle cycle;
+    ASSERT_FALSE(scheduler.readCycle(cycle));
+    sendJointState(3, ms(2));
+    ASSERT_TRUE(scheduler.readCycle(cycle));
+    ASSERT_EQ(0, cycle.stale_channels);
+    ASSERT_EQ(ms(2), cycle.snapshot_time);
+    ASSERT_EQ(ms(4), cycle.slack);
+    ASSERT_EQ(2, cycle.joints.elements.size());
+    ASSERT_FALSE(scheduler.readCycle(cycle));
+    ASSERT_EQ(0, scheduler.getMissedDeadlineCount());
+}
+
+TEST_F(SyncSchedulerTest, it_delivers_a_partial_snapshot_at_the_deadline)
+{
+    scheduler.update(ms(0), messages);
+    sendJointState(3, ms(1));
+    ASSERT_EQ(ms(4), scheduler.getNextEventTime());
+    scheduler.update(ms(4), messages);
+
+    SyncCycle cycle;
+    ASSERT_TRUE(scheduler.readCycle(cycle));
+    ASSERT_EQ(1 << bus.getChannelIndex(1, 0), cycle.stale_channels);
+    ASSERT_EQ(ms(2), cycle.slack);
+    ASSERT_EQ(1, scheduler.getMissedDeadlineCount());
+}
+
+TEST_F(SyncSchedulerTest, it_stamps_the_joints_with_the_reception_time_of_the_newest_state)
+{
+    scheduler.update(ms(0), messages);
+    sendJointState(3, ms(1));
+    sendJointState(1, ms(2));
+    scheduler.update(ms(10), messages);
+    sendJointState(3, ms(13));
+    scheduler.update(ms(14), messages);
+
+    SyncCycle cycle;
+    ASSERT_TRUE(scheduler.readCycle(cycle));
+    ASSERT_EQ(ms(14), cycle.snapshot_time);
+    ASSERT_EQ(ms(13), cycle.joints.time);
+}
+
+TEST_F(SyncSchedulerTest, it_emits_the_RPDOs_at_the_phase_offset)
+{
+    scheduler.update(ms(0), messages);
+    scheduler.update(ms(5), messages);
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(ms(6), scheduler.getNextEventTime());
+
+    scheduler.update(ms(6), messages);
+    ASSERT_EQ(1 + bus.getRPDOMessages().size(), messages.size());
+    ASSERT_EQ(ms(10), scheduler.getNextEventTime());
+
+    scheduler.update(ms(8), messages);
+    ASSERT_EQ(1 + bus.getRPDOMessages().size(), messages.size());
+    ASSERT_EQ(0, scheduler.getLateRPDOCount());
+}
+
+TEST_F(SyncSchedulerTest, it_emits_late_RPDOs_before_the_next_SYNC)
+{
+    scheduler.update(ms(0), messages);
+    messages.clear();
+    scheduler.update(ms(10), messages);
+
+    size_t rpdo_count = bus.getRPDOMessages().size();
+    ASSERT_LT(0, rpdo_count);
+    ASSERT_EQ(rpdo_count + 1, messages.size());
+    ASSERT_EQ(SyncScheduler::SYNC_COBID, messages.back().can_id);
+    ASSERT_EQ(1, scheduler.getLateRPDOCount());
+    ASSERT_EQ(0, scheduler.getSkippedCycleCount());
+}
+
+TEST_F(SyncSchedulerTest, it_counts_the_periods_skipped_by_a_late_update_and_keeps_the_RPDO_phase)
+{
+    scheduler.update(ms(0), messages);
+    scheduler.update(ms(35), messages);
+    ASSERT_EQ(2, scheduler.getSkippedCycleCount());
+    ASSERT_EQ(1, scheduler.getLateRPDOCount());
+    scheduler.update(ms(39), messages);
+    ASSERT_EQ(ms(41), scheduler.getNextEventTime());
+    scheduler.update(ms(41), messages);
+    ASSERT_EQ(ms(45), scheduler.getNextEventTime());
+}
+
+TEST_F(SyncSchedulerTest, it_handles_drivers_added_after_its_creation)
+{
+    Driver& driver5 = bus.addDriver<Driver>(5, 1);
+    setup(driver5);
+
+    scheduler.update(ms(0), messages);
+    sendJointState(1, ms(1));
+    sendJointState(3, ms(1));
+    sendJointState(5, ms(2));
+
+    SyncCycle cycle;
+    ASSERT_TRUE(scheduler.readCycle(cycle));
+    ASSERT_EQ(3, cycle.joints.elements.size());
+    ASSERT_EQ(0, cycle.stale_channels);
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <motors_roboteq_canopen/TPDOPlanner.hpp>
+#include <motors_roboteq_canopen/Exceptions.hpp>
+
+using namespace motors_roboteq_canopen;
+
+struct TPDOPlannerTest : public ::testing::Test {
+    static int mappingSize(canopen_master::PDOMapping const& mapping) {
+        int size = 0;
+        for (auto const& object : mapping.mappings) {
+            size += object.size;
+        }
+        return size;
+    }
+};
+
+TEST_F(TPDOPlannerTest, it_packs_objects_in_the_minimum_number_of_PDOs)
+{
+    TPDOPlanner planner(16);
+    for (int channel = 0; channel < 3; ++channel) {
+        planner.add(0x2100, channel + 1, 2);
+        planner.add(0x2102, channel + 1, 2);
+        planner.add(0x2122, channel + 1, 1);
+        planner.add(0x2110, channel + 1, 4);
+    }
+
+    auto mappings = planner.plan();
+    ASSERT_EQ(4, mappings.size());
+    ASSERT_EQ(4, planner.getFrameCount());
+    for (auto const& mapping : mappings) {
+        ASSERT_LE(mappingSize(mapping), TPDOPlanner::PDO_SIZE);
+    }
+    ASSERT_EQ(8, mappingSize(mappings[0]));
+    ASSERT_EQ(0x2110, mappings[0].mappings[0].objectId);
+    ASSERT_EQ(3, mappingSize(mappings[3]));
+}
+
+TEST_F(TPDOPlannerTest, it_maps_an_object_added_twice_only_once)
+{
+    TPDOPlanner planner(16);
+    planner.add(0x2100, 1, 2);
+    planner.add(0x2100, 1, 2);
+    ASSERT_EQ(1, planner.getObjectCount());
+    ASSERT_EQ(1, planner.plan().at(0).mappings.size());
+}
+
+TEST_F(TPDOPlannerTest, it_throws_if_the_objects_need_more_PDOs_than_allowed)
+{
+    TPDOPlanner planner(1);
+    planner.add(0x2110, 1, 4);
+    planner.add(0x2110, 2, 4);
+    planner.add(0x2100, 1, 2);
+    ASSERT_EQ(2, planner.getFrameCount());
+    ASSERT_THROW(planner.plan(), TooManyPDOs);
+}
+
+TEST_F(TPDOPlannerTest, it_rejects_objects_that_cannot_be_mapped)
+{
+    TPDOPlanner planner(16);
+    ASSERT_THROW(planner.add(0x2100, 1, 3), std::invalid_argument);
+}